@@ -0,0 +1,101 @@
+// Batch lookups against one query at a time: a list of ISBNs (with repeats
+// and misses) through searchByISBN() versus searchByISBNs(), and a list of
+// author queries through searchByAuthor() versus searchBatch() at several
+// thread counts. Every batch is checked against the one-at-a-time answers.
+//
+// Build and run with: make bench && ./bench_batch [books] [queries]
+
+#include "BenchCatalog.h"
+#include "utils/SearchEngine.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int bookCount = argc > 1 ? atoi(argv[1]) : 100000;
+    int queryCount = argc > 2 ? atoi(argv[2]) : 2000;
+    
+    BookBST tree;
+    srand(7);
+    fillBenchCatalog(tree, bookCount, 15, 6, 0);
+    SearchEngine engine;
+    engine.setBookTree(&tree);
+    engine.buildIndices();
+    
+    printf("books: %d, queries: %d, hardware threads: %u\n\n", bookCount, queryCount,
+           thread::hardware_concurrency());
+    
+    // One ISBN in five repeats an earlier one and one in ten is not in the catalog
+    vector<string> isbns;
+    srand(11);
+    for (int i = 0; i < queryCount * 10; i++) {
+        char isbn[32];
+        int number = rand() % 10 == 0 ? bookCount + rand() % bookCount : rand() % bookCount;
+        snprintf(isbn, sizeof(isbn), "978-%09d", number);
+        isbns.push_back(i > 0 && rand() % 5 == 0 ? isbns[rand() % i] : string(isbn));
+    }
+    
+    Clock::time_point start = Clock::now();
+    vector<Book*> single;
+    for (const string& isbn : isbns) {
+        single.push_back(engine.searchByISBN(isbn));
+    }
+    double singleMs = elapsedMs(start);
+    
+    start = Clock::now();
+    vector<Book*> batched = engine.searchByISBNs(isbns);
+    double batchMs = elapsedMs(start);
+    
+    if (batched != single) {
+        printf("MISMATCH: ISBN batch differs from single lookups\n");
+        return 1;
+    }
+    printf("%-28s | %10s | %8s\n", "ISBN lookups", "ms", "speedup");
+    printf("%-28s | %10.2f | %7.2fx\n", "searchByISBN each", singleMs, 1.0);
+    printf("%-28s | %10.2f | %7.2fx\n\n", "searchByISBNs", batchMs, singleMs / batchMs);
+    
+    // Author queries, about half of them repeats; rebuilding the index before
+    // each run bumps its generation so no run is served by an earlier one's cache
+    vector<string> authors;
+    for (int i = 0; i < queryCount; i++) {
+        authors.push_back(i > 0 && rand() % 2 == 0 ? authors[rand() % i] : randomAuthor());
+    }
+    
+    engine.buildIndices();
+    start = Clock::now();
+    vector<vector<Book*>> expected;
+    for (const string& author : authors) {
+        expected.push_back(engine.searchByAuthor(author));
+    }
+    double loopMs = elapsedMs(start);
+    
+    printf("%-28s | %10s | %8s\n", "author queries", "ms", "speedup");
+    printf("%-28s | %10.2f | %7.2fx\n", "searchByAuthor each", loopMs, 1.0);
+    
+    int threadCounts[] = {1, 2, 4, 8};
+    for (int threads : threadCounts) {
+        engine.buildIndices();
+        start = Clock::now();
+        vector<vector<Book*>> result = engine.searchBatch(SearchEngine::AUTHOR, authors, false, threads);
+        double ms = elapsedMs(start);
+        
+        if (result != expected) {
+            printf("MISMATCH: %d-thread batch differs from single queries\n", threads);
+            return 1;
+        }
+        string label = "searchBatch, " + to_string(threads) + " thread" + (threads > 1 ? "s" : "");
+        printf("%-28s | %10.2f | %7.2fx\n", label.c_str(), ms, loopMs / ms);
+    }
+    
+    return 0;
+}
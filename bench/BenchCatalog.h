@@ -0,0 +1,60 @@
+#ifndef BENCH_CATALOG_H
+#define BENCH_CATALOG_H
+
+#include "utils/BookBST.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+using namespace std;
+
+// Synthetic books shared by the benchmarks. Titles are runs of common
+// title words and authors are two names, all drawn with rand(), so a bench
+// that calls srand() first gets the same catalog on every run.
+static const char* const WORDS[] = {
+    "the", "art", "of", "computer", "programming", "data", "structures", "algorithms",
+    "modern", "design", "patterns", "effective", "concurrency", "systems", "networks",
+    "introduction", "advanced", "practical", "guide", "theory", "applied", "machine",
+    "learning", "history", "science", "engineering", "analysis", "compilers", "databases"
+};
+static const char* const NAMES[] = {
+    "donald", "knuth", "brian", "kernighan", "bjarne", "stroustrup", "robert", "martin",
+    "scott", "meyers", "thomas", "cormen", "eric", "freeman", "alfred", "aho", "ada", "grace"
+};
+static const int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+static const int NAME_COUNT = sizeof(NAMES) / sizeof(NAMES[0]);
+
+inline string randomAuthor() {
+    return string(NAMES[rand() % NAME_COUNT]) + " " + NAMES[rand() % NAME_COUNT];
+}
+
+// Book number (its ISBN is 978- and the number) with a title of 2 to
+// maxTitleWords of the first vocabulary WORDS (0 = all of them). With
+// volumeSize, each run of that many books shares a "volN" word, which grows
+// the vocabulary like a real catalog.
+inline Book* makeBenchBook(int number, int vocabulary, int maxTitleWords, int volumeSize) {
+    if (vocabulary <= 0 || vocabulary > WORD_COUNT) {
+        vocabulary = WORD_COUNT;
+    }
+    
+    string title;
+    int words = 2 + rand() % (maxTitleWords - 1);
+    for (int w = 0; w < words; w++) {
+        title += (w ? " " : "") + string(WORDS[rand() % vocabulary]);
+    }
+    if (volumeSize > 0) {
+        title += " vol" + to_string(number / volumeSize);
+    }
+    
+    string author = randomAuthor();
+    char isbn[32];
+    snprintf(isbn, sizeof(isbn), "978-%09d", number);
+    return new Book(isbn, title, author, 1 + rand() % 3);
+}
+
+inline void fillBenchCatalog(BookBST& tree, int count, int vocabulary, int maxTitleWords, int volumeSize) {
+    for (int i = 0; i < count; i++) {
+        tree.insert(makeBenchBook(i, vocabulary, maxTitleWords, volumeSize));
+    }
+}
+
+#endif
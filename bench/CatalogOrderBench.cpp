@@ -0,0 +1,138 @@
+// Catalog listing pages: copying and sorting the catalog for every view
+// against reading the page from CatalogOrder's maintained orders, and the
+// cost of keeping those orders current as copies go out and come back and
+// books are added and removed. After the updates every order is checked
+// page by page against one rebuilt from scratch.
+//
+// Build and run with: make bench && ./bench_catalog [books] [updates]
+
+#include "BenchCatalog.h"
+#include "utils/CatalogOrder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+static const int PAGE = 10;
+static const char* ORDER_NAMES[] = { "ISBN", "title", "author", "copies available" };
+
+static Book* makeBook(int number) {
+    Book* book = makeBenchBook(number, 15, 6, 0);
+    book->setAvailableCopies(rand() % (book->getQuantity() + 1));
+    return book;
+}
+
+static double elapsedUs(Clock::time_point start) {
+    return chrono::duration<double, micro>(Clock::now() - start).count();
+}
+
+// What a listing costs without maintained orders: copy, sort, take a page
+static vector<Book*> sortedPage(const vector<Book*>& books, CatalogOrder::SortKey order, size_t offset) {
+    vector<Book*> copy = books;
+    sort(copy.begin(), copy.end(), [order](const Book* a, const Book* b) {
+        switch (order) {
+            case CatalogOrder::BY_TITLE:
+                return a->getTitle() != b->getTitle() ? a->getTitle() < b->getTitle() : a->getISBN() < b->getISBN();
+            case CatalogOrder::BY_AUTHOR:
+                return a->getAuthor() != b->getAuthor() ? a->getAuthor() < b->getAuthor() : a->getISBN() < b->getISBN();
+            case CatalogOrder::BY_AVAILABLE_COPIES:
+                if (a->getAvailableCopies() != b->getAvailableCopies()) {
+                    return a->getAvailableCopies() > b->getAvailableCopies();
+                }
+                return a->getISBN() < b->getISBN();
+            default:
+                return a->getISBN() < b->getISBN();
+        }
+    });
+    offset = min(offset, copy.size());
+    return vector<Book*>(copy.begin() + offset, copy.begin() + min(copy.size(), offset + PAGE));
+}
+
+static bool sameListing(const CatalogOrder& a, const CatalogOrder& b, CatalogOrder::SortKey order, bool availableOnly) {
+    size_t count = a.getCount(availableOnly);
+    if (count != b.getCount(availableOnly)) return false;
+    for (size_t offset = 0; offset < count; offset += 1000) {
+        if (a.getPage(order, availableOnly, offset, 1000) != b.getPage(order, availableOnly, offset, 1000)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int bookCount = argc > 1 ? atoi(argv[1]) : 100000;
+    int updateCount = argc > 2 ? atoi(argv[2]) : 100000;
+    
+    srand(3);
+    vector<Book*> books;
+    for (int i = 0; i < bookCount; i++) {
+        books.push_back(makeBook(i));
+    }
+    
+    Clock::time_point start = Clock::now();
+    CatalogOrder catalog;
+    catalog.rebuild(books);
+    printf("books: %d, build: %.1f ms\n\n", bookCount, elapsedUs(start) / 1000);
+    
+    printf("%-18s | %14s | %14s | %9s\n", "page order", "sort + page us", "maintained us", "speedup");
+    for (int order = 0; order < 4; order++) {
+        CatalogOrder::SortKey key = (CatalogOrder::SortKey)order;
+        int views = 5;
+        start = Clock::now();
+        for (int i = 0; i < views; i++) {
+            sortedPage(books, key, (size_t)(rand() % bookCount));
+        }
+        double sortUs = elapsedUs(start) / views;
+        
+        int pages = 10000;
+        size_t sink = 0;
+        start = Clock::now();
+        for (int i = 0; i < pages; i++) {
+            sink += catalog.getPage(key, false, (size_t)(rand() % bookCount), PAGE).size();
+        }
+        double pageUs = elapsedUs(start) / pages;
+        if (sink == 0) printf("(empty pages)\n");
+        printf("%-18s | %14.1f | %14.2f | %8.0fx\n", ORDER_NAMES[order], sortUs, pageUs, sortUs / pageUs);
+    }
+    
+    // Loans and returns move books within the copies order and in and out of
+    // the available lists; every hundredth update replaces a book outright
+    start = Clock::now();
+    for (int i = 0; i < updateCount; i++) {
+        size_t index = rand() % books.size();
+        Book* book = books[index];
+        if (i % 100 == 99) {
+            catalog.onBookRemoved(book);
+            delete book;
+            books[index] = makeBook(bookCount + i);
+            catalog.onBookAdded(books[index]);
+        } else {
+            if (rand() % 2 == 0) {
+                book->borrowBook();
+            } else {
+                book->returnBook();
+            }
+            catalog.onCopiesChanged(book);
+        }
+    }
+    printf("\nupdates: %d, %.2f us each\n", updateCount, elapsedUs(start) / updateCount);
+    
+    CatalogOrder rebuilt;
+    rebuilt.rebuild(books);
+    for (int order = 0; order < 4; order++) {
+        for (int availableOnly = 0; availableOnly < 2; availableOnly++) {
+            if (!sameListing(catalog, rebuilt, (CatalogOrder::SortKey)order, availableOnly != 0)) {
+                printf("MISMATCH: %s order%s differs from a rebuild\n", ORDER_NAMES[order],
+                       availableOnly ? " (available only)" : "");
+                return 1;
+            }
+        }
+    }
+    printf("all orders match a rebuild (%zu books, %zu available)\n", catalog.getCount(false), catalog.getCount(true));
+    return 0;
+}
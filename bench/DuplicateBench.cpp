@@ -0,0 +1,124 @@
+// Near-duplicate detection over synthetic imports of growing size. One
+// record in ten is a variant of an earlier one (changed case, an edition
+// suffix, a dropped article, a typo or accents); the rest are distinct
+// works. Reports build and clustering time, which should grow linearly,
+// the share of variants found in their original's cluster (recall) and the
+// share of clustered pairs that really are the same work (precision).
+//
+// Build and run with: make bench && ./bench_duplicates [max records]
+
+#include "utils/DuplicateDetector.h"
+#include "Config.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+static string randomWord(int minLength, int maxLength) {
+    string word;
+    int length = minLength + rand() % (maxLength - minLength + 1);
+    for (int i = 0; i < length; i++) {
+        word += (char)('a' + rand() % 26);
+    }
+    return word;
+}
+
+static string variantOf(const string& title) {
+    string text = title;
+    switch (rand() % 5) {
+        case 0:
+            for (char& c : text) {
+                if (c >= 'a' && c <= 'z') c = (char)(c - 32);
+            }
+            return text;
+        case 1:
+            return text + " 2nd Edition";
+        case 2:
+            return "The " + text;
+        case 3: {
+            size_t at = rand() % text.size();
+            text[at] = text[at] == ' ' ? ' ' : (char)('a' + rand() % 26);
+            return text;
+        }
+        default: {
+            // Accented spellings fold back to the original letters
+            size_t at = text.find('e');
+            return at == string::npos ? text : text.substr(0, at) + "\xC3\xA9" + text.substr(at + 1);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int maxRecords = argc > 1 ? atoi(argv[1]) : 1000000;
+    
+    srand(5);
+    vector<string> vocabulary, authors;
+    for (int i = 0; i < 20000; i++) {
+        vocabulary.push_back(randomWord(3, 10));
+    }
+    for (int i = 0; i < 5000; i++) {
+        authors.push_back(randomWord(4, 8) + " " + randomWord(5, 10));
+    }
+    
+    printf("%-10s | %10s | %12s | %8s | %9s | %9s\n", "records", "total ms", "records/s", "clusters",
+           "recall", "precision");
+    
+    for (int records = maxRecords / 8; records <= maxRecords; records *= 2) {
+        vector<string> titles, names;
+        vector<int> work;
+        for (int i = 0; i < records; i++) {
+            if (i > 0 && rand() % 10 == 0) {
+                int original = rand() % i;
+                titles.push_back(variantOf(titles[original]));
+                names.push_back(names[original]);
+                work.push_back(work[original]);
+            } else {
+                string title;
+                int words = 3 + rand() % 5;
+                for (int w = 0; w < words; w++) {
+                    title += (w ? " " : "") + vocabulary[rand() % vocabulary.size()];
+                }
+                titles.push_back(title);
+                names.push_back(authors[rand() % authors.size()]);
+                work.push_back(i);
+            }
+        }
+        
+        Clock::time_point start = Clock::now();
+        DuplicateDetector detector;
+        for (int i = 0; i < records; i++) {
+            detector.add(titles[i], names[i]);
+        }
+        vector<vector<size_t>> clusters = detector.findClusters(NEAR_DUPLICATE_SIMILARITY);
+        double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+        
+        // Recall: variants sharing a cluster with their work's first record
+        vector<size_t> clusterOf(records, SIZE_MAX);
+        size_t samePairs = 0, clusteredPairs = 0;
+        for (size_t c = 0; c < clusters.size(); c++) {
+            for (size_t record : clusters[c]) {
+                clusterOf[record] = c;
+            }
+            for (size_t i = 1; i < clusters[c].size(); i++) {
+                clusteredPairs++;
+                samePairs += work[clusters[c][i]] == work[clusters[c][0]];
+            }
+        }
+        size_t variants = 0, found = 0;
+        for (int i = 0; i < records; i++) {
+            if (work[i] == i) continue;
+            variants++;
+            found += clusterOf[i] != SIZE_MAX && clusterOf[i] == clusterOf[work[i]];
+        }
+        
+        printf("%-10d | %10.0f | %12.0f | %8zu | %8.1f%% | %8.1f%%\n", records, ms, records / (ms / 1000),
+               clusters.size(), 100.0 * found / variants,
+               clusteredPairs ? 100.0 * samePairs / clusteredPairs : 100.0);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Full SearchEngine rebuild time for a synthetic catalog, single-threaded
+// and with the parallel slice/merge build at increasing thread counts.
+// Every parallel build is checked against the single-threaded one.
+//
+// Build and run with: make bench && ./bench_index [books]
+
+#include "BenchCatalog.h"
+#include "utils/SearchEngine.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+static vector<string> fingerprint(SearchEngine& engine) {
+    const char* queries[] = {"programming", "data structures", "knuth", "design OR theory", "vol42 applied"};
+    vector<string> out;
+    for (const char* query : queries) {
+        string line;
+        for (Book* book : engine.searchByKeyword(query)) {
+            line += book->getISBN() + " ";
+        }
+        out.push_back(line);
+    }
+    for (const string& term : engine.suggestCompletions("pro", 5)) {
+        out.push_back(term);
+    }
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    int bookCount = argc > 1 ? atoi(argv[1]) : 200000;
+    
+    // The whole vocabulary plus a volume word per 100 books
+    BookBST tree;
+    srand(7);
+    fillBenchCatalog(tree, bookCount, 0, 7, 100);
+    
+    SearchEngine engine;
+    engine.setBookTree(&tree);
+    
+    printf("books: %d, hardware threads: %u\n\n", bookCount, thread::hardware_concurrency());
+    printf("%-8s | %10s | %12s | %8s\n", "threads", "build ms", "books/s", "speedup");
+    
+    double baseline = 0;
+    vector<string> expected;
+    int threadCounts[] = {1, 2, 4, 8, 16};
+    
+    for (int threads : threadCounts) {
+        double best = 1e30;
+        for (int run = 0; run < 3; run++) {
+            Clock::time_point start = Clock::now();
+            engine.buildIndices(threads);
+            best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+        }
+        
+        vector<string> result = fingerprint(engine);
+        if (threads == 1) {
+            baseline = best;
+            expected = result;
+        } else if (result != expected) {
+            printf("MISMATCH: %d-thread build differs from the sequential build\n", threads);
+            return 1;
+        }
+        
+        printf("%-8d | %10.1f | %12.0f | %7.2fx\n", threads, best, bookCount / (best / 1000), baseline / best);
+    }
+    
+    size_t postingBytes, positionBytes;
+    engine.getIndexFootprint(postingBytes, positionBytes);
+    printf("\nposting lists: %.1f MB, positions: %.1f MB (%.0f%% extra)\n", postingBytes / 1048576.0,
+           positionBytes / 1048576.0, postingBytes > 0 ? 100.0 * positionBytes / postingBytes : 0.0);
+    
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Concurrent loans against one LibraryManager, the way server sessions run
+// them. Patron threads, each with its own session, race to borrow and
+// return a book with a single copy and a shared book with a few, and they
+// also search. An admin thread adds and removes books and changes copy
+// counts meanwhile, and a monitor thread keeps reading the last copy's
+// availability. The run fails if two patrons ever hold the last copy at
+// once, if availability leaves 0..quantity, if a patron exceeds the borrow
+// limit, or if the loans on record disagree with the copies on the shelf.
+//
+// Build and run with: make bench && ./bench_loans [patrons] [seconds]
+// Under ThreadSanitizer: make tsan
+
+#include "management/LibraryManager.h"
+#include "management/AuthManager.h"
+#include "Config.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+static const string LAST_COPY = "979-9-99999-000-0";
+static const string SHARED_BOOK = "979-9-99999-001-0";
+static const int SHARED_COPIES = 3;
+
+static LibraryManager* library;
+static AuthManager* auth;
+static atomic<bool> running(true);
+static atomic<int> lastCopyHolders(0);
+static atomic<long> loans(0);
+static atomic<long> failures(0);
+
+static void fail(const char* message) {
+    if (failures.fetch_add(1) < 10) {
+        printf("FAILURE: %s\n", message);
+    }
+}
+
+static void patron(int id) {
+    AuthManager::Session session;
+    AuthManager::setActiveSession(&session);
+    stringstream sink;
+    LibraryManager::setOutput(&sink);
+    
+    string username = "patron" + to_string(id);
+    {
+        RWLock::ReadGuard directory(library->getUserMap()->getLock());
+        if (!auth->loginAsUser(username, "secret1")) {
+            fail("patron could not log in");
+            return;
+        }
+    }
+    
+    srand(id + 1);
+    while (running.load()) {
+        if (library->borrowBook(LAST_COPY)) {
+            if (lastCopyHolders.fetch_add(1) != 0) {
+                fail("two patrons hold the last copy");
+            }
+            loans++;
+            this_thread::yield();
+            lastCopyHolders.fetch_sub(1);
+            if (!library->returnBook(LAST_COPY)) {
+                fail("holder could not return the last copy");
+            }
+        }
+        
+        if (rand() % 2 == 0 && library->borrowBook(SHARED_BOOK)) {
+            loans++;
+            if (!library->returnBook(SHARED_BOOK)) {
+                fail("holder could not return the shared book");
+            }
+        }
+        
+        if (rand() % 4 == 0) {
+            RWLock::ReadGuard catalog(library->getCatalogLock());
+            library->searchBooks("programming", "keyword");
+        }
+        sink.str("");
+    }
+    
+    auth->logout();
+    LibraryManager::setOutput(nullptr);
+    AuthManager::setActiveSession(nullptr);
+}
+
+static void admin() {
+    AuthManager::Session session;
+    session.role = AuthManager::ADMIN;
+    AuthManager::setActiveSession(&session);
+    stringstream sink;
+    LibraryManager::setOutput(&sink);
+    
+    int round = 0;
+    while (running.load()) {
+        char isbn[32];
+        snprintf(isbn, sizeof(isbn), "979-8-%09d", round++);
+        library->addBook(isbn, "Stress Volume " + to_string(round), "Load Tester", 1 + round % 3);
+        library->updateBookQuantity(isbn, 5);
+        library->removeBook(isbn);
+        
+        // Never below the copies on loan, which the manager rejects anyway
+        library->updateBookQuantity(SHARED_BOOK, SHARED_COPIES + round % 2);
+        sink.str("");
+    }
+    
+    library->updateBookQuantity(SHARED_BOOK, SHARED_COPIES);
+    LibraryManager::setOutput(nullptr);
+    AuthManager::setActiveSession(nullptr);
+}
+
+static void monitor() {
+    while (running.load()) {
+        RWLock::ReadGuard catalog(library->getCatalogLock());
+        Book* book = library->getBookTree()->search(LAST_COPY);
+        int available = book == nullptr ? -1 : book->getAvailableCopies();
+        if (available < 0 || available > book->getQuantity()) {
+            fail("last copy availability out of range");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int patrons = argc > 1 ? atoi(argv[1]) : 16;
+    int seconds = argc > 2 ? atoi(argv[2]) : 5;
+    
+    library = LibraryManager::getInstance();
+    auth = AuthManager::getInstance();
+    library->setAuthManager(auth);
+    auth->setUserMap(library->getUserMap());
+    
+    // Fresh in-memory catalog; nothing is loaded or saved
+    AuthManager::Session setup;
+    setup.role = AuthManager::ADMIN;
+    AuthManager::setActiveSession(&setup);
+    stringstream sink;
+    LibraryManager::setOutput(&sink);
+    for (int i = 0; i < 50; i++) {
+        char isbn[32];
+        snprintf(isbn, sizeof(isbn), "979-7-%09d", i);
+        library->addBook(isbn, "Practical Programming " + to_string(i), "Author " + to_string(i % 7), 2);
+    }
+    library->addBook(LAST_COPY, "Last Copy", "Nobody", 1);
+    library->addBook(SHARED_BOOK, "Shared Shelf", "Everybody", SHARED_COPIES);
+    for (int i = 0; i < patrons; i++) {
+        auth->registerUser("patron" + to_string(i), "secret1", "Patron " + to_string(i), "p@example.org", "");
+    }
+    LibraryManager::setOutput(nullptr);
+    AuthManager::setActiveSession(nullptr);
+    
+    printf("patrons: %d, seconds: %d\n", patrons, seconds);
+    Clock::time_point start = Clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < patrons; i++) {
+        threads.push_back(thread(patron, i));
+    }
+    threads.push_back(thread(admin));
+    threads.push_back(thread(monitor));
+    
+    this_thread::sleep_for(chrono::seconds(seconds));
+    running = false;
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    double elapsed = chrono::duration<double>(Clock::now() - start).count();
+    
+    // Every copy is either on the shelf or on some patron's list
+    int lastHeld = 0, sharedHeld = 0;
+    for (User* user : library->getUserMap()->getAllUsers()) {
+        lastHeld += user->hasBorrowedBook(LAST_COPY);
+        sharedHeld += user->hasBorrowedBook(SHARED_BOOK);
+        if (user->getBorrowedCount() > MAX_BORROW_LIMIT) {
+            fail("patron over the borrow limit");
+        }
+    }
+    Book* lastCopy = library->getBookTree()->search(LAST_COPY);
+    Book* shared = library->getBookTree()->search(SHARED_BOOK);
+    if (lastCopy->getAvailableCopies() + lastHeld != 1) {
+        fail("last copy lost or duplicated");
+    }
+    if (shared->getAvailableCopies() + sharedHeld != shared->getQuantity()) {
+        fail("shared copies lost or duplicated");
+    }
+    
+    printf("loans: %ld (%.0f/s), holders of Last Copy at the end: %d\n", loans.load(), loans.load() / elapsed,
+           lastHeld);
+    if (failures.load() > 0) {
+        printf("%ld failures\n", failures.load());
+        return 1;
+    }
+    printf("0 failures\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+// Index-build cost of text normalization: the original SearchEngine pipeline
+// (character-by-character lowercasing, substr trimming, stringstream
+// splitting) against the single-pass Tokenizer, scalar and SSE2. A second
+// table runs the Tokenizer over the same titles with accented, differently
+// cased spellings, which must fold to the same index as the ASCII ones.
+//
+// Build and run with: make bench && ./bench_tokenizer [titles]
+
+#include "utils/Tokenizer.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+typedef unordered_map<string, vector<uint32_t>> MiniIndex;
+
+// The pre-Tokenizer normalize() + tokenize() pair, kept verbatim as the baseline
+static string legacyNormalize(string str) {
+    string result = "";
+    for (char c : str) {
+        result += tolower(c);
+    }
+    
+    while (!result.empty() && result[0] == ' ') {
+        result = result.substr(1);
+    }
+    while (!result.empty() && result[result.length() - 1] == ' ') {
+        result = result.substr(0, result.length() - 1);
+    }
+    
+    return result;
+}
+
+static vector<string> legacyTokenize(string str) {
+    vector<string> tokens;
+    stringstream ss(str);
+    string token;
+    
+    while (ss >> token) {
+        tokens.push_back(token);
+    }
+    
+    return tokens;
+}
+
+static vector<string> makeTitles(int count) {
+    const char* words[] = {"The", "Art", "of", "COMPUTER", "Programming", "Data", "Structures",
+                           "Algorithms", "in", "C++", "Design", "Patterns", "Effective", "Modern",
+                           "Concurrency", "Action", "Introduction", "Systems", "Networks", "Clean"};
+    vector<string> titles;
+    titles.reserve(count);
+    srand(42);
+    
+    for (int i = 0; i < count; i++) {
+        // Imported records often carry padding and irregular spacing
+        string title(rand() % 8, ' ');
+        int wordCount = 2 + rand() % 8;
+        for (int w = 0; w < wordCount; w++) {
+            title += words[rand() % 20];
+            title += string(1 + rand() % 3, ' ');
+        }
+        title += "Vol " + to_string(i % 7);
+        title += string(rand() % 24, ' ');
+        titles.push_back(title);
+    }
+    return titles;
+}
+
+// "Programming" -> "PRÓGRAMMÍNG" style spellings, one accented vowel in three
+static vector<string> accentTitles(const vector<string>& titles) {
+    const char* accented[] = {"a", "\xC3\xA1", "e", "\xC3\xA9", "i", "\xC3\x8D", "o", "\xC3\x93", "u", "\xC3\xBC"};
+    vector<string> result;
+    result.reserve(titles.size());
+    srand(7);
+    
+    for (const string& title : titles) {
+        string text;
+        for (char c : title) {
+            const char* vowel = strchr("aeiou", tolower(c));
+            if (c != ' ' && vowel != nullptr && rand() % 3 == 0) {
+                text += accented[(vowel - "aeiou") * 2 + 1];
+            } else {
+                text += c;
+            }
+        }
+        result.push_back(text);
+    }
+    return result;
+}
+
+static double buildLegacy(const vector<string>& titles, MiniIndex& index) {
+    Clock::time_point start = Clock::now();
+    for (size_t doc = 0; doc < titles.size(); doc++) {
+        for (const string& word : legacyTokenize(legacyNormalize(titles[doc]))) {
+            index[word].push_back((uint32_t)doc);
+        }
+    }
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+static double buildTokenizer(const vector<string>& titles, MiniIndex& index, bool vectorized) {
+    Tokenizer tokenizer(vectorized);
+    string term;
+    
+    Clock::time_point start = Clock::now();
+    for (size_t doc = 0; doc < titles.size(); doc++) {
+        size_t count = tokenizer.tokenize(titles[doc]);
+        for (size_t i = 0; i < count; i++) {
+            tokenizer.tokenAt(i, term);
+            index[term].push_back((uint32_t)doc);
+        }
+    }
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int titleCount = argc > 1 ? atoi(argv[1]) : 200000;
+    const int RUNS = 5;
+    vector<string> titles = makeTitles(titleCount);
+    
+    size_t bytes = 0;
+    for (const string& title : titles) {
+        bytes += title.length();
+    }
+    
+    printf("titles: %d, text: %.1f MB, SSE2 path: %s\n\n", titleCount, bytes / 1e6,
+           Tokenizer::hasVectorPath() ? "yes" : "no");
+    
+    double best[3] = {1e30, 1e30, 1e30};
+    MiniIndex reference;
+    
+    for (int run = 0; run < RUNS; run++) {
+        MiniIndex legacy, scalar, vector;
+        best[0] = min(best[0], buildLegacy(titles, legacy));
+        best[1] = min(best[1], buildTokenizer(titles, scalar, false));
+        best[2] = min(best[2], buildTokenizer(titles, vector, true));
+        
+        if (legacy != scalar || legacy != vector) {
+            printf("MISMATCH: tokenizer output differs from the legacy pipeline\n");
+            return 1;
+        }
+    }
+    
+    const char* names[] = {"legacy normalize + stringstream", "Tokenizer (scalar)", "Tokenizer (SSE2)"};
+    printf("%-32s | %10s | %10s | %8s\n", "index build", "best ms", "MB/s", "speedup");
+    for (int i = 0; i < 3; i++) {
+        printf("%-32s | %10.2f | %10.1f | %7.2fx\n", names[i], best[i],
+               bytes / 1e3 / best[i], best[0] / best[i]);
+    }
+    
+    vector<string> accented = accentTitles(titles);
+    size_t accentedBytes = 0;
+    for (const string& title : accented) {
+        accentedBytes += title.length();
+    }
+    
+    double accentBest[2] = {1e30, 1e30};
+    for (int run = 0; run < RUNS; run++) {
+        MiniIndex ascii, scalar, vector;
+        buildTokenizer(titles, ascii, true);
+        accentBest[0] = min(accentBest[0], buildTokenizer(accented, scalar, false));
+        accentBest[1] = min(accentBest[1], buildTokenizer(accented, vector, true));
+        
+        if (ascii != scalar || ascii != vector) {
+            printf("MISMATCH: accented titles do not fold to the ASCII index\n");
+            return 1;
+        }
+    }
+    
+    printf("\naccented titles: %.1f MB\n\n", accentedBytes / 1e6);
+    printf("%-32s | %10s | %10s | %8s\n", "index build", "best ms", "MB/s", "vs ASCII");
+    for (int i = 0; i < 2; i++) {
+        printf("%-32s | %10.2f | %10.1f | %7.2fx\n", names[i + 1], accentBest[i],
+               accentedBytes / 1e3 / accentBest[i], best[i + 1] / accentBest[i]);
+    }
+    
+    return 0;
+}
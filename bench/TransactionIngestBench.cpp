@@ -0,0 +1,121 @@
+// Append throughput and publish latency of the transaction store, comparing
+// direct TransactionList::append calls (one mutex shared by every session)
+// with the lock-free TransactionIngestor ring.
+//
+// Build and run with: make bench && ./bench_ingest [eventsPerRun]
+
+#include "utils/TransactionIngestor.h"
+#include "utils/TransactionList.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+struct RunResult {
+    double eventsPerSecond;
+    double p50Micros;
+    double p99Micros;
+};
+
+static vector<Transaction*> makeEvents(int producer, int count) {
+    vector<Transaction*> events;
+    events.reserve(count);
+    for (int i = 0; i < count; i++) {
+        string userID = "U" + to_string(producer * 1000 + i % 50);
+        string isbn = "978-0-00-" + to_string(i % 500);
+        events.push_back(new Transaction(userID, isbn, i % 2 ? Transaction::RETURN : Transaction::BORROW,
+                                         "Patron " + to_string(i % 50), "Title " + to_string(i % 500)));
+    }
+    return events;
+}
+
+static RunResult runOnce(int producers, int totalEvents, bool useRing) {
+    TransactionList list;
+    TransactionIngestor ingestor(&list, 4096, 256);
+    if (useRing) {
+        ingestor.start();
+    }
+    
+    int perProducer = totalEvents / producers;
+    vector<vector<Transaction*>> events(producers);
+    vector<vector<double>> latencies(producers);
+    for (int p = 0; p < producers; p++) {
+        events[p] = makeEvents(p, perProducer);
+        latencies[p].reserve(perProducer);
+    }
+    
+    atomic<int> ready(0);
+    atomic<bool> go(false);
+    vector<thread> threads;
+    
+    for (int p = 0; p < producers; p++) {
+        threads.push_back(thread([&, p]() {
+            ready.fetch_add(1);
+            while (!go.load()) {
+                this_thread::yield();
+            }
+            for (Transaction* trans : events[p]) {
+                Clock::time_point t0 = Clock::now();
+                if (useRing) {
+                    ingestor.publish(trans);
+                } else {
+                    list.append(trans);
+                }
+                latencies[p].push_back(chrono::duration<double, micro>(Clock::now() - t0).count());
+            }
+        }));
+    }
+    
+    while (ready.load() < producers) {
+        this_thread::yield();
+    }
+    
+    Clock::time_point start = Clock::now();
+    go.store(true);
+    for (thread& t : threads) {
+        t.join();
+    }
+    if (useRing) {
+        ingestor.flush();
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    
+    vector<double> all;
+    for (const vector<double>& l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    sort(all.begin(), all.end());
+    
+    RunResult result;
+    result.eventsPerSecond = (double)list.getCount() / seconds;
+    result.p50Micros = all[all.size() / 2];
+    result.p99Micros = all[(size_t)(all.size() * 0.99)];
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int totalEvents = argc > 1 ? atoi(argv[1]) : 256000;
+    int producerCounts[] = {1, 2, 4, 8, 16, 32, 64};
+    
+    printf("events per run: %d, hardware threads: %u\n\n", totalEvents, thread::hardware_concurrency());
+    printf("%-10s | %-34s | %-34s\n", "", "TransactionList::append (mutex)", "TransactionIngestor (MPSC ring)");
+    printf("%-10s | %12s %10s %10s | %12s %10s %10s\n", 
+           "producers", "events/s", "p50 us", "p99 us", "events/s", "p50 us", "p99 us");
+    
+    for (int producers : producerCounts) {
+        RunResult direct = runOnce(producers, totalEvents, false);
+        RunResult ring = runOnce(producers, totalEvents, true);
+        printf("%-10d | %12.0f %10.2f %10.2f | %12.0f %10.2f %10.2f\n", producers,
+               direct.eventsPerSecond, direct.p50Micros, direct.p99Micros,
+               ring.eventsPerSecond, ring.p50Micros, ring.p99Micros);
+    }
+    
+    return 0;
+}
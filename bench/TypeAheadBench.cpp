@@ -0,0 +1,203 @@
+// Search-as-you-type checked against brute force, then timed. Random
+// typing sequences (with backspacing, words absent from the catalog and
+// books added or removed mid-query) are fed one keystroke at a time; after
+// every keystroke the match count and each returned book are compared with
+// a scan of the whole catalog. A second catalog of 100k books then reports
+// the average and worst keystroke latency.
+//
+// Build and run with: make bench && ./bench_typeahead [sequences]
+// For a memory-checked run, add -fsanitize=address to BENCHFLAGS.
+
+#include "BenchCatalog.h"
+#include "utils/SearchEngine.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+
+// Terms of every live book, for the brute-force side
+static map<string, set<string>> catalogTerms;
+static int nextBook = 0;
+
+static Book* makeBook() {
+    return makeBenchBook(nextBook++, 0, 6, 50);
+}
+
+static void addBook(BookBST& tree, SearchEngine& engine) {
+    Book* book = makeBook();
+    tree.insert(book);
+    engine.addBookToIndex(book);
+    
+    Tokenizer tokenizer;
+    set<string>& terms = catalogTerms[book->getISBN()];
+    string term;
+    for (const string& text : {book->getTitle(), book->getAuthor()}) {
+        size_t count = tokenizer.tokenize(text);
+        for (size_t i = 0; i < count; i++) {
+            tokenizer.tokenAt(i, term);
+            terms.insert(term);
+        }
+    }
+}
+
+static void removeBook(BookBST& tree, SearchEngine& engine) {
+    map<string, set<string>>::iterator it = catalogTerms.begin();
+    advance(it, rand() % catalogTerms.size());
+    
+    Book* book = tree.search(it->first);
+    engine.removeBookFromIndex(book);
+    tree.remove(it->first);
+    catalogTerms.erase(it);
+}
+
+// Complete words must all be terms of the book; the unfinished last word
+// must start one of them
+static bool bruteMatch(const set<string>& terms, const vector<string>& words, const string& prefix) {
+    for (const string& word : words) {
+        if (terms.count(word) == 0) return false;
+    }
+    if (prefix.empty()) return true;
+    
+    set<string>::const_iterator it = terms.lower_bound(prefix);
+    return it != terms.end() && it->compare(0, prefix.size(), prefix) == 0;
+}
+
+static void splitQuery(const string& query, vector<string>& words, string& prefix) {
+    words.clear();
+    prefix.clear();
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t end = query.find(' ', start);
+        if (end == string::npos) {
+            prefix = query.substr(start);
+            break;
+        }
+        if (end > start) words.push_back(query.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+// Words of a random live book, sometimes with one that is in no book
+static string targetQuery() {
+    map<string, set<string>>::iterator it = catalogTerms.begin();
+    advance(it, rand() % catalogTerms.size());
+    vector<string> terms(it->second.begin(), it->second.end());
+    
+    string query;
+    int words = 1 + rand() % 3;
+    for (int w = 0; w < words; w++) {
+        string word = rand() % 10 == 0 ? "zzq" + to_string(rand() % 100) : terms[rand() % terms.size()];
+        query += (w ? " " : "") + word;
+    }
+    return query;
+}
+
+static bool checkSequences(int sequences, long& keystrokes) {
+    BookBST tree;
+    SearchEngine engine;
+    engine.setBookTree(&tree);
+    for (int i = 0; i < 2000; i++) {
+        addBook(tree, engine);
+    }
+    
+    vector<string> words;
+    string prefix;
+    keystrokes = 0;
+    
+    for (int s = 0; s < sequences; s++) {
+        string target = targetQuery();
+        string query;
+        
+        while (query != target) {
+            if (!query.empty() && rand() % 5 == 0) {
+                query.erase(query.size() - min(query.size(), (size_t)(1 + rand() % 3)));
+            } else if (target.compare(0, query.size(), query) == 0) {
+                query += target[query.size()];
+            } else {
+                query.erase(query.size() - 1);
+            }
+            
+            // Index changes mid-query must invalidate the remembered steps
+            if (rand() % 40 == 0) {
+                if (rand() % 2) {
+                    addBook(tree, engine);
+                } else {
+                    removeBook(tree, engine);
+                }
+            }
+            
+            size_t matchCount;
+            vector<Book*> books = engine.searchAsYouType(query, 10, matchCount);
+            keystrokes++;
+            
+            splitQuery(query, words, prefix);
+            size_t expected = 0;
+            for (const pair<const string, set<string>>& entry : catalogTerms) {
+                if (bruteMatch(entry.second, words, prefix)) expected++;
+            }
+            if (words.empty() && prefix.empty()) expected = 0;
+            
+            bool ok = matchCount == expected && books.size() == min(expected, (size_t)10);
+            for (Book* book : books) {
+                map<string, set<string>>::iterator it = catalogTerms.find(book->getISBN());
+                if (it == catalogTerms.end() || !bruteMatch(it->second, words, prefix)) ok = false;
+            }
+            if (!ok) {
+                printf("MISMATCH at sequence %d, query \"%s\": %zu matches, %zu returned, expected %zu\n",
+                       s, query.c_str(), matchCount, books.size(), expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void timeKeystrokes(int bookCount, int sequences) {
+    catalogTerms.clear();
+    BookBST tree;
+    SearchEngine engine;
+    engine.setBookTree(&tree);
+    for (int i = 0; i < bookCount; i++) {
+        tree.insert(makeBook());
+    }
+    engine.buildIndices();
+    
+    double total = 0, worst = 0;
+    long keystrokes = 0;
+    for (int s = 0; s < sequences; s++) {
+        string target = string(WORDS[rand() % WORD_COUNT]) + " " + NAMES[rand() % NAME_COUNT];
+        for (size_t length = 1; length <= target.size(); length++) {
+            size_t matchCount;
+            Clock::time_point start = Clock::now();
+            engine.searchAsYouType(target.substr(0, length), 10, matchCount);
+            double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+            total += ms;
+            worst = max(worst, ms);
+            keystrokes++;
+        }
+    }
+    
+    printf("%d books: %ld keystrokes, average %.3f ms, worst %.2f ms\n", bookCount, keystrokes,
+           total / keystrokes, worst);
+}
+
+int main(int argc, char* argv[]) {
+    int sequences = argc > 1 ? atoi(argv[1]) : 1600;
+    
+    srand(11);
+    long keystrokes;
+    if (!checkSequences(sequences, keystrokes)) {
+        return 1;
+    }
+    printf("%d sequences, %ld keystrokes: 0 mismatches against brute force\n", sequences, keystrokes);
+    
+    timeKeystrokes(100000, 200);
+    return 0;
+}
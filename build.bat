@@ -25,6 +25,7 @@ echo [2/4] Creating output directories...
 if not exist obj mkdir obj
 if not exist obj\entities mkdir obj\entities
 if not exist obj\management mkdir obj\management
+if not exist obj\server mkdir obj\server
 if not exist obj\utils mkdir obj\utils
 if not exist data mkdir data
 echo Directories created.
@@ -45,6 +46,10 @@ echo Compiling Transaction.cpp...
 g++ -std=c++11 -Wall -Wextra -c src\entities\Transaction.cpp -o obj\entities\Transaction.o
 if %errorlevel% neq 0 goto :compile_error
 
+echo Compiling Author.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\entities\Author.cpp -o obj\entities\Author.o
+if %errorlevel% neq 0 goto :compile_error
+
 REM Compile management classes
 echo Compiling LibraryManager.cpp...
 g++ -std=c++11 -Wall -Wextra -c src\management\LibraryManager.cpp -o obj\management\LibraryManager.o
@@ -54,6 +59,11 @@ echo Compiling AuthManager.cpp...
 g++ -std=c++11 -Wall -Wextra -c src\management\AuthManager.cpp -o obj\management\AuthManager.o
 if %errorlevel% neq 0 goto :compile_error
 
+REM Compile server
+echo Compiling LibraryServer.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\server\LibraryServer.cpp -o obj\server\LibraryServer.o
+if %errorlevel% neq 0 goto :compile_error
+
 REM Compile utility classes
 echo Compiling BookBST.cpp...
 g++ -std=c++11 -Wall -Wextra -c src\utils\BookBST.cpp -o obj\utils\BookBST.o
@@ -75,6 +85,74 @@ echo Compiling FileHandler.cpp...
 g++ -std=c++11 -Wall -Wextra -c src\utils\FileHandler.cpp -o obj\utils\FileHandler.o
 if %errorlevel% neq 0 goto :compile_error
 
+echo Compiling StringPool.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\StringPool.cpp -o obj\utils\StringPool.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling CirculationStats.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\CirculationStats.cpp -o obj\utils\CirculationStats.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling TransactionQueue.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\TransactionQueue.cpp -o obj\utils\TransactionQueue.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling TransactionIngestor.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\TransactionIngestor.cpp -o obj\utils\TransactionIngestor.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling TransactionArchive.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\TransactionArchive.cpp -o obj\utils\TransactionArchive.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling PrefixDictionary.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\PrefixDictionary.cpp -o obj\utils\PrefixDictionary.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling TrigramIndex.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\TrigramIndex.cpp -o obj\utils\TrigramIndex.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling Tokenizer.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\Tokenizer.cpp -o obj\utils\Tokenizer.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling RoaringBitmap.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\RoaringBitmap.cpp -o obj\utils\RoaringBitmap.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling QueryCache.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\QueryCache.cpp -o obj\utils\QueryCache.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling IndexSegment.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\IndexSegment.cpp -o obj\utils\IndexSegment.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling FacetIndex.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\FacetIndex.cpp -o obj\utils\FacetIndex.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling CaseFolder.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\CaseFolder.cpp -o obj\utils\CaseFolder.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling DuplicateDetector.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\DuplicateDetector.cpp -o obj\utils\DuplicateDetector.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling AuthorRegistry.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\AuthorRegistry.cpp -o obj\utils\AuthorRegistry.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling CatalogOrder.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\CatalogOrder.cpp -o obj\utils\CatalogOrder.o
+if %errorlevel% neq 0 goto :compile_error
+
+echo Compiling RWLock.cpp...
+g++ -std=c++11 -Wall -Wextra -c src\utils\RWLock.cpp -o obj\utils\RWLock.o
+if %errorlevel% neq 0 goto :compile_error
+
 REM Compile main
 echo Compiling main.cpp...
 g++ -std=c++11 -Wall -Wextra -c src\main.cpp -o obj\main.o
@@ -82,7 +160,7 @@ if %errorlevel% neq 0 goto :compile_error
 
 echo.
 echo [4/4] Linking executable...
-g++ -std=c++11 -Wall -Wextra -o library_system.exe obj\main.o obj\entities\Book.o obj\entities\User.o obj\entities\Transaction.o obj\management\LibraryManager.o obj\management\AuthManager.o obj\utils\BookBST.o obj\utils\UserHashMap.o obj\utils\TransactionList.o obj\utils\SearchEngine.o obj\utils\FileHandler.o
+g++ -std=c++11 -Wall -Wextra -o library_system.exe obj\main.o obj\entities\Book.o obj\entities\User.o obj\entities\Transaction.o obj\entities\Author.o obj\management\LibraryManager.o obj\management\AuthManager.o obj\server\LibraryServer.o obj\utils\BookBST.o obj\utils\UserHashMap.o obj\utils\TransactionList.o obj\utils\SearchEngine.o obj\utils\FileHandler.o obj\utils\StringPool.o obj\utils\CirculationStats.o obj\utils\TransactionQueue.o obj\utils\TransactionIngestor.o -pthread obj\utils\TransactionArchive.o obj\utils\PrefixDictionary.o obj\utils\TrigramIndex.o obj\utils\Tokenizer.o obj\utils\RoaringBitmap.o obj\utils\QueryCache.o obj\utils\IndexSegment.o obj\utils\FacetIndex.o obj\utils\CaseFolder.o obj\utils\DuplicateDetector.o obj\utils\AuthorRegistry.o obj\utils\CatalogOrder.o obj\utils\RWLock.o
 
 if %errorlevel% neq 0 goto :link_error
 
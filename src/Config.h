@@ -18,11 +18,26 @@ const string DATA_DIR = "data/";
 const string BOOKS_FILE = DATA_DIR + "books.txt";
 const string USERS_FILE = DATA_DIR + "users.txt";
 const string TRANSACTIONS_FILE = DATA_DIR + "transactions.txt";
+const string STATISTICS_FILE = DATA_DIR + "statistics.txt";
+const string HISTORY_DIR = DATA_DIR + "history/";
+const string INDEX_DIR = DATA_DIR + "index/";
 
 // Hash table configuration
 const int INITIAL_HASH_TABLE_SIZE = 101;
 const double MAX_LOAD_FACTOR = 0.75;
 
+// Transaction ingestion ring
+const int TRANSACTION_QUEUE_CAPACITY = 4096;
+const int TRANSACTION_BATCH_SIZE = 256;
+
+// Transaction history tiering: the most recent HOT_TRANSACTION_WINDOW
+// transactions stay in memory, older ones move to on-disk segments, each
+// with a key filter of this many bits per user and ISBN (about 1% false
+// positives at 10)
+const int HOT_TRANSACTION_WINDOW = 1000;
+const int HISTORY_SEGMENT_SIZE = 1000;
+const int ARCHIVE_FILTER_BITS_PER_KEY = 10;
+
 // Delimiters for file parsing
 const char CSV_DELIMITER = ',';
 const char LIST_DELIMITER = ';';
@@ -31,4 +46,55 @@ const char LIST_DELIMITER = ';';
 const int BOOKS_PER_PAGE = 10;
 const int RECENT_TRANSACTIONS_COUNT = 20;
 
+// Autocomplete
+const int SUGGESTION_COUNT = 5;
+const int PREFIX_EXPANSION_LIMIT = 64;
+
+// Typo-tolerant search (words of 4 letters or fewer allow a single edit)
+const int FUZZY_MAX_DISTANCE = 2;
+
+// Relevance ranking (BM25)
+const int MAX_SEARCH_RESULTS = 100;
+const double BM25_K1 = 1.2;
+const double BM25_B = 0.75;
+const double TITLE_BOOST = 2.0;
+const double AUTHOR_BOOST = 1.0;
+
+// Faceted search: values listed per facet, most common first
+const int FACET_VALUE_LIMIT = 5;
+
+// Near-duplicate titles: minimum estimated similarity (0-1) of title/author shingles
+const double NEAR_DUPLICATE_SIMILARITY = 0.6;
+
+// Cached search results (entries, least recently used evicted first)
+const int QUERY_CACHE_CAPACITY = 256;
+
+// Full index rebuilds use one thread per slice of at least this many books
+const int INDEX_BUILD_MIN_SLICE = 2048;
+
+// Batch searches use one thread per this many distinct text queries
+const int BATCH_QUERIES_PER_THREAD = 8;
+
+// Segmented index: documents per in-memory segment before it is sealed, and
+// how many similar-sized segments are merged at once
+const int MUTABLE_SEGMENT_DOCS = 1024;
+const int SEGMENT_MERGE_FACTOR = 4;
+
+// Removed books' document IDs are reclaimed by re-indexing the live books
+// once this percentage of all document IDs is dead
+const int INDEX_COMPACT_DEAD_PERCENT = 25;
+
+// Server mode: listen address ("host:port", or "unix:" and a socket path),
+// request worker threads (0 = one per core), longest request line accepted,
+// requests and response bytes a connection may have waiting before the
+// server stops reading from it, seconds between saves while changes are
+// unsaved, and the separator between a request's fields
+const string SERVER_ADDRESS = "127.0.0.1:7070";
+const int SERVER_WORKER_THREADS = 0;
+const int SERVER_MAX_REQUEST_LENGTH = 4096;
+const int SERVER_MAX_PENDING_REQUESTS = 64;
+const int SERVER_MAX_PENDING_OUTPUT = 1 << 20;
+const int SERVER_SAVE_INTERVAL = 5;
+const char PROTOCOL_DELIMITER = '|';
+
 #endif
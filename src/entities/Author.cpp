@@ -0,0 +1,16 @@
+#include "Author.h"
+#include <sstream>
+
+Author::Author(uint32_t authorID, string name, string sortKey)
+    : authorID(authorID), name(name), sortKey(sortKey) {}
+
+uint32_t Author::getAuthorID() const { return authorID; }
+string Author::getName() const { return name; }
+const string& Author::getSortKey() const { return sortKey; }
+
+string Author::toString() const {
+    stringstream ss;
+    ss << "Author ID: " << authorID << "\n"
+       << "Name: " << name;
+    return ss.str();
+}
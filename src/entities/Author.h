@@ -0,0 +1,28 @@
+#ifndef AUTHOR_H
+#define AUTHOR_H
+
+#include <string>
+#include <cstdint>
+using namespace std;
+
+// One person credited on books, shared by every book that credits them.
+// Authors are created by AuthorRegistry, which hands out the IDs.
+class Author {
+private:
+    uint32_t authorID;
+    string name;
+    string sortKey;     // folded surname first, e.g. "knuth donald"
+
+public:
+    Author(uint32_t authorID, string name, string sortKey);
+    
+    // Getters
+    uint32_t getAuthorID() const;
+    string getName() const;
+    const string& getSortKey() const;
+    
+    // Utility
+    string toString() const;
+};
+
+#endif
@@ -1,36 +1,94 @@
 #include "Book.h"
 #include "../Config.h"
+#include "../utils/AuthorRegistry.h"
 #include <sstream>
 #include <iomanip>
 
-Book::Book() : isbn(""), title(""), author(""), quantity(0), availableCopies(0) {}
+Book::Book() : isbn(""), title(""), authorListID(0), quantity(0), availableCopies(0), observer(nullptr) {}
 
 Book::Book(string isbn, string title, string author, int quantity) 
-    : isbn(isbn), title(title), author(author), quantity(quantity), availableCopies(quantity) {}
+    : isbn(isbn), title(title), authorListID(AuthorRegistry::getInstance()->internList(author)),
+      quantity(quantity), availableCopies(quantity), observer(nullptr) {}
+
+Book::Book(const Book& other)
+    : isbn(other.isbn), title(other.title), authorListID(other.authorListID), quantity(other.quantity),
+      availableCopies(other.getAvailableCopies()), editionOf(other.editionOf), handle(other.handle),
+      observer(other.observer) {}
+
+Book& Book::operator=(const Book& other) {
+    isbn = other.isbn;
+    title = other.title;
+    authorListID = other.authorListID;
+    quantity = other.quantity;
+    availableCopies = other.getAvailableCopies();
+    editionOf = other.editionOf;
+    handle = other.handle;
+    observer = other.observer;
+    return *this;
+}
 
 string Book::getISBN() const { return isbn; }
 string Book::getTitle() const { return title; }
-string Book::getAuthor() const { return author; }
+string Book::getAuthor() const { return AuthorRegistry::getInstance()->formatList(authorListID); }
+uint32_t Book::getAuthorListID() const { return authorListID; }
+const vector<uint32_t>& Book::getAuthorIDs() const { return AuthorRegistry::getInstance()->getList(authorListID); }
 bool Book::getAvailability() const { return availableCopies > 0; }
 int Book::getQuantity() const { return quantity; }
 int Book::getAvailableCopies() const { return availableCopies; }
+string Book::getEditionOf() const { return editionOf; }
+Handle Book::getHandle() const { return handle; }
+
+void Book::setTitle(string newTitle) {
+    title = newTitle;
+}
+
+void Book::setAuthor(string newAuthor) {
+    authorListID = AuthorRegistry::getInstance()->internList(newAuthor);
+}
 
 void Book::setQuantity(int qty) { 
+    bool wasAvailable = getAvailability();
+    bool changed = qty != quantity;
     quantity = qty; 
     if (availableCopies > quantity) {
         availableCopies = quantity;
     }
+    notifyIfAvailabilityChanged(wasAvailable);
+    if (changed && observer != nullptr) {
+        observer->onQuantityChanged(this);
+    }
 }
 
 void Book::setAvailableCopies(int copies) { 
     if (copies <= quantity && copies >= 0) {
+        bool wasAvailable = getAvailability();
         availableCopies = copies; 
+        notifyIfAvailabilityChanged(wasAvailable);
+    }
+}
+
+void Book::setEditionOf(string primaryISBN) {
+    editionOf = primaryISBN;
+}
+
+void Book::setObserver(BookObserver* bookObserver) {
+    observer = bookObserver;
+}
+
+void Book::setHandle(Handle slotHandle) {
+    handle = slotHandle;
+}
+
+void Book::notifyIfAvailabilityChanged(bool wasAvailable) {
+    if (observer != nullptr && wasAvailable != getAvailability()) {
+        observer->onAvailabilityChanged(this, !wasAvailable);
     }
 }
 
 bool Book::borrowBook() {
     if (availableCopies > 0) {
         availableCopies--;
+        notifyIfAvailabilityChanged(true);
         return true;
     }
     return false;
@@ -38,7 +96,9 @@ bool Book::borrowBook() {
 
 bool Book::returnBook() {
     if (availableCopies < quantity) {
+        bool wasAvailable = getAvailability();
         availableCopies++;
+        notifyIfAvailabilityChanged(wasAvailable);
         return true;
     }
     return false;
@@ -48,10 +108,13 @@ string Book::toString() const {
     stringstream ss;
     ss << "ISBN: " << isbn << "\n"
        << "Title: " << title << "\n"
-       << "Author: " << author << "\n"
+       << (getAuthorIDs().size() > 1 ? "Authors: " : "Author: ") << getAuthor() << "\n"
        << "Quantity: " << quantity << "\n"
-       << "Available: " << availableCopies << "\n"
-       << "Status: " << (availableCopies > 0 ? "Available" : "Not Available");
+       << "Available: " << getAvailableCopies() << "\n"
+       << "Status: " << (getAvailability() ? "Available" : "Not Available");
+    if (!editionOf.empty()) {
+        ss << "\nEdition Of: " << editionOf;
+    }
     return ss.str();
 }
 
@@ -59,24 +122,28 @@ string Book::toFileString() const {
     stringstream ss;
     ss << isbn << CSV_DELIMITER 
        << title << CSV_DELIMITER 
-       << author << CSV_DELIMITER 
+       << getAuthor() << CSV_DELIMITER 
        << quantity << CSV_DELIMITER 
-       << availableCopies;
+       << getAvailableCopies() << CSV_DELIMITER 
+       << editionOf;
     return ss.str();
 }
 
 Book Book::fromFileString(string line) {
     stringstream ss(line);
-    string isbn, title, author, qtyStr, availStr;
+    string isbn, title, author, qtyStr, availStr, editionOf;
     
     getline(ss, isbn, CSV_DELIMITER);
     getline(ss, title, CSV_DELIMITER);
     getline(ss, author, CSV_DELIMITER);
     getline(ss, qtyStr, CSV_DELIMITER);
     getline(ss, availStr, CSV_DELIMITER);
+    // Missing in files written before editions could be linked
+    getline(ss, editionOf, CSV_DELIMITER);
     
     Book book(isbn, title, author, stoi(qtyStr));
     book.setAvailableCopies(stoi(availStr));
+    book.setEditionOf(editionOf);
     
     return book;
 }
@@ -2,31 +2,67 @@
 #define BOOK_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include "../utils/SlotTable.h"
 using namespace std;
 
+class Book;
+
+// Notified when a book moves between having no copies on the shelf and
+// having at least one, and when its total number of copies changes
+class BookObserver {
+public:
+    virtual ~BookObserver() {}
+    virtual void onAvailabilityChanged(Book* book, bool available) = 0;
+    virtual void onQuantityChanged(Book* book) = 0;
+};
+
 class Book {
 private:
     string isbn;
     string title;
-    string author;
+    uint32_t authorListID;  // interned in AuthorRegistry
     int quantity;
-    int availableCopies;
+    // Loans change it under the book's lock while listings read it freely
+    atomic<int> availableCopies;
+    string editionOf;   // ISBN of the edition this one is linked to, if any
+    Handle handle;      // slot in the owning BookBST's table
+    BookObserver* observer;
+    
+    void notifyIfAvailabilityChanged(bool wasAvailable);
 
 public:
     Book();
+    // Several authors are separated by LIST_DELIMITER, e.g. "Kernighan; Ritchie"
     Book(string isbn, string title, string author, int quantity);
+    Book(const Book& other);
+    Book& operator=(const Book& other);
     
     // Getters
     string getISBN() const;
     string getTitle() const;
+    // Author names joined by "; "
     string getAuthor() const;
+    uint32_t getAuthorListID() const;
+    const vector<uint32_t>& getAuthorIDs() const;
     bool getAvailability() const;
     int getQuantity() const;
     int getAvailableCopies() const;
+    string getEditionOf() const;
+    Handle getHandle() const;
     
     // Setters
+    // Title and author edits keep the book's identity; indexes over those
+    // fields must drop the book before and re-add it after
+    void setTitle(string newTitle);
+    void setAuthor(string newAuthor);
     void setQuantity(int qty);
     void setAvailableCopies(int copies);
+    void setEditionOf(string primaryISBN);
+    void setObserver(BookObserver* bookObserver);
+    void setHandle(Handle slotHandle);
     
     // Business Logic
     bool borrowBook();
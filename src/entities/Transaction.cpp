@@ -1,50 +1,59 @@
 #include "Transaction.h"
 #include "../Config.h"
+#include "../utils/StringPool.h"
 #include <sstream>
 #include <iomanip>
-#include <ctime>
+#include <cstdio>
+#include <cstdlib>
 
-int Transaction::transactionCounter = 1;
+atomic<uint64_t> Transaction::transactionCounter(1);
 
 Transaction::Transaction() 
-    : transactionID(""), userID(""), isbn(""), type(""), 
-      timestamp(""), userName(""), bookTitle("") {}
+    : transactionID(0), userID(""), isbn(""), type(BORROW), 
+      timestamp(0), userNameSymbol(0), bookTitleSymbol(0) {}
 
-Transaction::Transaction(string userID, string isbn, string type, string userName, string bookTitle)
-    : userID(userID), isbn(isbn), type(type), userName(userName), bookTitle(bookTitle) {
+Transaction::Transaction(string userID, string isbn, Type type, string userName, string bookTitle)
+    : userID(userID), isbn(isbn), type(type) {
+    StringPool* pool = StringPool::getInstance();
+    userNameSymbol = pool->intern(userName);
+    bookTitleSymbol = pool->intern(bookTitle);
     transactionID = generateID();
     timestamp = generateTimestamp();
 }
 
-string Transaction::getTransactionID() const { return transactionID; }
+uint64_t Transaction::getID() const { return transactionID; }
 string Transaction::getUserID() const { return userID; }
 string Transaction::getISBN() const { return isbn; }
-string Transaction::getType() const { return type; }
-string Transaction::getTimestamp() const { return timestamp; }
-string Transaction::getUserName() const { return userName; }
-string Transaction::getBookTitle() const { return bookTitle; }
+Transaction::Type Transaction::getType() const { return type; }
+time_t Transaction::getTime() const { return timestamp; }
+string Transaction::getUserName() const { return StringPool::getInstance()->resolve(userNameSymbol); }
+string Transaction::getBookTitle() const { return StringPool::getInstance()->resolve(bookTitleSymbol); }
 
-void Transaction::setTransactionID(string id) { transactionID = id; }
+string Transaction::getTransactionID() const { return formatID(transactionID); }
+string Transaction::getTypeName() const { return typeToString(type); }
+string Transaction::getTimestamp() const { return formatTimestamp(timestamp); }
+
+void Transaction::setTransactionID(uint64_t id) { transactionID = id; }
 
 string Transaction::toString() const {
     stringstream ss;
-    ss << "Transaction ID: " << transactionID << "\n"
-       << "User: " << userName << " (" << userID << ")\n"
-       << "Book: " << bookTitle << " (" << isbn << ")\n"
-       << "Type: " << type << "\n"
-       << "Timestamp: " << timestamp;
+    ss << "Transaction ID: " << getTransactionID() << "\n"
+       << "User: " << getUserName() << " (" << userID << ")\n"
+       << "Book: " << getBookTitle() << " (" << isbn << ")\n"
+       << "Type: " << getTypeName() << "\n"
+       << "Timestamp: " << getTimestamp();
     return ss.str();
 }
 
 string Transaction::toFileString() const {
     stringstream ss;
-    ss << transactionID << CSV_DELIMITER 
+    ss << getTransactionID() << CSV_DELIMITER 
        << userID << CSV_DELIMITER 
        << isbn << CSV_DELIMITER 
-       << type << CSV_DELIMITER 
-       << timestamp << CSV_DELIMITER 
-       << userName << CSV_DELIMITER 
-       << bookTitle;
+       << getTypeName() << CSV_DELIMITER 
+       << getTimestamp() << CSV_DELIMITER 
+       << getUserName() << CSV_DELIMITER 
+       << getBookTitle();
     return ss.str();
 }
 
@@ -61,42 +70,78 @@ Transaction Transaction::fromFileString(string line) {
     getline(ss, bookTitle, CSV_DELIMITER);
     
     Transaction trans;
-    trans.transactionID = transID;
+    trans.transactionID = parseID(transID);
     trans.userID = userID;
     trans.isbn = isbn;
-    trans.type = type;
-    trans.timestamp = timestamp;
-    trans.userName = userName;
-    trans.bookTitle = bookTitle;
+    trans.type = parseType(type);
+    trans.timestamp = parseTimestamp(timestamp);
+    trans.userNameSymbol = StringPool::getInstance()->intern(userName);
+    trans.bookTitleSymbol = StringPool::getInstance()->intern(bookTitle);
     
     // Update counter
-    if (transID.length() > 1 && transID[0] == 'T') {
-        int num = stoi(transID.substr(1));
-        if (num >= transactionCounter) {
-            transactionCounter = num + 1;
-        }
-    }
+    observeID(trans.transactionID);
     
     return trans;
 }
 
-string Transaction::generateTimestamp() {
-    time_t now = time(0);
-    tm* ltm = localtime(&now);
-    
-    stringstream ss;
-    ss << (1900 + ltm->tm_year) << "-"
-       << setfill('0') << setw(2) << (1 + ltm->tm_mon) << "-"
-       << setfill('0') << setw(2) << ltm->tm_mday << " "
-       << setfill('0') << setw(2) << ltm->tm_hour << ":"
-       << setfill('0') << setw(2) << ltm->tm_min << ":"
-       << setfill('0') << setw(2) << ltm->tm_sec;
-    
-    return ss.str();
+time_t Transaction::generateTimestamp() {
+    return time(0);
 }
 
-string Transaction::generateID() {
+uint64_t Transaction::generateID() {
+    return transactionCounter.fetch_add(1);
+}
+
+void Transaction::observeID(uint64_t id) {
+    uint64_t next = id + 1;
+    uint64_t current = transactionCounter.load();
+    while (current < next && !transactionCounter.compare_exchange_weak(current, next)) {
+    }
+}
+
+string Transaction::formatID(uint64_t id) {
     stringstream ss;
-    ss << "T" << setfill('0') << setw(4) << transactionCounter++;
+    ss << "T" << setfill('0') << setw(4) << id;
     return ss.str();
 }
+
+string Transaction::formatTimestamp(time_t time) {
+    tm ltm;
+    #ifdef _WIN32
+        localtime_s(&ltm, &time);
+    #else
+        localtime_r(&time, &ltm);
+    #endif
+    
+    char buffer[20];    // "YYYY-MM-DD HH:MM:SS"
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &ltm);
+    return buffer;
+}
+
+string Transaction::typeToString(Type type) {
+    return type == RETURN ? "RETURN" : "BORROW";
+}
+
+uint64_t Transaction::parseID(const string& str) {
+    if (str.length() > 1 && str[0] == 'T') {
+        return strtoull(str.c_str() + 1, nullptr, 10);
+    }
+    return 0;
+}
+
+time_t Transaction::parseTimestamp(const string& str) {
+    tm ltm = tm();
+    if (sscanf(str.c_str(), "%d-%d-%d %d:%d:%d",
+               &ltm.tm_year, &ltm.tm_mon, &ltm.tm_mday,
+               &ltm.tm_hour, &ltm.tm_min, &ltm.tm_sec) != 6) {
+        return 0;
+    }
+    ltm.tm_year -= 1900;
+    ltm.tm_mon -= 1;
+    ltm.tm_isdst = -1;
+    return mktime(&ltm);
+}
+
+Transaction::Type Transaction::parseType(const string& str) {
+    return str == "RETURN" ? RETURN : BORROW;
+}
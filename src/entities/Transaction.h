@@ -2,40 +2,60 @@
 #define TRANSACTION_H
 
 #include <string>
+#include <cstdint>
+#include <ctime>
+#include <atomic>
 using namespace std;
 
 class Transaction {
+public:
+    enum Type { BORROW, RETURN };
+
 private:
-    string transactionID;
+    uint64_t transactionID;
     string userID;
     string isbn;
-    string type;
-    string timestamp;
-    string userName;
-    string bookTitle;
+    Type type;
+    time_t timestamp;
+    // Names as they were at event time, interned in StringPool
+    uint32_t userNameSymbol;
+    uint32_t bookTitleSymbol;
     
-    static int transactionCounter;
+    static atomic<uint64_t> transactionCounter;
 
 public:
     Transaction();
-    Transaction(string userID, string isbn, string type, string userName, string bookTitle);
+    Transaction(string userID, string isbn, Type type, string userName, string bookTitle);
     
     // Getters
-    string getTransactionID() const;
+    uint64_t getID() const;
     string getUserID() const;
     string getISBN() const;
-    string getType() const;
-    string getTimestamp() const;
+    Type getType() const;
+    time_t getTime() const;
     string getUserName() const;
     string getBookTitle() const;
     
+    // Display formatting (done on demand, never on the write path)
+    string getTransactionID() const;
+    string getTypeName() const;
+    string getTimestamp() const;
+    
     // Utility
     string toString() const;
     string toFileString() const;
     static Transaction fromFileString(string line);
-    static string generateTimestamp();
-    static string generateID();
-    void setTransactionID(string id);
+    static time_t generateTimestamp();
+    static uint64_t generateID();
+    static void observeID(uint64_t id);
+    void setTransactionID(uint64_t id);
+    
+    static string formatID(uint64_t id);
+    static string formatTimestamp(time_t time);
+    static string typeToString(Type type);
+    static uint64_t parseID(const string& str);
+    static time_t parseTimestamp(const string& str);
+    static Type parseType(const string& str);
 };
 
 #endif
@@ -35,6 +35,7 @@ string User::getPhoneNumber() const { return phoneNumber; }
 int User::getBorrowedCount() const { return borrowedCount; }
 set<string> User::getBorrowedISBNs() const { return borrowedISBNs; }
 bool User::isAccountActive() const { return isActive; }
+Handle User::getHandle() const { return handle; }
 
 void User::setActive(bool status) { isActive = status; }
 void User::updateContact(string email, string phone) {
@@ -42,6 +43,7 @@ void User::updateContact(string email, string phone) {
     this->phoneNumber = phone;
 }
 void User::setUserID(string id) { userID = id; }
+void User::setHandle(Handle slotHandle) { handle = slotHandle; }
 
 bool User::canBorrow() const {
     return isActive && borrowedCount < MAX_BORROW_LIMIT;
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <set>
+#include "../utils/SlotTable.h"
 using namespace std;
 
 class User {
@@ -16,6 +17,7 @@ private:
     set<string> borrowedISBNs;
     int borrowedCount;
     bool isActive;
+    Handle handle;      // slot in the owning UserHashMap's table
     
     static int userCounter;
 
@@ -36,11 +38,13 @@ public:
     int getBorrowedCount() const;
     set<string> getBorrowedISBNs() const;
     bool isAccountActive() const;
+    Handle getHandle() const;
     
     // Setters
     void setActive(bool status);
     void updateContact(string email, string phone);
     void setUserID(string id);
+    void setHandle(Handle slotHandle);
     
     // Business Logic
     bool canBorrow() const;
@@ -1,8 +1,14 @@
 #include "management/LibraryManager.h"
 #include "management/AuthManager.h"
+#include "server/LibraryServer.h"
 #include "Config.h"
 #include <iostream>
+#include <csignal>
 #include <limits>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iomanip>
 
 #ifdef _WIN32
     #include <conio.h>
@@ -55,6 +61,34 @@ int getIntInput(string prompt) {
     }
 }
 
+// Blank input means "no value" and returns -1
+int getOptionalIntInput(string prompt) {
+    while (true) {
+        string input = getInput(prompt);
+        if (input.find_first_not_of(" \t") == string::npos) {
+            return -1;
+        }
+        try {
+            int value = stoi(input);
+            if (value >= 0) return value;
+        } catch (...) {
+        }
+        cout << "Invalid input. Please enter a number or leave it blank.\n";
+    }
+}
+
+// Items separated by ';', trimmed, blanks dropped
+vector<string> getListInput(string prompt) {
+    vector<string> items;
+    for (string item : FileHandler::split(getInput(prompt), LIST_DELIMITER)) {
+        size_t first = item.find_first_not_of(" \t");
+        if (first == string::npos) continue;
+        size_t last = item.find_last_not_of(" \t");
+        items.push_back(item.substr(first, last - first + 1));
+    }
+    return items;
+}
+
 string getPasswordInput(string prompt) {
     string password;
     cout << prompt;
@@ -91,6 +125,37 @@ string getPasswordInput(string prompt) {
     return password;
 }
 
+// One keystroke without waiting for Enter, or -1 at end of input. Expects
+// the terminal in raw mode (see handleIncrementalSearch); keys that send
+// escape sequences come back as 27 with the rest of the sequence dropped.
+int readKey() {
+    #ifdef _WIN32
+        int ch = _getch();
+        if (ch == 0 || ch == 224) {
+            _getch();
+            return 27;
+        }
+        return ch;
+    #else
+        // read() rather than cin so no bytes are left behind in a stream buffer
+        unsigned char ch;
+        if (read(STDIN_FILENO, &ch, 1) != 1) return -1;
+        if (ch == 27) {
+            // Drain the rest of the sequence, waiting at most a tenth of a second
+            termios current;
+            tcgetattr(STDIN_FILENO, &current);
+            termios drain = current;
+            drain.c_cc[VMIN] = 0;
+            drain.c_cc[VTIME] = 1;
+            tcsetattr(STDIN_FILENO, TCSANOW, &drain);
+            unsigned char rest;
+            while (read(STDIN_FILENO, &rest, 1) == 1) {}
+            tcsetattr(STDIN_FILENO, TCSANOW, &current);
+        }
+        return ch;
+    #endif
+}
+
 bool confirmAction(string message) {
     string response = getInput(message + " (y/n): ");
     return (response == "y" || response == "Y" || response == "yes" || response == "Yes");
@@ -110,7 +175,149 @@ void displayError(string message) {
     cout << "\n✗ ERROR: " << message << "\n";
 }
 
+void handleQuickSearch() {
+    clearScreen();
+    displayHeader("QUICK SEARCH");
+    string query = getInput("Type the beginning of a title or author word: ");
+    
+    vector<string> suggestions = library->suggestSearchTerms(query);
+    if (!suggestions.empty()) {
+        cout << "\nSuggestions:";
+        for (const string& term : suggestions) {
+            cout << "  " << term;
+        }
+        cout << "\n";
+    }
+    
+    vector<Book*> results = library->searchBooks(query, "prefix");
+    
+    if (results.empty()) {
+        cout << "No books found.\n";
+    } else {
+        cout << "\nTop Matches:\n";
+        for (Book* book : results) {
+            cout << "  " << book->getISBN() << "  " << book->getTitle() 
+                 << " - " << book->getAuthor() << "\n";
+        }
+    }
+    pressEnter();
+}
+
+static void drawIncrementalSearch(const string& query) {
+    clearScreen();
+    displayHeader("SEARCH AS YOU TYPE");
+    cout << "Type to search; Backspace edits, Enter or Esc returns.\n\n";
+    cout << "Search: " << query << "\n\n";
+    if (query.empty()) {
+        cout.flush();
+        return;
+    }
+    
+    size_t matches = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<Book*> results = library->searchAsYouType(query, matches);
+    double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
+    if (results.empty()) {
+        cout << "No books found.\n";
+    } else {
+        cout << matches << " matching books (" << fixed << setprecision(3) << millis << " ms)\n\n";
+        cout.unsetf(ios::fixed);
+        for (Book* book : results) {
+            cout << "  " << book->getISBN() << "  " << book->getTitle() 
+                 << " - " << book->getAuthor() << "\n";
+        }
+    }
+    cout.flush();
+}
+
+// Redraws the best matches after every keystroke. Without a terminal (input
+// piped in) the query is read as one line and fed through character by character.
+void handleIncrementalSearch() {
+    string query;
+    
+    #ifndef _WIN32
+        termios oldt;
+        if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &oldt) != 0) {
+            string line = getInput("Search: ");
+            for (char ch : line) {
+                query += ch;
+                drawIncrementalSearch(query);
+            }
+            pressEnter();
+            return;
+        }
+        termios newt = oldt;
+        newt.c_lflag &= ~(ICANON | ECHO);
+        newt.c_cc[VMIN] = 1;
+        newt.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    #endif
+    
+    while (true) {
+        drawIncrementalSearch(query);
+        
+        int key = readKey();
+        if (key == -1 || key == 27 || key == '\n' || key == '\r') {
+            break;
+        }
+        if (key == '\b' || key == 127) {
+            // Drop a whole UTF-8 character, not just its last byte
+            while (!query.empty() && (query.back() & 0xC0) == 0x80) {
+                query.pop_back();
+            }
+            if (!query.empty()) {
+                query.pop_back();
+            }
+        } else if (key >= 32) {
+            query += (char)key;
+        }
+    }
+    
+    #ifndef _WIN32
+        tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    #endif
+}
+
 // Login and Registration
+CatalogOrder::SortKey getSortOrder() {
+    cout << "Sort by:\n";
+    cout << "1. ISBN\n";
+    cout << "2. Title\n";
+    cout << "3. Author\n";
+    cout << "4. Most Copies Available\n";
+    
+    switch (getIntInput("\nEnter choice: ")) {
+        case 2: return CatalogOrder::BY_TITLE;
+        case 3: return CatalogOrder::BY_AUTHOR;
+        case 4: return CatalogOrder::BY_AVAILABLE_COPIES;
+        default: return CatalogOrder::BY_ISBN;
+    }
+}
+
+// Shows a listing page by page, leaving the last page viewed on screen.
+// Returns true when there was more than one page and the reader has
+// already pressed Enter to finish.
+bool browseCatalog(bool availableOnly, CatalogOrder::SortKey order) {
+    int page = 0;
+    while (true) {
+        clearScreen();
+        int pages = availableOnly ? library->displayAvailableBooks(order, page)
+                                  : library->displayAllBooks(order, page);
+        if (pages <= 1) return false;
+        
+        string input = getInput("\n[N]ext page, [P]revious page, Enter to finish: ");
+        char key = input.empty() ? '\0' : (char)tolower((unsigned char)input[0]);
+        if (key == 'n') {
+            page = min(page + 1, pages - 1);
+        } else if (key == 'p') {
+            page = max(page - 1, 0);
+        } else {
+            return true;
+        }
+    }
+}
+
 bool handleAdminLogin() {
     clearScreen();
     displayHeader("ADMIN LOGIN");
@@ -209,7 +416,7 @@ void adminBookManagement() {
                 displayHeader("ADD NEW BOOK");
                 string isbn = getInput("ISBN: ");
                 string title = getInput("Title: ");
-                string author = getInput("Author: ");
+                string author = getInput("Author(s), separated by ';': ");
                 int quantity = getIntInput("Quantity: ");
                 
                 if (library->addBook(isbn, title, author, quantity)) {
@@ -248,14 +455,14 @@ void adminBookManagement() {
             }
             case 4: {
                 clearScreen();
-                library->displayAllBooks();
-                pressEnter();
+                CatalogOrder::SortKey order = getSortOrder();
+                if (!browseCatalog(false, order)) pressEnter();
                 break;
             }
             case 5: {
                 clearScreen();
-                library->displayAvailableBooks();
-                pressEnter();
+                CatalogOrder::SortKey order = getSortOrder();
+                if (!browseCatalog(true, order)) pressEnter();
                 break;
             }
             case 6:
@@ -342,7 +549,9 @@ void adminReportsAnalytics() {
         cout << "1. System Statistics\n";
         cout << "2. All Transactions\n";
         cout << "3. Borrowing Report\n";
-        cout << "4. Back to Main Menu\n";
+        cout << "4. Transaction History Lookup\n";
+        cout << "5. Near-Duplicate Titles\n";
+        cout << "6. Back to Main Menu\n";
         
         int choice = getIntInput("\nEnter choice: ");
         
@@ -365,7 +574,38 @@ void adminReportsAnalytics() {
                 pressEnter();
                 break;
             }
-            case 4:
+            case 4: {
+                clearScreen();
+                displayHeader("TRANSACTION HISTORY LOOKUP");
+                cout << "1. By User ID\n";
+                cout << "2. By ISBN\n";
+                cout << "3. By Date\n";
+                int filter = getIntInput("\nEnter choice: ");
+                
+                if (filter == 1) {
+                    library->displayTransactionHistory("user", getInput("User ID: "));
+                } else if (filter == 2) {
+                    library->displayTransactionHistory("isbn", getInput("ISBN: "));
+                } else if (filter == 3) {
+                    library->displayTransactionHistory("date", getInput("Date (YYYY-MM-DD): "));
+                } else {
+                    displayError("Invalid choice.");
+                }
+                pressEnter();
+                break;
+            }
+            case 5: {
+                clearScreen();
+                if (library->displayNearDuplicates() > 0 &&
+                    confirmAction("\nLink each cluster's books as editions of its first book?")) {
+                    int linked = library->linkNearDuplicateEditions();
+                    displaySuccess(to_string(linked) + " book(s) linked as editions.");
+                    library->saveAllData();
+                }
+                pressEnter();
+                break;
+            }
+            case 6:
                 return;
             default:
                 displayError("Invalid choice.");
@@ -374,6 +614,35 @@ void adminReportsAnalytics() {
     }
 }
 
+void handleFacetedSearch() {
+    clearScreen();
+    displayHeader("FILTERED SEARCH");
+    cout << "Leave any field blank to skip it.\n\n";
+    
+    string query = getInput("Title or author words: ");
+    FacetIndex::Filter filter;
+    filter.authors = getListInput("Author(s), separated by ';': ");
+    filter.publisherPrefixes = getListInput("ISBN publisher prefix(es), e.g. 978-0-201: ");
+    filter.minQuantity = getOptionalIntInput("Minimum copies: ");
+    filter.maxQuantity = getOptionalIntInput("Maximum copies: ");
+    filter.availableOnly = confirmAction("Only books with a copy on the shelf?");
+    
+    library->displayFacetedSearch(query, filter);
+    pressEnter();
+}
+
+void handleBrowseAuthors() {
+    clearScreen();
+    displayHeader("BROWSE AUTHORS");
+    library->displayAuthors();
+    
+    string name = getInput("\nEnter an author's name to list their titles (blank to go back): ");
+    if (!name.empty()) {
+        library->displayBooksByAuthor(name);
+        pressEnter();
+    }
+}
+
 void adminSearchOperations() {
     while (true) {
         clearScreen();
@@ -381,7 +650,11 @@ void adminSearchOperations() {
         cout << "1. Search Book by Title\n";
         cout << "2. Search Book by Author\n";
         cout << "3. Search Book by ISBN\n";
-        cout << "4. Back to Main Menu\n";
+        cout << "4. Quick Search (word prefix)\n";
+        cout << "5. Filtered Search (author, publisher, copies)\n";
+        cout << "6. Search as You Type\n";
+        cout << "7. Browse Authors\n";
+        cout << "8. Back to Main Menu\n";
         
         int choice = getIntInput("\nEnter choice: ");
         
@@ -428,6 +701,18 @@ void adminSearchOperations() {
                 break;
             }
             case 4:
+                handleQuickSearch();
+                break;
+            case 5:
+                handleFacetedSearch();
+                break;
+            case 6:
+                handleIncrementalSearch();
+                break;
+            case 7:
+                handleBrowseAuthors();
+                break;
+            case 8:
                 return;
             default:
                 displayError("Invalid choice.");
@@ -486,14 +771,14 @@ void userBrowseBooks() {
         switch (choice) {
             case 1: {
                 clearScreen();
-                library->displayAvailableBooks();
-                pressEnter();
+                CatalogOrder::SortKey order = getSortOrder();
+                if (!browseCatalog(true, order)) pressEnter();
                 break;
             }
             case 2: {
                 clearScreen();
-                library->displayAllBooks();
-                pressEnter();
+                CatalogOrder::SortKey order = getSortOrder();
+                if (!browseCatalog(false, order)) pressEnter();
                 break;
             }
             case 3: {
@@ -519,7 +804,12 @@ void userSearchBooks() {
         cout << "1. Search by Title\n";
         cout << "2. Search by Author\n";
         cout << "3. Search by ISBN\n";
-        cout << "4. Back to Main Menu\n";
+        cout << "4. Quick Search (word prefix)\n";
+        cout << "5. Search Available Books Only\n";
+        cout << "6. Filtered Search (author, publisher, copies)\n";
+        cout << "7. Search as You Type\n";
+        cout << "8. Browse Authors\n";
+        cout << "9. Back to Main Menu\n";
         
         int choice = getIntInput("\nEnter choice: ");
         
@@ -566,6 +856,35 @@ void userSearchBooks() {
                 break;
             }
             case 4:
+                handleQuickSearch();
+                break;
+            case 5: {
+                clearScreen();
+                string query = getInput("Enter title or author words: ");
+                vector<Book*> results = library->searchBooks(query, "available");
+                
+                if (results.empty()) {
+                    cout << "No available books found.\n";
+                } else {
+                    cout << "\nAvailable Now:\n";
+                    for (Book* book : results) {
+                        cout << "\n" << book->toString() << "\n";
+                        cout << string(60, '-') << "\n";
+                    }
+                }
+                pressEnter();
+                break;
+            }
+            case 6:
+                handleFacetedSearch();
+                break;
+            case 7:
+                handleIncrementalSearch();
+                break;
+            case 8:
+                handleBrowseAuthors();
+                break;
+            case 9:
                 return;
             default:
                 displayError("Invalid choice.");
@@ -588,8 +907,7 @@ void userMyBooks() {
         
         switch (choice) {
             case 1: {
-                clearScreen();
-                library->displayAvailableBooks();
+                browseCatalog(true, CatalogOrder::BY_TITLE);
                 string isbn = getInput("\nEnter ISBN to borrow: ");
                 
                 if (library->borrowBook(isbn)) {
@@ -674,6 +992,12 @@ void userInterface() {
         clearScreen();
         displayHeader("USER MENU");
         User* currentUser = auth->getCurrentUser();
+        if (currentUser == nullptr) {
+            displayError("Your account is no longer available.");
+            auth->logout();
+            pressEnter();
+            return;
+        }
         cout << "Welcome, " << currentUser->getFullName() << "!\n";
         cout << "Books Borrowed: " << currentUser->getBorrowedCount() 
              << "/" << MAX_BORROW_LIMIT << "\n\n";
@@ -721,7 +1045,7 @@ void displayLoginScreen() {
     cout << "║          • AVL Binary Search Tree (Books)                  ║\n";
     cout << "║          • Hash Map (Users)                                ║\n";
     cout << "║          • Doubly Linked List (Transactions)               ║\n";
-    cout << "║          • Multi-Map Indices (Fast Search)                 ║\n";
+    cout << "║          • Inverted Index (Fast Search)                    ║\n";
     cout << "║                                                            ║\n";
     cout << "╚════════════════════════════════════════════════════════════╝\n";
     cout << "\n";
@@ -731,13 +1055,43 @@ void displayLoginScreen() {
     cout << "4. Exit\n";
 }
 
-int main() {
+// Server mode: desks and kiosks connect instead of using this terminal
+LibraryServer* runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer != nullptr) {
+        runningServer->stop();
+    }
+}
+
+int runServer(string address) {
+    LibraryServer server(library, auth);
+    if (!server.start(address, SERVER_WORKER_THREADS)) {
+        return 1;
+    }
+    
+    runningServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    cout << "Serving on " << address << ". Press Ctrl+C to stop.\n";
+    server.run();
+    runningServer = nullptr;
+    
+    library->saveAllData();
+    cout << "\nData saved. Server stopped.\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     library = LibraryManager::getInstance();
     auth = AuthManager::getInstance();
     
     library->setAuthManager(auth);
     auth->setUserMap(library->getUserMap());
     
+    // library_system --serve [address]
+    bool serve = argc > 1 && string(argv[1]) == "--serve";
+    
     cout << "Loading data...\n";
     if (!library->loadAllData()) {
         cout << "No existing data found. Initializing with sample data...\n";
@@ -746,12 +1100,15 @@ int main() {
         cout << "\nDefault Admin Credentials:\n";
         cout << "  Username: admin\n";
         cout << "  Password: admin123\n";
-        pressEnter();
     } else {
         cout << "Data loaded successfully!\n";
-        pressEnter();
     }
     
+    if (serve) {
+        return runServer(argc > 2 ? argv[2] : SERVER_ADDRESS);
+    }
+    pressEnter();
+    
     while (true) {
         displayLoginScreen();
         int choice = getIntInput("\nEnter choice: ");
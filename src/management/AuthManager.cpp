@@ -2,8 +2,9 @@
 #include "../Config.h"
 
 AuthManager* AuthManager::instance = nullptr;
+thread_local AuthManager::Session* AuthManager::activeSession = nullptr;
 
-AuthManager::AuthManager() : userMap(nullptr), currentUser(nullptr), currentRole(NONE) {}
+AuthManager::AuthManager() : userMap(nullptr) {}
 
 AuthManager* AuthManager::getInstance() {
     if (instance == nullptr) {
@@ -16,10 +17,18 @@ void AuthManager::setUserMap(UserHashMap* map) {
     userMap = map;
 }
 
+void AuthManager::setActiveSession(Session* session) {
+    activeSession = session;
+}
+
+AuthManager::Session& AuthManager::session() const {
+    return activeSession != nullptr ? *activeSession : consoleSession;
+}
+
 bool AuthManager::loginAsAdmin(string username, string password) {
     if (username == ADMIN_USERNAME && password == ADMIN_PASSWORD) {
-        currentRole = ADMIN;
-        currentUser = nullptr;
+        session().role = ADMIN;
+        session().user = Handle();
         return true;
     }
     return false;
@@ -28,12 +37,13 @@ bool AuthManager::loginAsAdmin(string username, string password) {
 bool AuthManager::loginAsUser(string username, string password) {
     if (userMap == nullptr) return false;
     
+    RWLock::ReadGuard directory(userMap->getLock());
     User* user = userMap->searchByUsername(username);
     
     if (user != nullptr && user->authenticate(password)) {
         if (user->isAccountActive()) {
-            currentUser = user;
-            currentRole = USER;
+            session().user = user->getHandle();
+            session().role = USER;
             return true;
         }
     }
@@ -44,11 +54,14 @@ bool AuthManager::loginAsUser(string username, string password) {
 bool AuthManager::registerUser(string username, string password, string fullName, string email, string phone) {
     if (userMap == nullptr) return false;
     
-    if (!isUsernameAvailable(username)) {
+    if (!validatePassword(password)) {
         return false;
     }
     
-    if (!validatePassword(password)) {
+    // Checked and inserted under one exclusive hold, so two sessions cannot
+    // both claim a free username
+    RWLock::WriteGuard directory(userMap->getLock());
+    if (userMap->existsUsername(username)) {
         return false;
     }
     
@@ -59,41 +72,48 @@ bool AuthManager::registerUser(string username, string password, string fullName
 }
 
 void AuthManager::logout() {
-    currentUser = nullptr;
-    currentRole = NONE;
+    session().user = Handle();
+    session().role = NONE;
 }
 
 bool AuthManager::isAdmin() const {
-    return currentRole == ADMIN;
+    return session().role == ADMIN;
 }
 
 bool AuthManager::isUser() const {
-    return currentRole == USER;
+    return session().role == USER;
 }
 
 bool AuthManager::isLoggedIn() const {
-    return currentRole != NONE;
+    return session().role != NONE;
 }
 
 User* AuthManager::getCurrentUser() const {
-    return currentUser;
+    if (userMap == nullptr) return nullptr;
+    return userMap->resolve(session().user);
 }
 
 string AuthManager::getCurrentUserID() const {
-    if (currentRole == ADMIN) {
+    if (session().role == ADMIN) {
         return ADMIN_ID;
-    } else if (currentUser != nullptr) {
-        return currentUser->getUserID();
+    }
+    if (userMap == nullptr) return "";
+    
+    RWLock::ReadGuard directory(userMap->getLock());
+    User* user = getCurrentUser();
+    if (user != nullptr) {
+        return user->getUserID();
     }
     return "";
 }
 
 AuthManager::Role AuthManager::getCurrentRole() const {
-    return currentRole;
+    return session().role;
 }
 
 bool AuthManager::isUsernameAvailable(string username) const {
     if (userMap == nullptr) return false;
+    RWLock::ReadGuard directory(userMap->getLock());
     return !userMap->existsUsername(username);
 }
 
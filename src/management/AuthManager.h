@@ -8,19 +8,36 @@
 class AuthManager {
 public:
     enum Role { NONE, ADMIN, USER };
+    
+    // Login state of one client: the console has its own, and server mode
+    // one per connection. A handle rather than a pointer: if the account is
+    // removed or the users reloaded, the session sees no user instead of a
+    // freed one.
+    struct Session {
+        Handle user;
+        Role role;
+        
+        Session() : role(NONE) {}
+    };
 
 private:
     static AuthManager* instance;
     UserHashMap* userMap;
-    User* currentUser;
-    Role currentRole;
+    mutable Session consoleSession;
+    // Session the calling thread acts for; nullptr means the console's
+    static thread_local Session* activeSession;
     
     AuthManager();
+    Session& session() const;
 
 public:
     static AuthManager* getInstance();
     void setUserMap(UserHashMap* map);
     
+    // Points this thread's logins, role checks and current user at session
+    // (nullptr returns it to the console session)
+    static void setActiveSession(Session* session);
+    
     bool loginAsAdmin(string username, string password);
     bool loginAsUser(string username, string password);
     bool registerUser(string username, string password, string fullName, string email, string phone);
@@ -29,6 +46,7 @@ public:
     bool isAdmin() const;
     bool isUser() const;
     bool isLoggedIn() const;
+    // Caller holds the user map's lock shared while it uses the account
     User* getCurrentUser() const;
     string getCurrentUserID() const;
     Role getCurrentRole() const;
@@ -5,23 +5,45 @@
 
 LibraryManager* LibraryManager::instance = nullptr;
 
+// Where this thread's reports and messages go; nullptr means cout
+static thread_local ostream* threadOutput = nullptr;
+
+static ostream& out() {
+    return threadOutput != nullptr ? *threadOutput : cout;
+}
+
+void LibraryManager::setOutput(ostream* stream) {
+    threadOutput = stream;
+}
+
 LibraryManager::LibraryManager() : authManager(nullptr) {
     initializeDataStructures();
 }
 
 LibraryManager::~LibraryManager() {
+    delete transactionIngestor;
+    delete transactionArchive;
     delete bookTree;
     delete userMap;
     delete transactionList;
     delete searchEngine;
+    delete circulationStats;
+    delete catalogOrder;
 }
 
 void LibraryManager::initializeDataStructures() {
     bookTree = new BookBST();
     userMap = new UserHashMap();
     transactionList = new TransactionList();
+    transactionIngestor = new TransactionIngestor(transactionList, TRANSACTION_QUEUE_CAPACITY, 
+                                                  TRANSACTION_BATCH_SIZE);
+    transactionIngestor->start();
+    transactionArchive = new TransactionArchive(HISTORY_DIR);
     searchEngine = new SearchEngine();
     searchEngine->setBookTree(bookTree);
+    searchEngine->startMerger();
+    circulationStats = new CirculationStats();
+    catalogOrder = new CatalogOrder();
 }
 
 LibraryManager* LibraryManager::getInstance() {
@@ -35,92 +57,116 @@ void LibraryManager::setAuthManager(AuthManager* auth) {
     authManager = auth;
 }
 
+mutex& LibraryManager::bookLock(const string& isbn) {
+    return bookLocks[hash<string>()(isbn) % LOCK_STRIPES];
+}
+
+mutex& LibraryManager::userLock(const string& userID) {
+    return userLocks[hash<string>()(userID) % LOCK_STRIPES];
+}
+
 // ============ ADMIN OPERATIONS - BOOK MANAGEMENT ============
 
 bool LibraryManager::addBook(string isbn, string title, string author, int quantity) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return false;
     }
     
+    RWLock::WriteGuard catalog(catalogLock);
     Book* existing = bookTree->search(isbn);
     if (existing != nullptr) {
-        cout << "Error: Book with ISBN " << isbn << " already exists.\n";
+        out() << "Error: Book with ISBN " << isbn << " already exists.\n";
         return false;
     }
     
     Book* newBook = new Book(isbn, title, author, quantity);
     bookTree->insert(newBook);
     searchEngine->addBookToIndex(newBook);
+    circulationStats->onBookAdded(newBook);
+    catalogOrder->onBookAdded(newBook);
     
     return true;
 }
 
 bool LibraryManager::removeBook(string isbn) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return false;
     }
     
+    RWLock::WriteGuard catalog(catalogLock);
     Book* book = bookTree->search(isbn);
     if (book == nullptr) {
-        cout << "Error: Book not found.\n";
+        out() << "Error: Book not found.\n";
         return false;
     }
     
     if (book->getAvailableCopies() < book->getQuantity()) {
-        cout << "Error: Cannot remove book. Some copies are currently borrowed.\n";
+        out() << "Error: Cannot remove book. Some copies are currently borrowed.\n";
         return false;
     }
     
     searchEngine->removeBookFromIndex(book);
+    circulationStats->onBookRemoved(book);
+    catalogOrder->onBookRemoved(book);
     return bookTree->remove(isbn);
 }
 
 bool LibraryManager::updateBookDetails(string isbn, string newTitle, string newAuthor) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return false;
     }
     
+    RWLock::WriteGuard catalog(catalogLock);
     Book* book = bookTree->search(isbn);
     if (book == nullptr) {
-        cout << "Error: Book not found.\n";
+        out() << "Error: Book not found.\n";
         return false;
     }
     
+    // Edited in place: the book keeps its handle, copies and edition link,
+    // and only the indexes keyed on title or author re-file it
     searchEngine->removeBookFromIndex(book);
+    catalogOrder->onBookRemoved(book);
     
-    Book* updatedBook = new Book(isbn, newTitle, newAuthor, book->getQuantity());
-    updatedBook->setAvailableCopies(book->getAvailableCopies());
+    book->setTitle(newTitle);
+    book->setAuthor(newAuthor);
     
-    bookTree->remove(isbn);
-    bookTree->insert(updatedBook);
-    searchEngine->addBookToIndex(updatedBook);
+    searchEngine->addBookToIndex(book);
+    catalogOrder->onBookAdded(book);
     
     return true;
 }
 
 bool LibraryManager::updateBookQuantity(string isbn, int newQuantity) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return false;
     }
     
+    RWLock::WriteGuard catalog(catalogLock);
     Book* book = bookTree->search(isbn);
     if (book == nullptr) {
-        cout << "Error: Book not found.\n";
+        out() << "Error: Book not found.\n";
         return false;
     }
     
     int borrowed = book->getQuantity() - book->getAvailableCopies();
     if (newQuantity < borrowed) {
-        cout << "Error: Cannot set quantity below borrowed copies (" << borrowed << ").\n";
+        out() << "Error: Cannot set quantity below borrowed copies (" << borrowed << ").\n";
         return false;
     }
     
+    int oldQuantity = book->getQuantity();
+    int oldAvailable = book->getAvailableCopies();
+    
     book->setQuantity(newQuantity);
     book->setAvailableCopies(newQuantity - borrowed);
+    circulationStats->onCopiesChanged(oldQuantity, oldAvailable, 
+                                      book->getQuantity(), book->getAvailableCopies());
+    catalogOrder->onCopiesChanged(book);
     
     return true;
 }
@@ -131,56 +177,60 @@ vector<User*> LibraryManager::getAllUsers() {
     if (!authManager || !authManager->isAdmin()) {
         return vector<User*>();
     }
+    RWLock::ReadGuard directory(userMap->getLock());
     return userMap->getAllUsers();
 }
 
 void LibraryManager::displayAllUsers() {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return;
     }
     
+    RWLock::ReadGuard directory(userMap->getLock());
     vector<User*> users = userMap->getAllUsers();
     
     if (users.empty()) {
-        cout << "No users registered.\n";
+        out() << "No users registered.\n";
         return;
     }
     
-    cout << "\n" << string(100, '=') << "\n";
-    cout << left << setw(10) << "User ID"
-         << setw(20) << "Username"
-         << setw(25) << "Full Name"
-         << setw(15) << "Borrowed"
-         << setw(10) << "Status" << "\n";
-    cout << string(100, '=') << "\n";
+    out() << "\n" << string(100, '=') << "\n";
+    out() << left << setw(10) << "User ID"
+          << setw(20) << "Username"
+          << setw(25) << "Full Name"
+          << setw(15) << "Borrowed"
+          << setw(10) << "Status" << "\n";
+    out() << string(100, '=') << "\n";
     
     for (User* user : users) {
-        cout << left << setw(10) << user->getUserID()
-             << setw(20) << user->getUsername()
-             << setw(25) << user->getFullName()
-             << setw(15) << (to_string(user->getBorrowedCount()) + "/" + to_string(MAX_BORROW_LIMIT))
-             << setw(10) << (user->isAccountActive() ? "Active" : "Inactive") << "\n";
+        lock_guard<mutex> account(userLock(user->getUserID()));
+        out() << left << setw(10) << user->getUserID()
+              << setw(20) << user->getUsername()
+              << setw(25) << user->getFullName()
+              << setw(15) << (to_string(user->getBorrowedCount()) + "/" + to_string(MAX_BORROW_LIMIT))
+              << setw(10) << (user->isAccountActive() ? "Active" : "Inactive") << "\n";
     }
     
-    cout << string(100, '=') << "\n";
-    cout << "Total Users: " << users.size() << "\n";
+    out() << string(100, '=') << "\n";
+    out() << "Total Users: " << users.size() << "\n";
 }
 
 bool LibraryManager::removeUser(string userID) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return false;
     }
     
+    RWLock::WriteGuard directory(userMap->getLock());
     User* user = userMap->searchByID(userID);
     if (user == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return false;
     }
     
     if (user->getBorrowedCount() > 0) {
-        cout << "Error: Cannot remove user with borrowed books.\n";
+        out() << "Error: Cannot remove user with borrowed books.\n";
         return false;
     }
     
@@ -189,13 +239,14 @@ bool LibraryManager::removeUser(string userID) {
 
 bool LibraryManager::deactivateUser(string userID) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return false;
     }
     
+    RWLock::WriteGuard directory(userMap->getLock());
     User* user = userMap->searchByID(userID);
     if (user == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return false;
     }
     
@@ -205,13 +256,14 @@ bool LibraryManager::deactivateUser(string userID) {
 
 bool LibraryManager::activateUser(string userID) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return false;
     }
     
+    RWLock::WriteGuard directory(userMap->getLock());
     User* user = userMap->searchByID(userID);
     if (user == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return false;
     }
     
@@ -221,27 +273,31 @@ bool LibraryManager::activateUser(string userID) {
 
 void LibraryManager::displayUserDetails(string userID) {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return;
     }
     
+    RWLock::ReadGuard catalog(catalogLock);
+    RWLock::ReadGuard directory(userMap->getLock());
     User* user = userMap->searchByID(userID);
     if (user == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return;
     }
+    lock_guard<mutex> account(userLock(userID));
     
-    cout << "\n" << string(60, '=') << "\n";
-    cout << user->toString() << "\n";
-    cout << string(60, '=') << "\n";
+    out() << "\n" << string(60, '=') << "\n";
+    out() << user->toString() << "\n";
+    out() << "Lifetime Borrows: " << circulationStats->getUserBorrowCount(userID) << "\n";
+    out() << string(60, '=') << "\n";
     
     set<string> borrowedISBNs = user->getBorrowedISBNs();
     if (!borrowedISBNs.empty()) {
-        cout << "\nBorrowed Books:\n";
+        out() << "\nBorrowed Books:\n";
         for (const string& isbn : borrowedISBNs) {
             Book* book = bookTree->search(isbn);
             if (book != nullptr) {
-                cout << "  - " << book->getTitle() << " (" << isbn << ")\n";
+                out() << "  - " << book->getTitle() << " (" << isbn << ")\n";
             }
         }
     }
@@ -251,462 +307,898 @@ void LibraryManager::displayUserDetails(string userID) {
 
 void LibraryManager::displayAllTransactions() {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return;
     }
     
+    // Archiving deletes transactions, and only runs under the exclusive lock
+    RWLock::ReadGuard catalog(catalogLock);
+    transactionIngestor->flush();
     vector<Transaction*> transactions = transactionList->getRecent(RECENT_TRANSACTIONS_COUNT);
     
     if (transactions.empty()) {
-        cout << "No transactions recorded.\n";
+        out() << "No transactions recorded.\n";
         return;
     }
     
-    cout << "\n" << string(120, '=') << "\n";
-    cout << "RECENT TRANSACTIONS (Last " << RECENT_TRANSACTIONS_COUNT << ")\n";
-    cout << string(120, '=') << "\n";
+    out() << "\n" << string(120, '=') << "\n";
+    out() << "RECENT TRANSACTIONS (Last " << RECENT_TRANSACTIONS_COUNT << ")\n";
+    out() << string(120, '=') << "\n";
     
-    cout << left << setw(12) << "Trans ID"
-         << setw(15) << "User"
-         << setw(35) << "Book"
-         << setw(10) << "Type"
-         << setw(20) << "Timestamp" << "\n";
-    cout << string(120, '=') << "\n";
+    out() << left << setw(12) << "Trans ID"
+          << setw(15) << "User"
+          << setw(35) << "Book"
+          << setw(10) << "Type"
+          << setw(20) << "Timestamp" << "\n";
+    out() << string(120, '=') << "\n";
     
     for (Transaction* trans : transactions) {
-        cout << left << setw(12) << trans->getTransactionID()
-             << setw(15) << trans->getUserName()
-             << setw(35) << trans->getBookTitle().substr(0, 32)
-             << setw(10) << trans->getType()
-             << setw(20) << trans->getTimestamp() << "\n";
+        out() << left << setw(12) << trans->getTransactionID()
+              << setw(15) << trans->getUserName()
+              << setw(35) << trans->getBookTitle().substr(0, 32)
+              << setw(10) << trans->getTypeName()
+              << setw(20) << trans->getTimestamp() << "\n";
     }
     
-    cout << string(120, '=') << "\n";
+    out() << string(120, '=') << "\n";
 }
 
 void LibraryManager::displaySystemStatistics() {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return;
     }
     
+    RWLock::ReadGuard catalog(catalogLock);
+    RWLock::ReadGuard directory(userMap->getLock());
     int totalBooks = bookTree->getCount();
-    int availableBooks = 0;
-    int borrowedBooks = 0;
-    
-    vector<Book*> allBooks = bookTree->getAllBooksSorted();
-    for (Book* book : allBooks) {
-        availableBooks += book->getAvailableCopies();
-        borrowedBooks += (book->getQuantity() - book->getAvailableCopies());
-    }
+    time_t now = time(0);
     
     int totalUsers = userMap->getCount();
-    int totalTransactions = transactionList->getCount();
-    
-    cout << "\n" << string(60, '=') << "\n";
-    cout << "LIBRARY SYSTEM STATISTICS\n";
-    cout << string(60, '=') << "\n";
-    cout << "Total Book Titles: " << totalBooks << "\n";
-    cout << "Total Book Copies: " << (availableBooks + borrowedBooks) << "\n";
-    cout << "  - Available: " << availableBooks << "\n";
-    cout << "  - Borrowed: " << borrowedBooks << "\n";
-    cout << "Total Users: " << totalUsers << "\n";
-    cout << "Total Transactions: " << totalTransactions << "\n";
-    cout << string(60, '=') << "\n";
+    int totalTransactions = getTotalTransactions();
+    
+    out() << "\n" << string(60, '=') << "\n";
+    out() << "LIBRARY SYSTEM STATISTICS\n";
+    out() << string(60, '=') << "\n";
+    out() << "Total Book Titles: " << totalBooks << "\n";
+    out() << "Titles Available: " << circulationStats->getTitlesAvailable() << "\n";
+    out() << "Total Book Copies: " << circulationStats->getTotalCopies() << "\n";
+    out() << "  - Available: " << circulationStats->getAvailableCopies() << "\n";
+    out() << "  - Borrowed: " << circulationStats->getLoanedCopies() << "\n";
+    out() << "Total Users: " << totalUsers << "\n";
+    out() << "Total Transactions: " << totalTransactions << "\n";
+    out() << "Lifetime Borrows: " << circulationStats->getLifetimeBorrows() << "\n";
+    out() << "Today: " << circulationStats->getBorrowsOn(now) << " borrowed, "
+          << circulationStats->getReturnsOn(now) << " returned\n";
+    
+    // Cache figures rounded to one decimal place
+    QueryCache::Stats cache = searchEngine->getCacheStats();
+    uint64_t lookups = cache.hits + cache.misses;
+    double avgHit = cache.hits ? cache.hitMicros / cache.hits : 0.0;
+    double avgMiss = cache.misses ? cache.missMicros / cache.misses : 0.0;
+    out() << "Search Cache: " << cache.entries << "/" << cache.capacity << " entries, "
+          << (long)(searchEngine->getCacheHitRatio() * 1000 + 0.5) / 10.0 << "% hits ("
+          << cache.hits << "/" << lookups << " lookups)\n";
+    out() << "  - Avg latency: " << (long)(avgHit * 10 + 0.5) / 10.0 << " us hit, "
+          << (long)(avgMiss * 10 + 0.5) / 10.0 << " us miss\n";
+    out() << "  - Invalidated: " << cache.staleMisses << ", Evicted: " << cache.evictions << "\n";
+    out() << "Search Index: " << searchEngine->getSegmentCount() << " segments ("
+          << searchEngine->getMappedSegmentCount() << " memory-mapped), "
+          << searchEngine->getTombstoneCount() << " pending deletions\n";
+    out() << string(60, '=') << "\n";
 }
 
 void LibraryManager::displayBorrowingReport() {
     if (!authManager || !authManager->isAdmin()) {
-        cout << "Access Denied: Admin privileges required.\n";
+        out() << "Access Denied: Admin privileges required.\n";
         return;
     }
     
+    RWLock::ReadGuard catalog(catalogLock);
+    RWLock::ReadGuard directory(userMap->getLock());
     vector<User*> users = userMap->getAllUsers();
     
-    cout << "\n" << string(80, '=') << "\n";
-    cout << "BORROWING REPORT\n";
-    cout << string(80, '=') << "\n";
+    out() << "\n" << string(80, '=') << "\n";
+    out() << "BORROWING REPORT\n";
+    out() << string(80, '=') << "\n";
     
     for (User* user : users) {
+        lock_guard<mutex> account(userLock(user->getUserID()));
         if (user->getBorrowedCount() > 0) {
-            cout << user->getFullName() << " (" << user->getUserID() << "): "
-                 << user->getBorrowedCount() << " books\n";
+            out() << user->getFullName() << " (" << user->getUserID() << "): "
+                  << user->getBorrowedCount() << " books\n";
             
             set<string> borrowedISBNs = user->getBorrowedISBNs();
             for (const string& isbn : borrowedISBNs) {
                 Book* book = bookTree->search(isbn);
                 if (book != nullptr) {
-                    cout << "  - " << book->getTitle() << "\n";
+                    out() << "  - " << book->getTitle() << "\n";
                 }
             }
-            cout << "\n";
+            out() << "\n";
         }
     }
     
-    cout << string(80, '=') << "\n";
+    out() << string(80, '=') << "\n";
 }
 
-// ============ USER OPERATIONS - BROWSE & SEARCH ============
-
-void LibraryManager::displayAvailableBooks() {
-    vector<Book*> books = searchEngine->searchAvailableBooks();
+void LibraryManager::displayTransactionHistory(string filterType, string value) {
+    if (!authManager || !authManager->isAdmin()) {
+        out() << "Access Denied: Admin privileges required.\n";
+        return;
+    }
     
-    if (books.empty()) {
-        cout << "No available books.\n";
+    RWLock::ReadGuard catalog(catalogLock);
+    vector<Transaction> transactions = collectHistory(filterType, value);
+    
+    if (transactions.empty()) {
+        out() << "No matching transactions.\n";
         return;
     }
     
-    cout << "\n" << string(120, '=') << "\n";
-    cout << "AVAILABLE BOOKS\n";
-    cout << string(120, '=') << "\n";
+    out() << "\n" << string(120, '=') << "\n";
+    out() << "TRANSACTION HISTORY (" << filterType << ": " << value << ")\n";
+    out() << string(120, '=') << "\n";
+    
+    out() << left << setw(12) << "Trans ID"
+          << setw(15) << "User"
+          << setw(35) << "Book"
+          << setw(10) << "Type"
+          << setw(20) << "Timestamp" << "\n";
+    out() << string(120, '=') << "\n";
+    
+    for (const Transaction& trans : transactions) {
+        out() << left << setw(12) << trans.getTransactionID()
+              << setw(15) << trans.getUserName()
+              << setw(35) << trans.getBookTitle().substr(0, 32)
+              << setw(10) << trans.getTypeName()
+              << setw(20) << trans.getTimestamp() << "\n";
+    }
     
-    cout << left << setw(20) << "ISBN"
-         << setw(40) << "Title"
-         << setw(30) << "Author"
-         << setw(10) << "Available" << "\n";
-    cout << string(120, '=') << "\n";
+    out() << string(120, '=') << "\n";
+    out() << "Total Transactions: " << transactions.size() << "\n";
+}
+
+// Oldest first: archived segments, then the in-memory window
+vector<Transaction> LibraryManager::collectHistory(string filterType, string value) {
+    transactionIngestor->flush();
+    
+    vector<Transaction> result;
+    vector<Transaction*> hot;
+    
+    if (filterType == "user") {
+        result = transactionArchive->getByUserID(value);
+        hot = transactionList->getByUserID(value);
+    } else if (filterType == "isbn") {
+        result = transactionArchive->getByISBN(value);
+        hot = transactionList->getByISBN(value);
+    } else if (filterType == "date") {
+        time_t from = Transaction::parseTimestamp(value + " 00:00:00");
+        if (from == 0) return result;
+        time_t to = from + 24 * 60 * 60 - 1;
+        result = transactionArchive->getByTimeRange(from, to);
+        hot = transactionList->getByTimeRange(from, to);
+    }
     
-    for (Book* book : books) {
-        cout << left << setw(20) << book->getISBN()
-             << setw(40) << book->getTitle().substr(0, 37)
-             << setw(30) << book->getAuthor().substr(0, 27)
-             << setw(10) << book->getAvailableCopies() << "\n";
+    for (Transaction* trans : hot) {
+        result.push_back(*trans);
     }
     
-    cout << string(120, '=') << "\n";
-    cout << "Total Available Books: " << books.size() << "\n";
+    return result;
+}
+
+// ============ ADMIN OPERATIONS - NEAR-DUPLICATES ============
+
+vector<vector<Book*>> LibraryManager::findNearDuplicates() {
+    RWLock::ReadGuard catalog(catalogLock);
+    return clusterNearDuplicates();
 }
 
-void LibraryManager::displayAllBooks() {
+vector<vector<Book*>> LibraryManager::clusterNearDuplicates() {
     vector<Book*> books = bookTree->getAllBooksSorted();
+    DuplicateDetector detector;
+    for (Book* book : books) {
+        detector.add(book->getTitle(), book->getAuthor());
+    }
     
-    if (books.empty()) {
-        cout << "No books in library.\n";
-        return;
+    vector<vector<Book*>> clusters;
+    for (const vector<size_t>& cluster : detector.findClusters(NEAR_DUPLICATE_SIMILARITY)) {
+        vector<Book*> group;
+        for (size_t record : cluster) {
+            group.push_back(books[record]);
+        }
+        clusters.push_back(group);
+    }
+    return clusters;
+}
+
+int LibraryManager::displayNearDuplicates() {
+    if (!authManager || !authManager->isAdmin()) {
+        out() << "Access Denied: Admin privileges required.\n";
+        return 0;
     }
     
-    cout << "\n" << string(130, '=') << "\n";
-    cout << "ALL BOOKS\n";
-    cout << string(130, '=') << "\n";
+    RWLock::ReadGuard catalog(catalogLock);
+    vector<vector<Book*>> clusters = clusterNearDuplicates();
+    
+    out() << "\n" << string(100, '=') << "\n";
+    out() << "NEAR-DUPLICATE TITLES\n";
+    out() << string(100, '=') << "\n";
+    
+    for (size_t i = 0; i < clusters.size(); i++) {
+        out() << "Cluster " << (i + 1) << " (" << clusters[i].size() << " books)\n";
+        for (Book* book : clusters[i]) {
+            out() << "  " << left << setw(20) << book->getISBN()
+                  << setw(45) << book->getTitle().substr(0, 42)
+                  << book->getAuthor();
+            if (!book->getEditionOf().empty()) {
+                out() << "  [edition of " << book->getEditionOf() << "]";
+            }
+            out() << "\n";
+        }
+        out() << "\n";
+    }
     
-    cout << left << setw(20) << "ISBN"
-         << setw(40) << "Title"
-         << setw(30) << "Author"
-         << setw(10) << "Total"
-         << setw(10) << "Available" << "\n";
-    cout << string(130, '=') << "\n";
+    if (clusters.empty()) {
+        out() << "No near-duplicate titles found.\n";
+    }
+    out() << string(100, '=') << "\n";
+    return (int)clusters.size();
+}
+
+int LibraryManager::linkNearDuplicateEditions() {
+    if (!authManager || !authManager->isAdmin()) {
+        out() << "Access Denied: Admin privileges required.\n";
+        return 0;
+    }
+    
+    RWLock::WriteGuard catalog(catalogLock);
+    int linked = 0;
+    for (const vector<Book*>& cluster : clusterNearDuplicates()) {
+        for (size_t i = 1; i < cluster.size(); i++) {
+            if (cluster[i]->getEditionOf() != cluster[0]->getISBN()) {
+                cluster[i]->setEditionOf(cluster[0]->getISBN());
+                linked++;
+            }
+        }
+    }
+    return linked;
+}
+
+// ============ USER OPERATIONS - BROWSE & SEARCH ============
+
+static const char* orderName(CatalogOrder::SortKey order) {
+    switch (order) {
+        case CatalogOrder::BY_TITLE: return "title";
+        case CatalogOrder::BY_AUTHOR: return "author";
+        case CatalogOrder::BY_AVAILABLE_COPIES: return "copies available";
+        default: return "ISBN";
+    }
+}
+
+int LibraryManager::displayCatalogPage(string heading, CatalogOrder::SortKey order, bool availableOnly, int page) {
+    RWLock::ReadGuard catalog(catalogLock);
+    size_t total = catalogOrder->getCount(availableOnly);
+    if (total == 0) {
+        out() << (availableOnly ? "No available books.\n" : "No books in library.\n");
+        return 0;
+    }
+    
+    int pages = (int)((total + BOOKS_PER_PAGE - 1) / BOOKS_PER_PAGE);
+    page = max(0, min(page, pages - 1));
+    vector<Book*> books = catalogOrder->getPage(order, availableOnly, (size_t)page * BOOKS_PER_PAGE, BOOKS_PER_PAGE);
+    
+    out() << "\n" << string(130, '=') << "\n";
+    out() << heading << " (by " << orderName(order) << ")\n";
+    out() << string(130, '=') << "\n";
+    
+    out() << left << setw(20) << "ISBN"
+          << setw(40) << "Title"
+          << setw(30) << "Author"
+          << setw(10) << "Total"
+          << setw(10) << "Available" << "\n";
+    out() << string(130, '=') << "\n";
     
     for (Book* book : books) {
-        cout << left << setw(20) << book->getISBN()
-             << setw(40) << book->getTitle().substr(0, 37)
-             << setw(30) << book->getAuthor().substr(0, 27)
-             << setw(10) << book->getQuantity()
-             << setw(10) << book->getAvailableCopies() << "\n";
+        out() << left << setw(20) << book->getISBN()
+              << setw(40) << book->getTitle().substr(0, 37)
+              << setw(30) << book->getAuthor().substr(0, 27)
+              << setw(10) << book->getQuantity()
+              << setw(10) << book->getAvailableCopies() << "\n";
     }
     
-    cout << string(130, '=') << "\n";
-    cout << "Total Books: " << books.size() << "\n";
+    out() << string(130, '=') << "\n";
+    out() << (availableOnly ? "Total Available Books: " : "Total Books: ") << total
+          << "    Page " << (page + 1) << " of " << pages << "\n";
+    return pages;
+}
+
+int LibraryManager::displayAvailableBooks(CatalogOrder::SortKey order, int page) {
+    return displayCatalogPage("AVAILABLE BOOKS", order, true, page);
+}
+
+int LibraryManager::displayAllBooks(CatalogOrder::SortKey order, int page) {
+    return displayCatalogPage("ALL BOOKS", order, false, page);
 }
 
 vector<Book*> LibraryManager::searchBooks(string query, string type) {
-    if (type == "title") {
-        return searchEngine->searchByTitle(query);
-    } else if (type == "author") {
-        return searchEngine->searchByAuthor(query);
+    RWLock::ReadGuard catalog(catalogLock);
+    if (type == "title" || type == "author" || type == "keyword") {
+        vector<Book*> results;
+        SearchEngine::Field field = SearchEngine::ANY_FIELD;
+        
+        if (type == "title") {
+            results = searchEngine->searchByTitle(query);
+            field = SearchEngine::TITLE;
+        } else if (type == "author") {
+            results = searchEngine->searchByAuthor(query);
+            field = SearchEngine::AUTHOR;
+        } else {
+            results = searchEngine->searchByKeyword(query);
+        }
+        
+        if (results.empty()) {
+            results = searchEngine->searchFuzzy(query, field);
+            if (!results.empty()) {
+                out() << "No exact matches. Showing closest spellings.\n";
+            }
+        }
+        return results;
     } else if (type == "isbn") {
         Book* book = searchEngine->searchByISBN(query);
         if (book != nullptr) {
             return vector<Book*>{book};
         }
         return vector<Book*>();
+    } else if (type == "prefix") {
+        return searchEngine->searchByPrefix(query, BOOKS_PER_PAGE);
+    } else if (type == "available") {
+        return searchEngine->searchByKeyword(query, true);
     }
     return searchEngine->searchByKeyword(query);
 }
 
+vector<vector<Book*>> LibraryManager::searchBooksBatch(const vector<string>& queries, string type) {
+    RWLock::ReadGuard catalog(catalogLock);
+    vector<vector<Book*>> results;
+    
+    if (type == "isbn") {
+        vector<Book*> books = searchEngine->searchByISBNs(queries);
+        results.resize(books.size());
+        for (size_t i = 0; i < books.size(); i++) {
+            if (books[i] != nullptr) {
+                results[i].push_back(books[i]);
+            }
+        }
+        return results;
+    } else if (type == "prefix") {
+        for (const string& query : queries) {
+            results.push_back(searchEngine->searchByPrefix(query, BOOKS_PER_PAGE));
+        }
+        return results;
+    }
+    
+    SearchEngine::Field field = SearchEngine::ANY_FIELD;
+    if (type == "title") {
+        field = SearchEngine::TITLE;
+    } else if (type == "author") {
+        field = SearchEngine::AUTHOR;
+    }
+    results = searchEngine->searchBatch(field, queries, type == "available");
+    
+    // Same misspelling fallback as searchBooks, run on this thread since it
+    // may rebuild the vocabulary
+    if (type == "title" || type == "author" || type == "keyword") {
+        unordered_map<string, vector<Book*>> corrected;
+        for (size_t i = 0; i < queries.size(); i++) {
+            if (!results[i].empty()) continue;
+            
+            auto it = corrected.find(queries[i]);
+            if (it == corrected.end()) {
+                it = corrected.insert(make_pair(queries[i], searchEngine->searchFuzzy(queries[i], field))).first;
+            }
+            results[i] = it->second;
+        }
+    }
+    return results;
+}
+
+vector<string> LibraryManager::suggestSearchTerms(string prefix) {
+    RWLock::ReadGuard catalog(catalogLock);
+    vector<string> suggestions = searchEngine->suggestCompletions(prefix, SUGGESTION_COUNT);
+    if (suggestions.empty()) {
+        suggestions = searchEngine->suggestCorrections(prefix, SUGGESTION_COUNT);
+    }
+    return suggestions;
+}
+
+vector<Book*> LibraryManager::searchAsYouType(string query, size_t& matchCount) {
+    RWLock::ReadGuard catalog(catalogLock);
+    return searchEngine->searchAsYouType(query, BOOKS_PER_PAGE, matchCount);
+}
+
+static void printFacetCounts(const string& label, const vector<FacetIndex::Count>& counts) {
+    out() << left << setw(12) << label;
+    if (counts.empty()) {
+        out() << "-";
+    }
+    for (size_t i = 0; i < counts.size(); i++) {
+        out() << (i > 0 ? ", " : "") << counts[i].value << " (" << counts[i].count << ")";
+    }
+    out() << "\n";
+}
+
+void LibraryManager::displayFacetedSearch(string query, const FacetIndex::Filter& filter) {
+    RWLock::ReadGuard catalog(catalogLock);
+    FacetIndex::Counts counts;
+    vector<Book*> books = searchEngine->searchFaceted(query, filter, counts);
+    
+    if (books.empty()) {
+        out() << "No books match these filters.\n";
+        return;
+    }
+    
+    out() << "\n" << string(120, '=') << "\n";
+    out() << "FILTERED SEARCH RESULTS\n";
+    out() << string(120, '=') << "\n";
+    
+    out() << left << setw(20) << "ISBN"
+          << setw(40) << "Title"
+          << setw(30) << "Author"
+          << setw(10) << "Copies"
+          << setw(10) << "Available" << "\n";
+    out() << string(120, '=') << "\n";
+    
+    for (Book* book : books) {
+        out() << left << setw(20) << book->getISBN()
+              << setw(40) << book->getTitle().substr(0, 37)
+              << setw(30) << book->getAuthor().substr(0, 27)
+              << setw(10) << book->getQuantity()
+              << setw(10) << book->getAvailableCopies() << "\n";
+    }
+    
+    out() << string(120, '=') << "\n";
+    out() << "Matches: " << counts.total << " (" << counts.available << " available)";
+    if (counts.total > books.size()) {
+        out() << ", showing the best " << books.size();
+    }
+    out() << "\n\n";
+    printFacetCounts("Authors:", counts.authors);
+    printFacetCounts("Publishers:", counts.publishers);
+    printFacetCounts("Copies:", counts.quantities);
+}
+
+void LibraryManager::displayAuthors() {
+    RWLock::ReadGuard catalog(catalogLock);
+    vector<uint32_t> authorIDs = AuthorRegistry::getInstance()->getSortedAuthors();
+    
+    out() << "\n" << string(60, '=') << "\n";
+    out() << "AUTHORS\n";
+    out() << string(60, '=') << "\n";
+    
+    out() << left << setw(50) << "Author" << setw(10) << "Titles" << "\n";
+    out() << string(60, '=') << "\n";
+    
+    int shown = 0;
+    for (uint32_t authorID : authorIDs) {
+        // Authors whose books have all been removed or re-credited stay registered
+        size_t titles = searchEngine->countBooksByAuthor(authorID);
+        if (titles == 0) continue;
+        
+        out() << left << setw(50) << AuthorRegistry::getInstance()->getName(authorID).substr(0, 47)
+              << setw(10) << titles << "\n";
+        shown++;
+    }
+    
+    out() << string(60, '=') << "\n";
+    out() << "Total Authors: " << shown << "\n";
+}
+
+void LibraryManager::displayBooksByAuthor(string name) {
+    RWLock::ReadGuard catalog(catalogLock);
+    uint32_t authorID;
+    if (!AuthorRegistry::getInstance()->find(name, authorID) || searchEngine->countBooksByAuthor(authorID) == 0) {
+        out() << "Error: Author not found.\n";
+        return;
+    }
+    
+    vector<Book*> books = searchEngine->searchByAuthorID(authorID);
+    
+    out() << "\n" << string(120, '=') << "\n";
+    out() << "TITLES BY " << AuthorRegistry::getInstance()->getName(authorID) << "\n";
+    out() << string(120, '=') << "\n";
+    
+    out() << left << setw(20) << "ISBN"
+          << setw(40) << "Title"
+          << setw(30) << "Author(s)"
+          << setw(10) << "Copies"
+          << setw(10) << "Available" << "\n";
+    out() << string(120, '=') << "\n";
+    
+    for (Book* book : books) {
+        out() << left << setw(20) << book->getISBN()
+              << setw(40) << book->getTitle().substr(0, 37)
+              << setw(30) << book->getAuthor().substr(0, 27)
+              << setw(10) << book->getQuantity()
+              << setw(10) << book->getAvailableCopies() << "\n";
+    }
+    
+    out() << string(120, '=') << "\n";
+    out() << "Total Titles: " << books.size() << "\n";
+}
+
 void LibraryManager::displayBookDetails(string isbn) {
+    RWLock::ReadGuard catalog(catalogLock);
     Book* book = bookTree->search(isbn);
     
     if (book == nullptr) {
-        cout << "Error: Book not found.\n";
+        out() << "Error: Book not found.\n";
         return;
     }
     
-    cout << "\n" << string(60, '=') << "\n";
-    cout << book->toString() << "\n";
-    cout << string(60, '=') << "\n";
+    out() << "\n" << string(60, '=') << "\n";
+    out() << book->toString() << "\n";
+    out() << "Times Borrowed: " << circulationStats->getBookBorrowCount(isbn) << "\n";
+    out() << string(60, '=') << "\n";
 }
 
 // ============ USER OPERATIONS - BORROW & RETURN ============
 
 bool LibraryManager::borrowBook(string isbn) {
     if (!authManager || !authManager->isUser()) {
-        cout << "Access Denied: Please login as user.\n";
+        out() << "Access Denied: Please login as user.\n";
         return false;
     }
     
+    RWLock::ReadGuard catalog(catalogLock);
+    RWLock::ReadGuard directory(userMap->getLock());
     User* currentUser = authManager->getCurrentUser();
     if (currentUser == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return false;
     }
     
+    // Checked and changed under the user's lock and then the book's, so a
+    // competing borrow sees either none of this loan or all of it
+    lock_guard<mutex> account(userLock(currentUser->getUserID()));
     if (!currentUser->canBorrow()) {
         if (currentUser->getBorrowedCount() >= MAX_BORROW_LIMIT) {
-            cout << "Error: You have reached the borrowing limit (" << MAX_BORROW_LIMIT << " books).\n";
+            out() << "Error: You have reached the borrowing limit (" << MAX_BORROW_LIMIT << " books).\n";
         } else {
-            cout << "Error: Your account is inactive.\n";
+            out() << "Error: Your account is inactive.\n";
         }
         return false;
     }
     
     Book* book = bookTree->search(isbn);
     if (book == nullptr) {
-        cout << "Error: Book not found.\n";
+        out() << "Error: Book not found.\n";
         return false;
     }
     
+    lock_guard<mutex> copies(bookLock(isbn));
     if (!book->getAvailability()) {
-        cout << "Error: Book is not available.\n";
+        out() << "Error: Book is not available.\n";
         return false;
     }
     
     if (currentUser->hasBorrowedBook(isbn)) {
-        cout << "Error: You have already borrowed this book.\n";
+        out() << "Error: You have already borrowed this book.\n";
         return false;
     }
     
+    int availableBefore = book->getAvailableCopies();
     book->borrowBook();
     currentUser->addBorrowedBook(isbn);
+    circulationStats->onCopiesChanged(book->getQuantity(), availableBefore,
+                                      book->getQuantity(), book->getAvailableCopies());
+    catalogOrder->onCopiesChanged(book);
     
     Transaction* trans = new Transaction(
         currentUser->getUserID(),
         isbn,
-        "BORROW",
+        Transaction::BORROW,
         currentUser->getFullName(),
         book->getTitle()
     );
-    transactionList->append(trans);
+    transactionIngestor->publish(trans);
+    circulationStats->recordTransaction(trans);
     
-    cout << "Success: Book borrowed successfully!\n";
+    out() << "Success: Book borrowed successfully!\n";
     return true;
 }
 
 bool LibraryManager::returnBook(string isbn) {
     if (!authManager || !authManager->isUser()) {
-        cout << "Access Denied: Please login as user.\n";
+        out() << "Access Denied: Please login as user.\n";
         return false;
     }
     
+    RWLock::ReadGuard catalog(catalogLock);
+    RWLock::ReadGuard directory(userMap->getLock());
     User* currentUser = authManager->getCurrentUser();
     if (currentUser == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return false;
     }
     
+    lock_guard<mutex> account(userLock(currentUser->getUserID()));
     if (!currentUser->hasBorrowedBook(isbn)) {
-        cout << "Error: You have not borrowed this book.\n";
+        out() << "Error: You have not borrowed this book.\n";
         return false;
     }
     
     Book* book = bookTree->search(isbn);
     if (book == nullptr) {
-        cout << "Error: Book not found.\n";
+        out() << "Error: Book not found.\n";
         return false;
     }
     
+    lock_guard<mutex> copies(bookLock(isbn));
+    int availableBefore = book->getAvailableCopies();
     book->returnBook();
     currentUser->removeBorrowedBook(isbn);
+    circulationStats->onCopiesChanged(book->getQuantity(), availableBefore,
+                                      book->getQuantity(), book->getAvailableCopies());
+    catalogOrder->onCopiesChanged(book);
     
     Transaction* trans = new Transaction(
         currentUser->getUserID(),
         isbn,
-        "RETURN",
+        Transaction::RETURN,
         currentUser->getFullName(),
         book->getTitle()
     );
-    transactionList->append(trans);
+    transactionIngestor->publish(trans);
+    circulationStats->recordTransaction(trans);
     
-    cout << "Success: Book returned successfully!\n";
+    out() << "Success: Book returned successfully!\n";
     return true;
 }
 
 void LibraryManager::displayMyBorrowedBooks() {
     if (!authManager || !authManager->isUser()) {
-        cout << "Access Denied: Please login as user.\n";
+        out() << "Access Denied: Please login as user.\n";
         return;
     }
     
+    RWLock::ReadGuard catalog(catalogLock);
+    RWLock::ReadGuard directory(userMap->getLock());
     User* currentUser = authManager->getCurrentUser();
     if (currentUser == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return;
     }
     
-    set<string> borrowedISBNs = currentUser->getBorrowedISBNs();
+    set<string> borrowedISBNs;
+    {
+        lock_guard<mutex> account(userLock(currentUser->getUserID()));
+        borrowedISBNs = currentUser->getBorrowedISBNs();
+    }
     
     if (borrowedISBNs.empty()) {
-        cout << "You have no borrowed books.\n";
+        out() << "You have no borrowed books.\n";
         return;
     }
     
-    cout << "\n" << string(100, '=') << "\n";
-    cout << "MY BORROWED BOOKS\n";
-    cout << string(100, '=') << "\n";
+    out() << "\n" << string(100, '=') << "\n";
+    out() << "MY BORROWED BOOKS\n";
+    out() << string(100, '=') << "\n";
     
-    cout << left << setw(20) << "ISBN"
-         << setw(50) << "Title"
-         << setw(30) << "Author" << "\n";
-    cout << string(100, '=') << "\n";
+    out() << left << setw(20) << "ISBN"
+          << setw(50) << "Title"
+          << setw(30) << "Author" << "\n";
+    out() << string(100, '=') << "\n";
     
     for (const string& isbn : borrowedISBNs) {
         Book* book = bookTree->search(isbn);
         if (book != nullptr) {
-            cout << left << setw(20) << book->getISBN()
-                 << setw(50) << book->getTitle().substr(0, 47)
-                 << setw(30) << book->getAuthor().substr(0, 27) << "\n";
+            out() << left << setw(20) << book->getISBN()
+                  << setw(50) << book->getTitle().substr(0, 47)
+                  << setw(30) << book->getAuthor().substr(0, 27) << "\n";
         }
     }
     
-    cout << string(100, '=') << "\n";
-    cout << "Total: " << borrowedISBNs.size() << "/" << MAX_BORROW_LIMIT << " books\n";
+    out() << string(100, '=') << "\n";
+    out() << "Total: " << borrowedISBNs.size() << "/" << MAX_BORROW_LIMIT << " books\n";
 }
 
 void LibraryManager::displayMyTransactionHistory() {
     if (!authManager || !authManager->isUser()) {
-        cout << "Access Denied: Please login as user.\n";
+        out() << "Access Denied: Please login as user.\n";
         return;
     }
     
+    RWLock::ReadGuard catalog(catalogLock);
+    RWLock::ReadGuard directory(userMap->getLock());
     User* currentUser = authManager->getCurrentUser();
     if (currentUser == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return;
     }
     
-    vector<Transaction*> transactions = transactionList->getByUserID(currentUser->getUserID());
+    vector<Transaction> transactions = collectHistory("user", currentUser->getUserID());
     
     if (transactions.empty()) {
-        cout << "No transaction history.\n";
+        out() << "No transaction history.\n";
         return;
     }
     
-    cout << "\n" << string(120, '=') << "\n";
-    cout << "MY TRANSACTION HISTORY\n";
-    cout << string(120, '=') << "\n";
-    
-    cout << left << setw(12) << "Trans ID"
-         << setw(40) << "Book"
-         << setw(10) << "Type"
-         << setw(20) << "Timestamp" << "\n";
-    cout << string(120, '=') << "\n";
-    
-    for (Transaction* trans : transactions) {
-        cout << left << setw(12) << trans->getTransactionID()
-             << setw(40) << trans->getBookTitle().substr(0, 37)
-             << setw(10) << trans->getType()
-             << setw(20) << trans->getTimestamp() << "\n";
+    out() << "\n" << string(120, '=') << "\n";
+    out() << "MY TRANSACTION HISTORY\n";
+    out() << string(120, '=') << "\n";
+    
+    out() << left << setw(12) << "Trans ID"
+          << setw(40) << "Book"
+          << setw(10) << "Type"
+          << setw(20) << "Timestamp" << "\n";
+    out() << string(120, '=') << "\n";
+    
+    for (const Transaction& trans : transactions) {
+        out() << left << setw(12) << trans.getTransactionID()
+              << setw(40) << trans.getBookTitle().substr(0, 37)
+              << setw(10) << trans.getTypeName()
+              << setw(20) << trans.getTimestamp() << "\n";
     }
     
-    cout << string(120, '=') << "\n";
-    cout << "Total Transactions: " << transactions.size() << "\n";
+    out() << string(120, '=') << "\n";
+    out() << "Total Transactions: " << transactions.size() << "\n";
 }
 
 // ============ USER OPERATIONS - PROFILE ============
 
 void LibraryManager::displayMyProfile() {
     if (!authManager || !authManager->isUser()) {
-        cout << "Access Denied: Please login as user.\n";
+        out() << "Access Denied: Please login as user.\n";
         return;
     }
     
+    RWLock::ReadGuard directory(userMap->getLock());
     User* currentUser = authManager->getCurrentUser();
     if (currentUser == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return;
     }
     
-    cout << "\n" << string(60, '=') << "\n";
-    cout << currentUser->toString() << "\n";
-    cout << string(60, '=') << "\n";
+    lock_guard<mutex> account(userLock(currentUser->getUserID()));
+    out() << "\n" << string(60, '=') << "\n";
+    out() << currentUser->toString() << "\n";
+    out() << string(60, '=') << "\n";
 }
 
 bool LibraryManager::updateMyContact(string email, string phone) {
     if (!authManager || !authManager->isUser()) {
-        cout << "Access Denied: Please login as user.\n";
+        out() << "Access Denied: Please login as user.\n";
         return false;
     }
     
+    RWLock::ReadGuard directory(userMap->getLock());
     User* currentUser = authManager->getCurrentUser();
     if (currentUser == nullptr) {
-        cout << "Error: User not found.\n";
+        out() << "Error: User not found.\n";
         return false;
     }
     
+    lock_guard<mutex> account(userLock(currentUser->getUserID()));
     currentUser->updateContact(email, phone);
     return true;
 }
 
 // ============ DATA PERSISTENCE ============
 
+// Exclusive, so the files never catch a loan with the book updated and
+// the user not yet
 bool LibraryManager::saveAllData() {
+    RWLock::WriteGuard catalog(catalogLock);
+    RWLock::WriteGuard directory(userMap->getLock());
     FileHandler::createDirectory(DATA_DIR);
     
+    transactionIngestor->flush();
+    archiveColdTransactions();
+    
     bool success = true;
     success &= FileHandler::saveBooks(bookTree, BOOKS_FILE);
     success &= FileHandler::saveUsers(userMap, USERS_FILE);
     success &= FileHandler::saveTransactions(transactionList, TRANSACTIONS_FILE);
+    success &= FileHandler::saveStatistics(circulationStats, STATISTICS_FILE);
+    success &= searchEngine->saveIndex(INDEX_DIR);
     
     return success;
 }
 
+void LibraryManager::archiveColdTransactions() {
+    FileHandler::createDirectory(HISTORY_DIR);
+    
+    while (transactionList->getCount() >= HOT_TRANSACTION_WINDOW + HISTORY_SEGMENT_SIZE) {
+        vector<Transaction*> oldest = transactionList->detachOldest(HISTORY_SEGMENT_SIZE);
+        bool archived = transactionArchive->archive(oldest);
+        
+        if (!archived) {
+            // Keep them in memory rather than lose history
+            for (auto it = oldest.rbegin(); it != oldest.rend(); ++it) {
+                transactionList->prepend(*it);
+            }
+            break;
+        }
+        
+        for (Transaction* trans : oldest) {
+            delete trans;
+        }
+    }
+}
+
 bool LibraryManager::loadAllData() {
+    RWLock::WriteGuard catalog(catalogLock);
+    RWLock::WriteGuard directory(userMap->getLock());
     bool booksLoaded = FileHandler::loadBooks(bookTree, BOOKS_FILE);
     bool usersLoaded = FileHandler::loadUsers(userMap, USERS_FILE);
-    bool transLoaded = FileHandler::loadTransactions(transactionList, TRANSACTIONS_FILE);
+    bool archiveLoaded = transactionArchive->load();
+    bool transLoaded = FileHandler::loadTransactions(transactionList, TRANSACTIONS_FILE,
+                                                     transactionArchive->getLastID());
     
-    if (booksLoaded) {
+    // Reuse the saved index segments when they still match the catalog
+    if (booksLoaded && !searchEngine->loadIndex(INDEX_DIR)) {
         searchEngine->buildIndices();
     }
     
-    return booksLoaded || usersLoaded || transLoaded;
+    vector<Book*> books = bookTree->getAllBooksSorted();
+    circulationStats->rebuildCopies(books);
+    catalogOrder->rebuild(books);
+    if (!FileHandler::loadStatistics(circulationStats, STATISTICS_FILE)) {
+        // No saved counters yet: derive them once from the full history,
+        // archived segments first and then the in-memory window
+        circulationStats->clearCounters();
+        CirculationStats* stats = circulationStats;
+        transactionArchive->forEach([stats](const Transaction& trans) {
+            stats->recordTransaction(&trans);
+        });
+        for (Transaction* trans : transactionList->getAll()) {
+            circulationStats->recordTransaction(trans);
+        }
+    }
+    
+    return booksLoaded || usersLoaded || archiveLoaded || transLoaded;
 }
 
 void LibraryManager::initializeSampleData() {
+    // Seeded before anyone logs in, so in a session of its own with admin rights
+    AuthManager::Session seeding;
+    seeding.role = AuthManager::ADMIN;
+    AuthManager::setActiveSession(&seeding);
+    
     addBook("978-0-13-468599-1", "The C++ Programming Language", "Bjarne Stroustrup", 5);
     addBook("978-0-321-56384-2", "Effective C++", "Scott Meyers", 3);
     addBook("978-0-262-03384-8", "Introduction to Algorithms", "Thomas Cormen", 4);
     addBook("978-0-201-35088-5", "Data Structures and Algorithms", "Alfred Aho", 3);
     addBook("978-0-672-32692-7", "Data Structures Using C++", "D.S. Malik", 4);
-    addBook("978-0-201-63361-0", "Design Patterns", "Gang of Four", 2);
+    addBook("978-0-201-63361-0", "Design Patterns", "Erich Gamma; Richard Helm; Ralph Johnson; John Vlissides", 2);
     addBook("978-0-596-00927-5", "Head First Design Patterns", "Eric Freeman", 3);
     addBook("978-0-201-89683-1", "The Art of Computer Programming Vol 1", "Donald Knuth", 2);
-    addBook("978-0-13-110362-7", "The C Programming Language", "Brian Kernighan", 5);
+    addBook("978-0-13-110362-7", "The C Programming Language", "Brian Kernighan; Dennis Ritchie", 5);
     addBook("978-0-134-68599-4", "Clean Code", "Robert Martin", 4);
     
+    AuthManager::setActiveSession(nullptr);
     saveAllData();
 }
 
 // ============ UTILITY ============
 
 int LibraryManager::getTotalBooks() {
+    RWLock::ReadGuard catalog(catalogLock);
     return bookTree->getCount();
 }
 
 int LibraryManager::getTotalAvailableBooks() {
-    int count = 0;
-    vector<Book*> books = bookTree->getAllBooksSorted();
-    for (Book* book : books) {
-        if (book->getAvailability()) {
-            count++;
-        }
-    }
-    return count;
+    return circulationStats->getTitlesAvailable();
 }
 
 int LibraryManager::getTotalUsers() {
+    RWLock::ReadGuard directory(userMap->getLock());
     return userMap->getCount();
 }
 
 int LibraryManager::getTotalTransactions() {
-    return transactionList->getCount();
+    RWLock::ReadGuard catalog(catalogLock);
+    transactionIngestor->flush();
+    return transactionList->getCount() + (int)transactionArchive->getCount();
 }
@@ -6,9 +6,18 @@
 #include "../utils/TransactionList.h"
 #include "../utils/SearchEngine.h"
 #include "../utils/FileHandler.h"
+#include "../utils/CirculationStats.h"
+#include "../utils/TransactionIngestor.h"
+#include "../utils/TransactionArchive.h"
+#include "../utils/DuplicateDetector.h"
+#include "../utils/AuthorRegistry.h"
+#include "../utils/CatalogOrder.h"
+#include "../utils/RWLock.h"
 #include "AuthManager.h"
 #include <string>
 #include <vector>
+#include <ostream>
+#include <mutex>
 
 class LibraryManager {
 private:
@@ -16,16 +25,44 @@ private:
     BookBST* bookTree;
     UserHashMap* userMap;
     TransactionList* transactionList;
+    TransactionIngestor* transactionIngestor;
+    TransactionArchive* transactionArchive;
     SearchEngine* searchEngine;
+    CirculationStats* circulationStats;
+    CatalogOrder* catalogOrder;
     AuthManager* authManager;
     
+    // Read-only operations hold catalogLock shared; so do borrows and
+    // returns, which then lock only the user and the book they change
+    // through the striped mutexes, user first. Patrons borrowing different
+    // books run in parallel, while two borrows of one book serialize on its
+    // stripe and only one gets the last copy. Adding, removing or re-filing
+    // books and loading or saving the data hold catalogLock exclusively.
+    // Accounts are guarded by the user map's lock, taken after catalogLock.
+    static const int LOCK_STRIPES = 64;
+    RWLock catalogLock;
+    mutex bookLocks[LOCK_STRIPES];
+    mutex userLocks[LOCK_STRIPES];
+    
     LibraryManager();
+    mutex& bookLock(const string& isbn);
+    mutex& userLock(const string& userID);
     void initializeDataStructures();
+    void archiveColdTransactions();
+    vector<Transaction> collectHistory(string filterType, string value);
+    int displayCatalogPage(string heading, CatalogOrder::SortKey order, bool availableOnly, int page);
+    vector<vector<Book*>> clusterNearDuplicates();
 
 public:
     static LibraryManager* getInstance();
     ~LibraryManager();
     void setAuthManager(AuthManager* auth);
+    // Sends the calling thread's output to stream instead of cout, so a
+    // server worker can return it to its client (nullptr restores cout)
+    static void setOutput(ostream* stream);
+    // Held shared by a caller that keeps using the Book pointers a search
+    // returned while other sessions may be removing books
+    RWLock& getCatalogLock() { return catalogLock; }
     
     // Admin Operations - Book Management
     bool addBook(string isbn, string title, string author, int quantity);
@@ -45,11 +82,30 @@ public:
     void displayAllTransactions();
     void displaySystemStatistics();
     void displayBorrowingReport();
+    void displayTransactionHistory(string filterType, string value);
+    
+    // Near-duplicate records (same work under different ISBNs), lowest ISBN
+    // first in each cluster; linking makes the rest editions of that book
+    vector<vector<Book*>> findNearDuplicates();
+    int displayNearDuplicates();
+    int linkNearDuplicateEditions();
     
     // User Operations - Browse & Search
-    void displayAvailableBooks();
-    void displayAllBooks();
+    // One page of BOOKS_PER_PAGE books in the chosen order; both return the
+    // number of pages (0 when there is nothing to list)
+    int displayAvailableBooks(CatalogOrder::SortKey order = CatalogOrder::BY_TITLE, int page = 0);
+    int displayAllBooks(CatalogOrder::SortKey order = CatalogOrder::BY_ISBN, int page = 0);
     vector<Book*> searchBooks(string query, string type);
+    // Many queries of one type at once (kiosk lookups, catalog sync);
+    // results[i] answers queries[i]
+    vector<vector<Book*>> searchBooksBatch(const vector<string>& queries, string type);
+    vector<string> suggestSearchTerms(string prefix);
+    // Top BOOKS_PER_PAGE matches for the query typed so far
+    vector<Book*> searchAsYouType(string query, size_t& matchCount);
+    void displayFacetedSearch(string query, const FacetIndex::Filter& filter);
+    // Authors with at least one book, by surname, and one author's titles
+    void displayAuthors();
+    void displayBooksByAuthor(string name);
     void displayBookDetails(string isbn);
     
     // User Operations - Borrow & Return
@@ -0,0 +1,804 @@
+#include "LibraryServer.h"
+#include "../Config.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+#ifdef __linux__
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <netdb.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #include <cstring>
+#endif
+
+// epoll keys of the two descriptors that are not connections
+static const uint64_t LISTEN_KEY = 0;
+static const uint64_t WAKE_KEY = 1;
+static const size_t READ_CHUNK = 4096;
+static const int MAX_EVENTS = 64;
+
+const LibraryServer::Command LibraryServer::COMMANDS[] = {
+    {"HELP", 0, AuthManager::NONE, "", false},
+    {"PING", 0, AuthManager::NONE, "", false},
+    {"QUIT", 0, AuthManager::NONE, "", false},
+    {"LOGIN", 2, AuthManager::NONE, "username|password", false},
+    {"ADMIN", 2, AuthManager::NONE, "username|password", false},
+    {"LOGOUT", 0, AuthManager::NONE, "", false},
+    {"REGISTER", 5, AuthManager::NONE, "username|password|full name|email|phone", true},
+    {"SEARCH", 2, AuthManager::NONE, "title, author, keyword or isbn|query", false},
+    {"BOOKS", 3, AuthManager::NONE, "all or available|isbn, title, author or copies|page", false},
+    {"BOOK", 1, AuthManager::NONE, "isbn", false},
+    {"AUTHORS", 0, AuthManager::NONE, "", false},
+    {"AUTHOR", 1, AuthManager::NONE, "name", false},
+    {"BORROW", 1, AuthManager::USER, "isbn", true},
+    {"RETURN", 1, AuthManager::USER, "isbn", true},
+    {"MYBOOKS", 0, AuthManager::USER, "", false},
+    {"MYHISTORY", 0, AuthManager::USER, "", false},
+    {"PROFILE", 0, AuthManager::USER, "", false},
+    {"CONTACT", 2, AuthManager::USER, "email|phone", true},
+    {"ADDBOOK", 4, AuthManager::ADMIN, "isbn|title|authors|quantity", true},
+    {"REMOVEBOOK", 1, AuthManager::ADMIN, "isbn", true},
+    {"UPDATEBOOK", 3, AuthManager::ADMIN, "isbn|title|authors", true},
+    {"QUANTITY", 2, AuthManager::ADMIN, "isbn|quantity", true},
+    {"USERS", 0, AuthManager::ADMIN, "", false},
+    {"USER", 1, AuthManager::ADMIN, "user id", false},
+    {"ACTIVATE", 1, AuthManager::ADMIN, "user id", true},
+    {"DEACTIVATE", 1, AuthManager::ADMIN, "user id", true},
+    {"REMOVEUSER", 1, AuthManager::ADMIN, "user id", true},
+    {"TRANSACTIONS", 0, AuthManager::ADMIN, "", false},
+    {"HISTORY", 2, AuthManager::ADMIN, "user, isbn or date|value", false},
+    {"STATS", 0, AuthManager::ADMIN, "", false},
+    {"REPORT", 0, AuthManager::ADMIN, "", false},
+    {"SAVE", 0, AuthManager::ADMIN, "", false},
+    {nullptr, 0, AuthManager::NONE, nullptr, false}
+};
+
+// Unlike FileHandler::split, keeps empty fields (an empty phone number)
+static vector<string> splitFields(const string& line) {
+    vector<string> fields(1);
+    for (char c : line) {
+        if (c == PROTOCOL_DELIMITER) {
+            fields.push_back("");
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+static bool parseNumber(const string& text, int& value) {
+    if (text.empty() || text.size() > 9) return false;
+    
+    value = 0;
+    for (char c : text) {
+        if (!isdigit((unsigned char)c)) return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+static bool reportSuccess(bool ok, ostream& body, const string& message) {
+    if (ok) {
+        body << "Success: " << message << "\n";
+    }
+    return ok;
+}
+
+LibraryServer::LibraryServer(LibraryManager* manager, AuthManager* authManager)
+    : library(manager), auth(authManager), listenFD(-1), epollFD(-1), wakeFD(-1), nextConnectionID(WAKE_KEY + 1),
+      running(false), dirty(false), lastSave(chrono::steady_clock::now()), workersStopping(false) {}
+
+// ============ REQUEST HANDLING ============
+
+string LibraryServer::execute(const string& request, AuthManager::Session* session, bool& hangUp) {
+    vector<string> fields = splitFields(request);
+    stringstream body;
+    
+    // LibraryManager and AuthManager do their own locking, so workers run
+    // requests side by side
+    AuthManager::setActiveSession(session);
+    LibraryManager::setOutput(&body);
+    bool ok = handle(fields, body, hangUp);
+    LibraryManager::setOutput(nullptr);
+    AuthManager::setActiveSession(nullptr);
+    
+    // Raised before the result is queued, so the event loop sees it on wakeup
+    const Command* command = findCommand(fields[0]);
+    if (ok && command != nullptr && command->mutates) {
+        dirty = true;
+    }
+    
+    return formatResponse(ok, body.str());
+}
+
+const LibraryServer::Command* LibraryServer::findCommand(string verb) {
+    transform(verb.begin(), verb.end(), verb.begin(), ::toupper);
+    
+    const Command* command = COMMANDS;
+    while (command->verb != nullptr && verb != command->verb) {
+        command++;
+    }
+    return command->verb != nullptr ? command : nullptr;
+}
+
+bool LibraryServer::handle(const vector<string>& fields, ostream& body, bool& hangUp) {
+    const Command* command = findCommand(fields[0]);
+    if (command == nullptr) {
+        body << "Error: Unknown command '" << fields[0] << "'. Send HELP for the list.\n";
+        return false;
+    }
+    string verb = command->verb;
+    if (fields.size() != command->arguments + 1) {
+        body << "Usage: " << command->verb << (command->arguments > 0 ? "|" : "") << command->usage << "\n";
+        return false;
+    }
+    if (command->role == AuthManager::ADMIN && !auth->isAdmin()) {
+        body << "Access Denied: Admin privileges required.\n";
+        return false;
+    }
+    if (command->role == AuthManager::USER && !auth->isUser()) {
+        body << "Access Denied: Please login as user.\n";
+        return false;
+    }
+    
+    if (verb == "HELP") {
+        for (const Command* entry = COMMANDS; entry->verb != nullptr; entry++) {
+            body << entry->verb << (entry->arguments > 0 ? "|" : "") << entry->usage << "\n";
+        }
+        return true;
+    }
+    if (verb == "PING") {
+        body << "PONG\n";
+        return true;
+    }
+    if (verb == "QUIT") {
+        hangUp = true;
+        body << "Goodbye.\n";
+        return true;
+    }
+    
+    // Sessions
+    if (verb == "LOGIN") {
+        // Keeps the account from being removed before its name is read
+        RWLock::ReadGuard directory(library->getUserMap()->getLock());
+        if (!auth->loginAsUser(fields[1], fields[2])) {
+            body << "Error: Invalid credentials or inactive account.\n";
+            return false;
+        }
+        body << "Success: Login successful! Welcome, " << auth->getCurrentUser()->getFullName() << "!\n";
+        return true;
+    }
+    if (verb == "ADMIN") {
+        if (!auth->loginAsAdmin(fields[1], fields[2])) {
+            body << "Error: Invalid admin credentials.\n";
+            return false;
+        }
+        body << "Success: Admin login successful!\n";
+        return true;
+    }
+    if (verb == "LOGOUT") {
+        auth->logout();
+        body << "Success: Logged out.\n";
+        return true;
+    }
+    if (verb == "REGISTER") {
+        if (!auth->isUsernameAvailable(fields[1])) {
+            body << "Error: Username already taken.\n";
+            return false;
+        }
+        if (!auth->validatePassword(fields[2])) {
+            body << "Error: Password must be at least " << MIN_PASSWORD_LENGTH << " characters.\n";
+            return false;
+        }
+        if (!auth->registerUser(fields[1], fields[2], fields[3], fields[4], fields[5])) {
+            body << "Error: Registration failed.\n";
+            return false;
+        }
+        body << "Success: Registration successful! You can now login.\n";
+        return true;
+    }
+    
+    // Browse & search
+    if (verb == "SEARCH") {
+        string type = fields[1];
+        transform(type.begin(), type.end(), type.begin(), ::tolower);
+        if (type != "title" && type != "author" && type != "keyword" && type != "isbn") {
+            body << "Error: Search type must be title, author, keyword or isbn.\n";
+            return false;
+        }
+        RWLock::ReadGuard catalog(library->getCatalogLock());
+        for (Book* book : library->searchBooks(fields[2], type)) {
+            body << formatBook(book);
+        }
+        return true;
+    }
+    if (verb == "BOOKS") {
+        string order = fields[2];
+        transform(order.begin(), order.end(), order.begin(), ::tolower);
+        CatalogOrder::SortKey key;
+        if (order == "isbn") {
+            key = CatalogOrder::BY_ISBN;
+        } else if (order == "title") {
+            key = CatalogOrder::BY_TITLE;
+        } else if (order == "author") {
+            key = CatalogOrder::BY_AUTHOR;
+        } else if (order == "copies") {
+            key = CatalogOrder::BY_AVAILABLE_COPIES;
+        } else {
+            body << "Error: Order must be isbn, title, author or copies.\n";
+            return false;
+        }
+        
+        int page;
+        if (!parseNumber(fields[3], page) || page < 1) {
+            body << "Error: Page must be a number from 1.\n";
+            return false;
+        }
+        if (fields[1] == "all") {
+            library->displayAllBooks(key, page - 1);
+        } else if (fields[1] == "available") {
+            library->displayAvailableBooks(key, page - 1);
+        } else {
+            body << "Error: Listing must be all or available.\n";
+            return false;
+        }
+        return true;
+    }
+    if (verb == "BOOK") {
+        library->displayBookDetails(fields[1]);
+        return true;
+    }
+    if (verb == "AUTHORS") {
+        library->displayAuthors();
+        return true;
+    }
+    if (verb == "AUTHOR") {
+        library->displayBooksByAuthor(fields[1]);
+        return true;
+    }
+    
+    // Patron operations
+    if (verb == "BORROW") {
+        return library->borrowBook(fields[1]);
+    }
+    if (verb == "RETURN") {
+        return library->returnBook(fields[1]);
+    }
+    if (verb == "MYBOOKS") {
+        library->displayMyBorrowedBooks();
+        return true;
+    }
+    if (verb == "MYHISTORY") {
+        library->displayMyTransactionHistory();
+        return true;
+    }
+    if (verb == "PROFILE") {
+        library->displayMyProfile();
+        return true;
+    }
+    if (verb == "CONTACT") {
+        return reportSuccess(library->updateMyContact(fields[1], fields[2]), body, "Contact details updated.");
+    }
+    
+    // Administration
+    if (verb == "ADDBOOK") {
+        int quantity;
+        if (!parseNumber(fields[4], quantity) || quantity < 1) {
+            body << "Error: Quantity must be a positive number.\n";
+            return false;
+        }
+        return reportSuccess(library->addBook(fields[1], fields[2], fields[3], quantity), body,
+                             "Book added successfully!");
+    }
+    if (verb == "REMOVEBOOK") {
+        return reportSuccess(library->removeBook(fields[1]), body, "Book removed successfully!");
+    }
+    if (verb == "UPDATEBOOK") {
+        return reportSuccess(library->updateBookDetails(fields[1], fields[2], fields[3]), body,
+                             "Book details updated successfully!");
+    }
+    if (verb == "QUANTITY") {
+        int quantity;
+        if (!parseNumber(fields[2], quantity)) {
+            body << "Error: Quantity must be a number.\n";
+            return false;
+        }
+        return reportSuccess(library->updateBookQuantity(fields[1], quantity), body,
+                             "Quantity updated successfully!");
+    }
+    if (verb == "USERS") {
+        library->displayAllUsers();
+        return true;
+    }
+    if (verb == "USER") {
+        library->displayUserDetails(fields[1]);
+        return true;
+    }
+    if (verb == "ACTIVATE") {
+        return reportSuccess(library->activateUser(fields[1]), body, "User activated.");
+    }
+    if (verb == "DEACTIVATE") {
+        return reportSuccess(library->deactivateUser(fields[1]), body, "User deactivated.");
+    }
+    if (verb == "REMOVEUSER") {
+        return reportSuccess(library->removeUser(fields[1]), body, "User removed.");
+    }
+    if (verb == "TRANSACTIONS") {
+        library->displayAllTransactions();
+        return true;
+    }
+    if (verb == "HISTORY") {
+        library->displayTransactionHistory(fields[1], fields[2]);
+        return true;
+    }
+    if (verb == "STATS") {
+        library->displaySystemStatistics();
+        return true;
+    }
+    if (verb == "REPORT") {
+        library->displayBorrowingReport();
+        return true;
+    }
+    
+    // SAVE
+    if (!library->saveAllData()) {
+        body << "Error: Could not save data.\n";
+        return false;
+    }
+    body << "Success: Data saved.\n";
+    return true;
+}
+
+string LibraryServer::formatResponse(bool ok, const string& body) {
+    return (ok ? "OK " : "ERR ") + to_string(body.size()) + "\n" + body;
+}
+
+// ISBN|title|authors|available|total
+string LibraryServer::formatBook(const Book* book) {
+    stringstream ss;
+    ss << book->getISBN() << PROTOCOL_DELIMITER << book->getTitle() << PROTOCOL_DELIMITER << book->getAuthor()
+       << PROTOCOL_DELIMITER << book->getAvailableCopies() << PROTOCOL_DELIMITER << book->getQuantity() << "\n";
+    return ss.str();
+}
+
+#ifdef __linux__
+
+// ============ LISTENING & EVENT LOOP ============
+
+LibraryServer::~LibraryServer() {
+    finishWorkers();
+    
+    for (auto& entry : connections) {
+        if (entry.second->fd >= 0) {
+            close(entry.second->fd);
+        }
+        delete entry.second;
+    }
+    
+    if (listenFD >= 0) close(listenFD);
+    if (epollFD >= 0) close(epollFD);
+    if (wakeFD >= 0) close(wakeFD);
+    if (!socketPath.empty()) {
+        unlink(socketPath.c_str());
+    }
+}
+
+bool LibraryServer::start(const string& address, int workerCount) {
+    if (!openListener(address)) {
+        return false;
+    }
+    
+    epollFD = epoll_create1(EPOLL_CLOEXEC);
+    wakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFD < 0 || wakeFD < 0) {
+        cout << "Error: Cannot create event loop: " << strerror(errno) << "\n";
+        return false;
+    }
+    
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_KEY;
+    epoll_ctl(epollFD, EPOLL_CTL_ADD, listenFD, &event);
+    event.data.u64 = WAKE_KEY;
+    epoll_ctl(epollFD, EPOLL_CTL_ADD, wakeFD, &event);
+    
+    if (workerCount <= 0) {
+        workerCount = max(1, (int)thread::hardware_concurrency());
+    }
+    running = true;
+    for (int i = 0; i < workerCount; i++) {
+        workers.push_back(thread(&LibraryServer::workerLoop, this));
+    }
+    return true;
+}
+
+// "unix:/path/to/socket", "host:port" or just "port" (all interfaces)
+bool LibraryServer::openListener(const string& address) {
+    bool bound = false;
+    
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        string path = address.substr(5);
+        if (path.empty() || path.size() >= sizeof(local.sun_path)) {
+            cout << "Error: Invalid socket path '" << path << "'.\n";
+            return false;
+        }
+        memcpy(local.sun_path, path.c_str(), path.size());
+        
+        listenFD = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFD >= 0) {
+            // A socket file left by an earlier run would make bind fail
+            unlink(path.c_str());
+            bound = bind(listenFD, (sockaddr*)&local, sizeof(local)) == 0;
+            if (bound) {
+                socketPath = path;
+            }
+        }
+    } else {
+        size_t colon = address.rfind(':');
+        string host = colon == string::npos ? "" : address.substr(0, colon);
+        string port = colon == string::npos ? address : address.substr(colon + 1);
+        
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        addrinfo* info = nullptr;
+        if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &info) != 0) {
+            cout << "Error: Invalid address '" << address << "'.\n";
+            return false;
+        }
+        
+        listenFD = socket(info->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFD >= 0) {
+            int one = 1;
+            setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            bound = bind(listenFD, info->ai_addr, info->ai_addrlen) == 0;
+        }
+        freeaddrinfo(info);
+    }
+    
+    if (listenFD < 0 || !bound || listen(listenFD, SOMAXCONN) != 0) {
+        cout << "Error: Cannot listen on " << address << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+void LibraryServer::run() {
+    epoll_event events[MAX_EVENTS];
+    
+    while (running.load()) {
+        saveIfDue();
+        
+        // Sleep until the next save is due, or indefinitely with nothing unsaved
+        int timeout = -1;
+        if (dirty.load()) {
+            chrono::steady_clock::duration wait = lastSave + chrono::seconds(SERVER_SAVE_INTERVAL) -
+                                                  chrono::steady_clock::now();
+            timeout = max(0, (int)chrono::duration_cast<chrono::milliseconds>(wait).count() + 1);
+        }
+        
+        int count = epoll_wait(epollFD, events, MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            cout << "Error: Event loop failed: " << strerror(errno) << "\n";
+            break;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            uint64_t key = events[i].data.u64;
+            if (key == LISTEN_KEY) {
+                acceptConnections();
+                continue;
+            }
+            if (key == WAKE_KEY) {
+                uint64_t signals;
+                ssize_t drained = read(wakeFD, &signals, sizeof(signals));
+                (void)drained;
+                collectResults();
+                continue;
+            }
+            
+            // Looked up again after each step: either may close the connection
+            auto it = connections.find(key);
+            if (it == connections.end() || it->second->fd < 0) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(it->second);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                readFrom(it->second);
+            }
+            
+            it = connections.find(key);
+            if (it != connections.end() && it->second->fd >= 0 && (events[i].events & EPOLLOUT)) {
+                writeTo(it->second);
+            }
+        }
+    }
+    
+    // Requests already with a worker finish before the caller's final save
+    // and are answered; those still waiting on their connection are dropped
+    running = false;
+    finishWorkers();
+    collectResults();
+}
+
+// Saves on the event loop thread. The exclusive catalog lock waits for the
+// requests in progress and holds new ones back, so connections pause for
+// the length of one save at most every SERVER_SAVE_INTERVAL seconds.
+void LibraryServer::saveIfDue() {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (!dirty.load() || now < lastSave + chrono::seconds(SERVER_SAVE_INTERVAL)) {
+        return;
+    }
+    
+    // Cleared first: a change made while saving marks the data dirty again
+    dirty = false;
+    lastSave = now;
+    if (!library->saveAllData()) {
+        cout << "Error: Could not save data.\n";
+        dirty = true;
+    }
+}
+
+void LibraryServer::stop() {
+    running = false;
+    if (wakeFD >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFD, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+// ============ CONNECTIONS ============
+
+void LibraryServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFD, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        
+        // Responses are written whole; no reason to wait for more. Fails
+        // harmlessly on Unix sockets.
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        
+        Connection* conn = new Connection();
+        conn->id = nextConnectionID++;
+        conn->fd = fd;
+        conn->busy = false;
+        conn->peerClosed = false;
+        conn->closing = false;
+        connections[conn->id] = conn;
+        
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = conn->id;
+        epoll_ctl(epollFD, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+bool LibraryServer::backlogged(const Connection* conn) {
+    return conn->requests.size() >= (size_t)SERVER_MAX_PENDING_REQUESTS ||
+           conn->output.size() >= (size_t)SERVER_MAX_PENDING_OUTPUT;
+}
+
+// Reads only while the client may still send and is not backlogged, writes
+// only while there is output
+void LibraryServer::watch(Connection* conn) {
+    epoll_event event;
+    event.events = 0;
+    if (!conn->peerClosed && !conn->closing && !backlogged(conn)) {
+        event.events |= EPOLLIN;
+    }
+    if (!conn->output.empty()) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.u64 = conn->id;
+    epoll_ctl(epollFD, EPOLL_CTL_MOD, conn->fd, &event);
+}
+
+void LibraryServer::readFrom(Connection* conn) {
+    char buffer[READ_CHUNK];
+    ssize_t received = recv(conn->fd, buffer, sizeof(buffer), 0);
+    if (received < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            closeConnection(conn);
+        }
+        return;
+    }
+    if (received == 0) {
+        // Requests already sent are still answered
+        conn->peerClosed = true;
+        writeTo(conn);
+        return;
+    }
+    
+    conn->input.append(buffer, received);
+    size_t start = 0;
+    size_t end;
+    while ((end = conn->input.find('\n', start)) != string::npos) {
+        string line = conn->input.substr(start, end - start);
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        if (!line.empty()) {
+            conn->requests.push_back(line);
+        }
+        start = end + 1;
+    }
+    conn->input.erase(0, start);
+    
+    if (conn->input.size() > (size_t)SERVER_MAX_REQUEST_LENGTH) {
+        conn->input.clear();
+        conn->requests.clear();
+        conn->output += formatResponse(false, "Error: Request too long.\n");
+        conn->closing = true;
+        writeTo(conn);
+        return;
+    }
+    
+    dispatchNext(conn);
+    if (backlogged(conn)) {
+        watch(conn);
+    }
+}
+
+// Holds requests back while the client is not reading its responses, and
+// all of them once the server is stopping
+void LibraryServer::dispatchNext(Connection* conn) {
+    if (!running.load() || conn->busy || conn->closing || conn->requests.empty() ||
+        conn->output.size() >= (size_t)SERVER_MAX_PENDING_OUTPUT) {
+        return;
+    }
+    
+    Job job;
+    job.connectionID = conn->id;
+    job.session = &conn->session;
+    job.request = conn->requests.front();
+    conn->requests.pop_front();
+    conn->busy = true;
+    
+    {
+        lock_guard<mutex> lock(jobMutex);
+        jobs.push_back(job);
+    }
+    jobReady.notify_one();
+}
+
+void LibraryServer::writeTo(Connection* conn) {
+    while (!conn->output.empty()) {
+        ssize_t sent = send(conn->fd, conn->output.data(), conn->output.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeConnection(conn);
+            return;
+        }
+        conn->output.erase(0, sent);
+    }
+    dispatchNext(conn);
+    
+    bool finished = conn->closing || (conn->peerClosed && conn->requests.empty());
+    if (finished && !conn->busy && conn->output.empty()) {
+        closeConnection(conn);
+        return;
+    }
+    watch(conn);
+}
+
+// A connection whose request is still with a worker is only deleted when
+// the result comes back, since the worker is using its session
+void LibraryServer::closeConnection(Connection* conn) {
+    if (conn->fd >= 0) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    if (!conn->busy) {
+        connections.erase(conn->id);
+        delete conn;
+    }
+}
+
+void LibraryServer::collectResults() {
+    vector<Result> finished;
+    {
+        lock_guard<mutex> lock(resultMutex);
+        finished.swap(results);
+    }
+    
+    for (const Result& result : finished) {
+        auto it = connections.find(result.connectionID);
+        if (it == connections.end()) continue;
+        
+        Connection* conn = it->second;
+        conn->busy = false;
+        if (conn->fd < 0) {
+            connections.erase(it);
+            delete conn;
+            continue;
+        }
+        
+        conn->output += result.response;
+        if (result.close) {
+            conn->closing = true;
+        }
+        dispatchNext(conn);
+        writeTo(conn);
+    }
+}
+
+// ============ WORKERS ============
+
+// Workers empty the job queue before they exit
+void LibraryServer::finishWorkers() {
+    {
+        lock_guard<mutex> lock(jobMutex);
+        workersStopping = true;
+    }
+    jobReady.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void LibraryServer::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> lock(jobMutex);
+            jobReady.wait(lock, [this] { return workersStopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        
+        Result result;
+        result.connectionID = job.connectionID;
+        result.close = false;
+        result.response = execute(job.request, job.session, result.close);
+        
+        {
+            lock_guard<mutex> lock(resultMutex);
+            results.push_back(result);
+        }
+        uint64_t one = 1;
+        ssize_t written = write(wakeFD, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+#else
+
+// Server mode is built on epoll; elsewhere it only reports that it is missing
+
+LibraryServer::~LibraryServer() {}
+
+bool LibraryServer::start(const string& address, int workerCount) {
+    (void)address;
+    (void)workerCount;
+    cout << "Error: Server mode is only available on Linux.\n";
+    return false;
+}
+
+void LibraryServer::run() {}
+
+void LibraryServer::stop() {}
+
+#endif
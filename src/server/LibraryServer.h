@@ -0,0 +1,126 @@
+#ifndef LIBRARY_SERVER_H
+#define LIBRARY_SERVER_H
+
+#include "../management/LibraryManager.h"
+#include "../management/AuthManager.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <cstdint>
+using namespace std;
+
+// Serves every desk and kiosk from the one LibraryManager. A single event
+// loop thread multiplexes all connections with epoll (accepting, reading
+// request lines, writing responses) and hands complete requests to a pool of
+// worker threads, which run them in parallel. Each connection has its own
+// AuthManager session, so a login on one desk does not log in another, and
+// at most one request in flight, so its responses come back in the order it
+// sent them. A client that pipelines requests faster than it reads the
+// responses is not read from again until its backlog drains below
+// SERVER_MAX_PENDING_REQUESTS and SERVER_MAX_PENDING_OUTPUT.
+//
+// A request is one line of PROTOCOL_DELIMITER-separated fields, verb first:
+//     BORROW|978-0-13-110362-7
+// and every response is a status line, "OK <length>" or "ERR <length>",
+// followed by exactly <length> bytes of text: the operation's report or
+// message, as the console would show it. HELP lists the verbs.
+class LibraryServer {
+private:
+    struct Connection {
+        uint64_t id;
+        int fd;
+        AuthManager::Session session;
+        string input;               // received bytes not yet ending in a newline
+        deque<string> requests;     // complete lines waiting their turn
+        string output;              // response bytes not yet written
+        bool busy;                  // a request is with a worker
+        bool peerClosed;            // client finished sending
+        bool closing;               // close once output is written
+    };
+    
+    struct Job {
+        uint64_t connectionID;
+        AuthManager::Session* session;
+        string request;
+    };
+    
+    struct Result {
+        uint64_t connectionID;
+        string response;
+        bool close;
+    };
+    
+    // Verb, number of arguments, role needed, argument names (for HELP) and
+    // whether success changes data that is saved
+    struct Command {
+        const char* verb;
+        size_t arguments;
+        AuthManager::Role role;
+        const char* usage;
+        bool mutates;
+    };
+    static const Command COMMANDS[];
+    
+    LibraryManager* library;
+    AuthManager* auth;
+    int listenFD;
+    int epollFD;
+    int wakeFD;                 // eventfd: finished jobs and stop requests
+    string socketPath;          // Unix socket file, removed on shutdown
+    uint64_t nextConnectionID;
+    unordered_map<uint64_t, Connection*> connections;   // event loop thread only
+    atomic<bool> running;
+    
+    // Raised by workers after a successful change; the event loop saves
+    // when it is set and SERVER_SAVE_INTERVAL has passed since the last save
+    atomic<bool> dirty;
+    chrono::steady_clock::time_point lastSave;
+    
+    vector<thread> workers;
+    deque<Job> jobs;
+    mutex jobMutex;
+    condition_variable jobReady;
+    bool workersStopping;
+    vector<Result> results;
+    mutex resultMutex;
+    
+    bool openListener(const string& address);
+    static bool backlogged(const Connection* conn);
+    void watch(Connection* conn);
+    void acceptConnections();
+    void readFrom(Connection* conn);
+    void dispatchNext(Connection* conn);
+    void writeTo(Connection* conn);
+    void closeConnection(Connection* conn);
+    void collectResults();
+    void workerLoop();
+    void finishWorkers();
+    void saveIfDue();
+    
+    string execute(const string& request, AuthManager::Session* session, bool& hangUp);
+    bool handle(const vector<string>& fields, ostream& body, bool& hangUp);
+    static const Command* findCommand(string verb);
+    static string formatResponse(bool ok, const string& body);
+    static string formatBook(const Book* book);
+
+public:
+    LibraryServer(LibraryManager* manager, AuthManager* authManager);
+    ~LibraryServer();
+    
+    // Listens on address and starts workerCount workers (0 = one per core)
+    bool start(const string& address, int workerCount);
+    // Runs the event loop on the calling thread until stop(), then answers
+    // the requests already being worked on and stops the workers
+    void run();
+    // Safe to call from a signal handler
+    void stop();
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "AuthorRegistry.h"
+#include "../Config.h"
+#include <algorithm>
+
+AuthorRegistry::AuthorRegistry() {
+    lists.push_back(&listIDs.insert(make_pair(vector<uint32_t>(), 0)).first->first);
+}
+
+AuthorRegistry* AuthorRegistry::getInstance() {
+    // A Book keeps only its author list ID and resolves names here on every
+    // read, so the registry is built by the first book parsed and never freed
+    static AuthorRegistry* registry = new AuthorRegistry();
+    return registry;
+}
+
+// key: folded words joined by single spaces. sortKey: the same words with
+// the last one (the surname) moved to the front. name: the original words,
+// spacing tidied. Returns false for a name with no words.
+bool AuthorRegistry::foldName(const string& name, string& key, string& sortKey) {
+    size_t count = tokenizer.tokenize(name);
+    if (count == 0) return false;
+    
+    key.clear();
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) key += ' ';
+        key.append(tokenizer.tokenData(i), tokenizer.tokenLength(i));
+    }
+    
+    size_t surnameLength = tokenizer.tokenLength(count - 1);
+    sortKey.assign(tokenizer.tokenData(count - 1), surnameLength);
+    if (count > 1) {
+        sortKey += ' ';
+        sortKey.append(key, 0, key.size() - surnameLength - 1);
+    }
+    return true;
+}
+
+uint32_t AuthorRegistry::internLocked(const string& name) {
+    string key, sortKey;
+    if (!foldName(name, key, sortKey)) return UINT32_MAX;
+    
+    auto it = authorIDs.find(key);
+    if (it != authorIDs.end()) {
+        return it->second;
+    }
+    
+    string displayName;
+    for (size_t i = 0; i < tokenizer.getTokenCount(); i++) {
+        if (i > 0) displayName += ' ';
+        displayName.append(name, tokenizer.tokenOffset(i), tokenizer.tokenSourceLength(i));
+    }
+    
+    uint32_t authorID = (uint32_t)authors.size();
+    authors.push_back(new Author(authorID, displayName, sortKey));
+    authorIDs[key] = authorID;
+    return authorID;
+}
+
+uint32_t AuthorRegistry::intern(const string& name) {
+    lock_guard<mutex> lock(registryMutex);
+    return internLocked(name);
+}
+
+uint32_t AuthorRegistry::internList(const string& names) {
+    lock_guard<mutex> lock(registryMutex);
+    vector<uint32_t> credited;
+    size_t start = 0;
+    while (start <= names.size()) {
+        size_t end = names.find(LIST_DELIMITER, start);
+        if (end == string::npos) end = names.size();
+        
+        uint32_t authorID = internLocked(names.substr(start, end - start));
+        if (authorID != UINT32_MAX && std::find(credited.begin(), credited.end(), authorID) == credited.end()) {
+            credited.push_back(authorID);
+        }
+        start = end + 1;
+    }
+    
+    auto it = listIDs.find(credited);
+    if (it != listIDs.end()) {
+        return it->second;
+    }
+    
+    // map nodes never move, so the key can back the reverse table
+    uint32_t listID = (uint32_t)lists.size();
+    it = listIDs.insert(make_pair(credited, listID)).first;
+    lists.push_back(&it->first);
+    return listID;
+}
+
+bool AuthorRegistry::find(const string& name, uint32_t& authorID) {
+    lock_guard<mutex> lock(registryMutex);
+    string key, sortKey;
+    if (!foldName(name, key, sortKey)) return false;
+    
+    auto it = authorIDs.find(key);
+    if (it == authorIDs.end()) return false;
+    
+    authorID = it->second;
+    return true;
+}
+
+const vector<uint32_t>& AuthorRegistry::getList(uint32_t listID) const {
+    lock_guard<mutex> lock(registryMutex);
+    if (listID >= lists.size()) {
+        return *lists[0];
+    }
+    return *lists[listID];
+}
+
+string AuthorRegistry::getName(uint32_t authorID) const {
+    lock_guard<mutex> lock(registryMutex);
+    if (authorID >= authors.size()) {
+        return "";
+    }
+    return authors[authorID]->getName();
+}
+
+string AuthorRegistry::getSortKey(uint32_t authorID) const {
+    lock_guard<mutex> lock(registryMutex);
+    if (authorID >= authors.size()) {
+        return "";
+    }
+    return authors[authorID]->getSortKey();
+}
+
+string AuthorRegistry::formatList(uint32_t listID) const {
+    lock_guard<mutex> lock(registryMutex);
+    if (listID >= lists.size()) {
+        return "";
+    }
+    
+    string names;
+    for (uint32_t authorID : *lists[listID]) {
+        if (!names.empty()) names += string(1, LIST_DELIMITER) + " ";
+        names += authors[authorID]->getName();
+    }
+    return names;
+}
+
+vector<uint32_t> AuthorRegistry::getSortedAuthors() {
+    lock_guard<mutex> lock(registryMutex);
+    if (sortedIDs.size() != authors.size()) {
+        sortedIDs.resize(authors.size());
+        for (uint32_t authorID = 0; authorID < authors.size(); authorID++) {
+            sortedIDs[authorID] = authorID;
+        }
+        
+        const vector<Author*>& table = authors;
+        sort(sortedIDs.begin(), sortedIDs.end(), [&table](uint32_t a, uint32_t b) {
+            int order = table[a]->getSortKey().compare(table[b]->getSortKey());
+            return order != 0 ? order < 0 : a < b;
+        });
+    }
+    return sortedIDs;
+}
+
+int AuthorRegistry::getCount() const {
+    lock_guard<mutex> lock(registryMutex);
+    return (int)authors.size();
+}
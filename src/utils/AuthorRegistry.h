@@ -0,0 +1,58 @@
+#ifndef AUTHOR_REGISTRY_H
+#define AUTHOR_REGISTRY_H
+
+#include "../entities/Author.h"
+#include "Tokenizer.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+using namespace std;
+
+// Process-wide author table. Each distinct author, compared by folded name
+// ("DONALD  Knuth" and "Donald Knuth" are one person), gets a 32-bit ID, and
+// each distinct list of authors credited on a book is interned in turn, so
+// a book carries one list ID however many authors it has, and every book by
+// the same authors shares one list. List 0 is the empty list.
+class AuthorRegistry {
+private:
+    unordered_map<string, uint32_t> authorIDs;      // folded name -> author ID
+    vector<Author*> authors;
+    map<vector<uint32_t>, uint32_t> listIDs;
+    vector<const vector<uint32_t>*> lists;
+    
+    // Author IDs by sort key, rebuilt when authors have been added since
+    vector<uint32_t> sortedIDs;
+    
+    Tokenizer tokenizer;
+    // Books are parsed on whichever thread loads or edits them
+    mutable mutex registryMutex;
+    
+    AuthorRegistry();
+    bool foldName(const string& name, string& key, string& sortKey);
+    uint32_t internLocked(const string& name);
+
+public:
+    static AuthorRegistry* getInstance();
+    
+    // Author names separated by LIST_DELIMITER; blank names are skipped and
+    // repeated ones credited once
+    uint32_t internList(const string& names);
+    uint32_t intern(const string& name);
+    // Looks a name up without adding it
+    bool find(const string& name, uint32_t& authorID);
+    
+    const vector<uint32_t>& getList(uint32_t listID) const;
+    string getName(uint32_t authorID) const;
+    string getSortKey(uint32_t authorID) const;
+    // Names of a list joined by "; ", the form internList reads back
+    string formatList(uint32_t listID) const;
+    
+    // Every author ID, ordered by surname and then the rest of the name
+    vector<uint32_t> getSortedAuthors();
+    int getCount() const;
+};
+
+#endif
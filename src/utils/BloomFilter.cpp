@@ -0,0 +1,83 @@
+#include "BloomFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+BloomFilter::BloomFilter() : hashCount(0) {}
+
+// k = bitsPerKey * ln 2 minimizes false positives for the chosen size
+BloomFilter::BloomFilter(size_t expectedKeys, int bitsPerKey) {
+    size_t bitCount = max<size_t>(64, expectedKeys * (size_t)max(1, bitsPerKey));
+    bits.assign((bitCount + 63) / 64, 0);
+    hashCount = max(1, min(8, (int)lround(bitsPerKey * 0.69)));
+}
+
+uint64_t BloomFilter::hashKey(const string& key) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (char c : key) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void BloomFilter::add(const string& key) {
+    if (bits.empty()) return;
+    
+    uint64_t hash = hashKey(key);
+    uint64_t step = (hash >> 32) | 1;
+    uint64_t bitCount = bits.size() * 64;
+    for (int i = 0; i < hashCount; i++) {
+        uint64_t bit = (hash + i * step) % bitCount;
+        bits[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+bool BloomFilter::mightContain(const string& key) const {
+    if (bits.empty()) return true;
+    
+    uint64_t hash = hashKey(key);
+    uint64_t step = (hash >> 32) | 1;
+    uint64_t bitCount = bits.size() * 64;
+    for (int i = 0; i < hashCount; i++) {
+        uint64_t bit = (hash + i * step) % bitCount;
+        if ((bits[bit >> 6] & (1ULL << (bit & 63))) == 0) return false;
+    }
+    return true;
+}
+
+string BloomFilter::toString() const {
+    string text = to_string(hashCount) + ":";
+    char word[17];
+    for (uint64_t value : bits) {
+        snprintf(word, sizeof(word), "%016llx", (unsigned long long)value);
+        text += word;
+    }
+    return text;
+}
+
+bool BloomFilter::fromString(const string& text) {
+    bits.clear();
+    hashCount = 0;
+    
+    size_t colon = text.find(':');
+    if (colon == string::npos || (text.size() - colon - 1) % 16 != 0 || text.size() == colon + 1) {
+        return false;
+    }
+    
+    int count = atoi(text.substr(0, colon).c_str());
+    if (count < 1 || count > 8) return false;
+    
+    vector<uint64_t> words;
+    for (size_t pos = colon + 1; pos < text.size(); pos += 16) {
+        string hex = text.substr(pos, 16);
+        char* end;
+        words.push_back(strtoull(hex.c_str(), &end, 16));
+        if (*end != '\0') return false;
+    }
+    
+    bits.swap(words);
+    hashCount = count;
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+// Set membership with false positives but no false negatives. Each key sets
+// hashCount bits chosen by double hashing one 64-bit FNV-1a hash; at 10
+// bits per key about 1% of absent keys are reported present. An empty
+// filter (default constructed, or one that failed to parse) says every key
+// may be present, so callers fall back to looking.
+class BloomFilter {
+private:
+    vector<uint64_t> bits;
+    int hashCount;
+    
+    static uint64_t hashKey(const string& key);
+
+public:
+    BloomFilter();
+    BloomFilter(size_t expectedKeys, int bitsPerKey);
+    
+    void add(const string& key);
+    bool mightContain(const string& key) const;
+    
+    // "<hashCount>:<hex words>", one line
+    string toString() const;
+    bool fromString(const string& text);
+};
+
+#endif
@@ -8,7 +8,11 @@ BookBST::~BookBST() {
 }
 
 void BookBST::insert(Book* book) {
+    int beforeCount = nodeCount;
     root = insert(root, book);
+    if (nodeCount > beforeCount) {
+        book->setHandle(books.insert(book));
+    }
 }
 
 BookBST::BookNode* BookBST::insert(BookNode* node, Book* book) {
@@ -59,6 +63,10 @@ Book* BookBST::search(string isbn) {
     return result ? result->data : nullptr;
 }
 
+Book* BookBST::resolve(Handle handle) const {
+    return books.get(handle);
+}
+
 BookBST::BookNode* BookBST::search(BookNode* node, string isbn) {
     if (node == nullptr || node->data->getISBN() == isbn) {
         return node;
@@ -71,46 +79,105 @@ BookBST::BookNode* BookBST::search(BookNode* node, string isbn) {
     return search(node->right, isbn);
 }
 
+void BookBST::searchSorted(const vector<string>& isbns, vector<Book*>& found) {
+    found.assign(isbns.size(), nullptr);
+    searchRange(root, isbns, 0, isbns.size(), found);
+}
+
+// Splits the probes [begin, end) around this node's ISBN and sends each half
+// down its own subtree, so paths shared by neighbouring ISBNs are walked once
+void BookBST::searchRange(BookNode* node, const vector<string>& isbns, size_t begin, size_t end, 
+                          vector<Book*>& found) {
+    if (node == nullptr || begin >= end) {
+        return;
+    }
+    
+    const string& key = node->data->getISBN();
+    size_t split = lower_bound(isbns.begin() + begin, isbns.begin() + end, key) - isbns.begin();
+    searchRange(node->left, isbns, begin, split, found);
+    
+    while (split < end && isbns[split] == key) {
+        found[split++] = node->data;
+    }
+    searchRange(node->right, isbns, split, end, found);
+}
+
 bool BookBST::remove(string isbn) {
-    int beforeCount = nodeCount;
-    root = deleteNode(root, isbn);
-    return nodeCount < beforeCount;
+    BookNode* removed = nullptr;
+    root = deleteNode(root, isbn, removed);
+    if (removed == nullptr) {
+        return false;
+    }
+    
+    books.erase(removed->data->getHandle());
+    delete removed;
+    nodeCount--;
+    return true;
 }
 
-BookBST::BookNode* BookBST::deleteNode(BookNode* node, string isbn) {
+// Unlinks the node holding isbn and hands it back through removed. A node
+// with two children is replaced by its in-order successor node, moved up
+// from the right subtree, rather than by a copy of the successor's data.
+BookBST::BookNode* BookBST::deleteNode(BookNode* node, const string& isbn, BookNode*& removed) {
     if (node == nullptr) {
         return node;
     }
     
     if (isbn < node->data->getISBN()) {
-        node->left = deleteNode(node->left, isbn);
+        node->left = deleteNode(node->left, isbn, removed);
     } else if (isbn > node->data->getISBN()) {
-        node->right = deleteNode(node->right, isbn);
+        node->right = deleteNode(node->right, isbn, removed);
     } else {
+        removed = node;
         if (node->left == nullptr || node->right == nullptr) {
-            BookNode* temp = node->left ? node->left : node->right;
-            
-            if (temp == nullptr) {
-                temp = node;
-                node = nullptr;
-            } else {
-                *node = *temp;
-            }
-            
-            delete temp->data;
-            delete temp;
-            nodeCount--;
-        } else {
-            BookNode* temp = findMin(node->right);
-            node->data = temp->data;
-            node->right = deleteNode(node->right, temp->data->getISBN());
+            return node->left ? node->left : node->right;
         }
+        
+        BookNode* successor = nullptr;
+        BookNode* right = detachMin(node->right, successor);
+        successor->left = node->left;
+        successor->right = right;
+        node = successor;
     }
     
-    if (node == nullptr) {
-        return node;
+    return rebalance(node);
+}
+
+BookBST::BookNode* BookBST::detachMin(BookNode* node, BookNode*& min) {
+    if (node->left == nullptr) {
+        min = node;
+        return node->right;
     }
     
+    node->left = detachMin(node->left, min);
+    return rebalance(node);
+}
+
+vector<Book*> BookBST::getAllBooksSorted() {
+    vector<Book*> result;
+    inorderTraversal(root, result);
+    return result;
+}
+
+void BookBST::inorderTraversal(BookNode* node, vector<Book*>& result) {
+    if (node == nullptr) return;
+    
+    inorderTraversal(node->left, result);
+    result.push_back(node->data);
+    inorderTraversal(node->right, result);
+}
+
+int BookBST::getHeight(BookNode* node) {
+    if (node == nullptr) return 0;
+    return node->height;
+}
+
+int BookBST::getBalance(BookNode* node) {
+    if (node == nullptr) return 0;
+    return getHeight(node->left) - getHeight(node->right);
+}
+
+BookBST::BookNode* BookBST::rebalance(BookNode* node) {
     node->height = 1 + max(getHeight(node->left), getHeight(node->right));
     
     int balance = getBalance(node);
@@ -140,37 +207,6 @@ BookBST::BookNode* BookBST::deleteNode(BookNode* node, string isbn) {
     return node;
 }
 
-BookBST::BookNode* BookBST::findMin(BookNode* node) {
-    while (node->left != nullptr) {
-        node = node->left;
-    }
-    return node;
-}
-
-vector<Book*> BookBST::getAllBooksSorted() {
-    vector<Book*> result;
-    inorderTraversal(root, result);
-    return result;
-}
-
-void BookBST::inorderTraversal(BookNode* node, vector<Book*>& result) {
-    if (node == nullptr) return;
-    
-    inorderTraversal(node->left, result);
-    result.push_back(node->data);
-    inorderTraversal(node->right, result);
-}
-
-int BookBST::getHeight(BookNode* node) {
-    if (node == nullptr) return 0;
-    return node->height;
-}
-
-int BookBST::getBalance(BookNode* node) {
-    if (node == nullptr) return 0;
-    return getHeight(node->left) - getHeight(node->right);
-}
-
 BookBST::BookNode* BookBST::rotateRight(BookNode* y) {
     BookNode* x = y->left;
     BookNode* T2 = x->right;
@@ -203,6 +239,7 @@ int BookBST::getCount() const {
 
 void BookBST::clear() {
     destroy(root);
+    books.clear();
     root = nullptr;
     nodeCount = 0;
 }
@@ -211,7 +248,6 @@ void BookBST::destroy(BookNode* node) {
     if (node != nullptr) {
         destroy(node->left);
         destroy(node->right);
-        delete node->data;
         delete node;
     }
 }
@@ -2,8 +2,12 @@
 #define BOOK_BST_H
 
 #include "../entities/Book.h"
+#include "SlotTable.h"
 #include <vector>
 
+// ISBN-ordered AVL tree over the catalog. The books themselves live in a
+// SlotTable owned by the tree: nodes are relinked, never their data, so a
+// book keeps its address and handle until it is removed.
 class BookBST {
 private:
     struct BookNode {
@@ -17,12 +21,14 @@ private:
     
     BookNode* root;
     int nodeCount;
+    SlotTable<Book> books;
     
     // Private helper methods
     BookNode* insert(BookNode* node, Book* book);
     BookNode* search(BookNode* node, string isbn);
-    BookNode* deleteNode(BookNode* node, string isbn);
-    BookNode* findMin(BookNode* node);
+    void searchRange(BookNode* node, const vector<string>& isbns, size_t begin, size_t end, vector<Book*>& found);
+    BookNode* deleteNode(BookNode* node, const string& isbn, BookNode*& removed);
+    BookNode* detachMin(BookNode* node, BookNode*& min);
     void inorderTraversal(BookNode* node, vector<Book*>& result);
     void destroy(BookNode* node);
     
@@ -31,6 +37,7 @@ private:
     int getBalance(BookNode* node);
     BookNode* rotateRight(BookNode* y);
     BookNode* rotateLeft(BookNode* x);
+    BookNode* rebalance(BookNode* node);
 
 public:
     BookBST();
@@ -38,6 +45,10 @@ public:
     
     void insert(Book* book);
     Book* search(string isbn);
+    // nullptr once the book has been removed
+    Book* resolve(Handle handle) const;
+    // Looks up sorted isbns in one ordered walk; found[i] is nullptr if isbns[i] is absent
+    void searchSorted(const vector<string>& isbns, vector<Book*>& found);
     bool remove(string isbn);
     vector<Book*> getAllBooksSorted();
     int getCount() const;
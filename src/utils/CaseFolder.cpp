@@ -0,0 +1,232 @@
+#include "CaseFolder.h"
+
+// Generated from the Unicode 14 character database: each code point is
+// case-folded, decomposed (NFD) and stripped of combining marks, with a few
+// letters that have no decomposition (ø, ł, đ, ħ, ı, ...) mapped by hand.
+// Entries for U+0300-U+036F are 0, meaning the mark is dropped. A mapping
+// that would need more UTF-8 bytes than its source is left out.
+static const uint16_t FOLD_00C0[0x04FF - 0x00C0 + 1] = {
+    0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x00C6, 0x0063, 0x0065, 0x0065, 0x0065, 0x0065,
+    0x0069, 0x0069, 0x0069, 0x0069, 0x00F0, 0x006E, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x00D7,
+    0x006F, 0x0075, 0x0075, 0x0075, 0x0075, 0x0079, 0x00DE, 0x00DF, 0x0061, 0x0061, 0x0061, 0x0061,
+    0x0061, 0x0061, 0x00E6, 0x0063, 0x0065, 0x0065, 0x0065, 0x0065, 0x0069, 0x0069, 0x0069, 0x0069,
+    0x00F0, 0x006E, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x00F7, 0x006F, 0x0075, 0x0075, 0x0075,
+    0x0075, 0x0079, 0x00FE, 0x0079, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0063, 0x0063,
+    0x0063, 0x0063, 0x0063, 0x0063, 0x0063, 0x0063, 0x0064, 0x0064, 0x0064, 0x0064, 0x0065, 0x0065,
+    0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0067, 0x0067, 0x0067, 0x0067,
+    0x0067, 0x0067, 0x0067, 0x0067, 0x0068, 0x0068, 0x0068, 0x0068, 0x0069, 0x0069, 0x0069, 0x0069,
+    0x0069, 0x0069, 0x0069, 0x0069, 0x0069, 0x0069, 0x0132, 0x0133, 0x006A, 0x006A, 0x006B, 0x006B,
+    0x0138, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C, 0x006E,
+    0x006E, 0x006E, 0x006E, 0x006E, 0x006E, 0x0149, 0x014B, 0x014B, 0x006F, 0x006F, 0x006F, 0x006F,
+    0x006F, 0x006F, 0x0152, 0x0153, 0x0072, 0x0072, 0x0072, 0x0072, 0x0072, 0x0072, 0x0073, 0x0073,
+    0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0074, 0x0074, 0x0074, 0x0074, 0x0074, 0x0074,
+    0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075,
+    0x0077, 0x0077, 0x0079, 0x0079, 0x0079, 0x007A, 0x007A, 0x007A, 0x007A, 0x007A, 0x007A, 0x0073,
+    0x0062, 0x0253, 0x0183, 0x0183, 0x0185, 0x0185, 0x0254, 0x0188, 0x0188, 0x0256, 0x0257, 0x018C,
+    0x018C, 0x018D, 0x01DD, 0x0259, 0x025B, 0x0192, 0x0192, 0x0260, 0x0263, 0x0195, 0x0269, 0x0268,
+    0x0199, 0x0199, 0x019A, 0x019B, 0x026F, 0x0272, 0x019E, 0x0275, 0x006F, 0x006F, 0x01A3, 0x01A3,
+    0x01A5, 0x01A5, 0x0280, 0x01A8, 0x01A8, 0x0283, 0x01AA, 0x01AB, 0x01AD, 0x01AD, 0x0288, 0x0075,
+    0x0075, 0x028A, 0x028B, 0x01B4, 0x01B4, 0x007A, 0x007A, 0x0292, 0x01B9, 0x01B9, 0x01BA, 0x01BB,
+    0x01BD, 0x01BD, 0x01BE, 0x01BF, 0x01C0, 0x01C1, 0x01C2, 0x01C3, 0x01C6, 0x01C6, 0x01C6, 0x01C9,
+    0x01C9, 0x01C9, 0x01CC, 0x01CC, 0x01CC, 0x0061, 0x0061, 0x0069, 0x0069, 0x006F, 0x006F, 0x0075,
+    0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x01DD, 0x0061, 0x0061,
+    0x0061, 0x0061, 0x00E6, 0x00E6, 0x01E5, 0x01E5, 0x0067, 0x0067, 0x006B, 0x006B, 0x006F, 0x006F,
+    0x006F, 0x006F, 0x0292, 0x0292, 0x006A, 0x01F3, 0x01F3, 0x01F3, 0x0067, 0x0067, 0x0195, 0x01BF,
+    0x006E, 0x006E, 0x0061, 0x0061, 0x00E6, 0x00E6, 0x00F8, 0x00F8, 0x0061, 0x0061, 0x0061, 0x0061,
+    0x0065, 0x0065, 0x0065, 0x0065, 0x0069, 0x0069, 0x0069, 0x0069, 0x006F, 0x006F, 0x006F, 0x006F,
+    0x0072, 0x0072, 0x0072, 0x0072, 0x0075, 0x0075, 0x0075, 0x0075, 0x0073, 0x0073, 0x0074, 0x0074,
+    0x021D, 0x021D, 0x0068, 0x0068, 0x019E, 0x0221, 0x0223, 0x0223, 0x0225, 0x0225, 0x0061, 0x0061,
+    0x0065, 0x0065, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x0079, 0x0079,
+    0x0234, 0x0235, 0x0236, 0x0237, 0x0238, 0x0239, 0x023A, 0x023C, 0x023C, 0x019A, 0x023E, 0x023F,
+    0x0240, 0x0242, 0x0242, 0x0180, 0x0289, 0x028C, 0x0247, 0x0247, 0x0249, 0x0249, 0x024B, 0x024B,
+    0x024D, 0x024D, 0x024F, 0x024F, 0x0250, 0x0251, 0x0252, 0x0253, 0x0254, 0x0255, 0x0256, 0x0257,
+    0x0258, 0x0259, 0x025A, 0x025B, 0x025C, 0x025D, 0x025E, 0x025F, 0x0260, 0x0261, 0x0262, 0x0263,
+    0x0264, 0x0265, 0x0266, 0x0267, 0x0069, 0x0269, 0x026A, 0x026B, 0x026C, 0x026D, 0x026E, 0x026F,
+    0x0270, 0x0271, 0x0272, 0x0273, 0x0274, 0x0275, 0x0276, 0x0277, 0x0278, 0x0279, 0x027A, 0x027B,
+    0x027C, 0x027D, 0x027E, 0x027F, 0x0280, 0x0281, 0x0282, 0x0283, 0x0284, 0x0285, 0x0286, 0x0287,
+    0x0288, 0x0289, 0x028A, 0x028B, 0x028C, 0x028D, 0x028E, 0x028F, 0x0290, 0x0291, 0x0292, 0x0293,
+    0x0294, 0x0295, 0x0296, 0x0297, 0x0298, 0x0299, 0x029A, 0x029B, 0x029C, 0x029D, 0x029E, 0x029F,
+    0x02A0, 0x02A1, 0x02A2, 0x02A3, 0x02A4, 0x02A5, 0x02A6, 0x02A7, 0x02A8, 0x02A9, 0x02AA, 0x02AB,
+    0x02AC, 0x02AD, 0x02AE, 0x02AF, 0x02B0, 0x02B1, 0x02B2, 0x02B3, 0x02B4, 0x02B5, 0x02B6, 0x02B7,
+    0x02B8, 0x02B9, 0x02BA, 0x02BB, 0x02BC, 0x02BD, 0x02BE, 0x02BF, 0x02C0, 0x02C1, 0x02C2, 0x02C3,
+    0x02C4, 0x02C5, 0x02C6, 0x02C7, 0x02C8, 0x02C9, 0x02CA, 0x02CB, 0x02CC, 0x02CD, 0x02CE, 0x02CF,
+    0x02D0, 0x02D1, 0x02D2, 0x02D3, 0x02D4, 0x02D5, 0x02D6, 0x02D7, 0x02D8, 0x02D9, 0x02DA, 0x02DB,
+    0x02DC, 0x02DD, 0x02DE, 0x02DF, 0x02E0, 0x02E1, 0x02E2, 0x02E3, 0x02E4, 0x02E5, 0x02E6, 0x02E7,
+    0x02E8, 0x02E9, 0x02EA, 0x02EB, 0x02EC, 0x02ED, 0x02EE, 0x02EF, 0x02F0, 0x02F1, 0x02F2, 0x02F3,
+    0x02F4, 0x02F5, 0x02F6, 0x02F7, 0x02F8, 0x02F9, 0x02FA, 0x02FB, 0x02FC, 0x02FD, 0x02FE, 0x02FF,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0371, 0x0371, 0x0373, 0x0373, 0x02B9, 0x0375, 0x0377, 0x0377,
+    0x0378, 0x0379, 0x037A, 0x037B, 0x037C, 0x037D, 0x003B, 0x03F3, 0x0380, 0x0381, 0x0382, 0x0383,
+    0x0384, 0x00A8, 0x03B1, 0x00B7, 0x03B5, 0x03B7, 0x03B9, 0x038B, 0x03BF, 0x038D, 0x03C5, 0x03C9,
+    0x03B9, 0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7, 0x03B8, 0x03B9, 0x03BA, 0x03BB,
+    0x03BC, 0x03BD, 0x03BE, 0x03BF, 0x03C0, 0x03C1, 0x03A2, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7,
+    0x03C8, 0x03C9, 0x03B9, 0x03C5, 0x03B1, 0x03B5, 0x03B7, 0x03B9, 0x03C5, 0x03B1, 0x03B2, 0x03B3,
+    0x03B4, 0x03B5, 0x03B6, 0x03B7, 0x03B8, 0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF,
+    0x03C0, 0x03C1, 0x03C3, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7, 0x03C8, 0x03C9, 0x03B9, 0x03C5,
+    0x03BF, 0x03C5, 0x03C9, 0x03D7, 0x03B2, 0x03B8, 0x03D2, 0x03D2, 0x03D2, 0x03C6, 0x03C0, 0x03D7,
+    0x03D9, 0x03D9, 0x03DB, 0x03DB, 0x03DD, 0x03DD, 0x03DF, 0x03DF, 0x03E1, 0x03E1, 0x03E3, 0x03E3,
+    0x03E5, 0x03E5, 0x03E7, 0x03E7, 0x03E9, 0x03E9, 0x03EB, 0x03EB, 0x03ED, 0x03ED, 0x03EF, 0x03EF,
+    0x03BA, 0x03C1, 0x03F2, 0x03F3, 0x03B8, 0x03B5, 0x03F6, 0x03F8, 0x03F8, 0x03F2, 0x03FB, 0x03FB,
+    0x03FC, 0x037B, 0x037C, 0x037D, 0x0435, 0x0435, 0x0452, 0x0433, 0x0454, 0x0455, 0x0456, 0x0456,
+    0x0458, 0x0459, 0x045A, 0x045B, 0x043A, 0x0438, 0x0443, 0x045F, 0x0430, 0x0431, 0x0432, 0x0433,
+    0x0434, 0x0435, 0x0436, 0x0437, 0x0438, 0x0438, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447, 0x0448, 0x0449, 0x044A, 0x044B,
+    0x044C, 0x044D, 0x044E, 0x044F, 0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0438, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F, 0x0440, 0x0441, 0x0442, 0x0443,
+    0x0444, 0x0445, 0x0446, 0x0447, 0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+    0x0435, 0x0435, 0x0452, 0x0433, 0x0454, 0x0455, 0x0456, 0x0456, 0x0458, 0x0459, 0x045A, 0x045B,
+    0x043A, 0x0438, 0x0443, 0x045F, 0x0461, 0x0461, 0x0463, 0x0463, 0x0465, 0x0465, 0x0467, 0x0467,
+    0x0469, 0x0469, 0x046B, 0x046B, 0x046D, 0x046D, 0x046F, 0x046F, 0x0471, 0x0471, 0x0473, 0x0473,
+    0x0475, 0x0475, 0x0475, 0x0475, 0x0479, 0x0479, 0x047B, 0x047B, 0x047D, 0x047D, 0x047F, 0x047F,
+    0x0481, 0x0481, 0x0482, 0x0483, 0x0484, 0x0485, 0x0486, 0x0487, 0x0488, 0x0489, 0x048B, 0x048B,
+    0x048D, 0x048D, 0x048F, 0x048F, 0x0491, 0x0491, 0x0493, 0x0493, 0x0495, 0x0495, 0x0497, 0x0497,
+    0x0499, 0x0499, 0x049B, 0x049B, 0x049D, 0x049D, 0x049F, 0x049F, 0x04A1, 0x04A1, 0x04A3, 0x04A3,
+    0x04A5, 0x04A5, 0x04A7, 0x04A7, 0x04A9, 0x04A9, 0x04AB, 0x04AB, 0x04AD, 0x04AD, 0x04AF, 0x04AF,
+    0x04B1, 0x04B1, 0x04B3, 0x04B3, 0x04B5, 0x04B5, 0x04B7, 0x04B7, 0x04B9, 0x04B9, 0x04BB, 0x04BB,
+    0x04BD, 0x04BD, 0x04BF, 0x04BF, 0x04CF, 0x0436, 0x0436, 0x04C4, 0x04C4, 0x04C6, 0x04C6, 0x04C8,
+    0x04C8, 0x04CA, 0x04CA, 0x04CC, 0x04CC, 0x04CE, 0x04CE, 0x04CF, 0x0430, 0x0430, 0x0430, 0x0430,
+    0x04D5, 0x04D5, 0x0435, 0x0435, 0x04D9, 0x04D9, 0x04D9, 0x04D9, 0x0436, 0x0436, 0x0437, 0x0437,
+    0x04E1, 0x04E1, 0x0438, 0x0438, 0x0438, 0x0438, 0x043E, 0x043E, 0x04E9, 0x04E9, 0x04E9, 0x04E9,
+    0x044D, 0x044D, 0x0443, 0x0443, 0x0443, 0x0443, 0x0443, 0x0443, 0x0447, 0x0447, 0x04F7, 0x04F7,
+    0x044B, 0x044B, 0x04FB, 0x04FB, 0x04FD, 0x04FD, 0x04FF, 0x04FF
+};
+
+static const uint16_t FOLD_1E00[0x1EFF - 0x1E00 + 1] = {
+    0x0061, 0x0061, 0x0062, 0x0062, 0x0062, 0x0062, 0x0062, 0x0062, 0x0063, 0x0063, 0x0064, 0x0064,
+    0x0064, 0x0064, 0x0064, 0x0064, 0x0064, 0x0064, 0x0064, 0x0064, 0x0065, 0x0065, 0x0065, 0x0065,
+    0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0066, 0x0066, 0x0067, 0x0067, 0x0068, 0x0068,
+    0x0068, 0x0068, 0x0068, 0x0068, 0x0068, 0x0068, 0x0068, 0x0068, 0x0069, 0x0069, 0x0069, 0x0069,
+    0x006B, 0x006B, 0x006B, 0x006B, 0x006B, 0x006B, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C, 0x006C,
+    0x006C, 0x006C, 0x006D, 0x006D, 0x006D, 0x006D, 0x006D, 0x006D, 0x006E, 0x006E, 0x006E, 0x006E,
+    0x006E, 0x006E, 0x006E, 0x006E, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F,
+    0x0070, 0x0070, 0x0070, 0x0070, 0x0072, 0x0072, 0x0072, 0x0072, 0x0072, 0x0072, 0x0072, 0x0072,
+    0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0073, 0x0074, 0x0074,
+    0x0074, 0x0074, 0x0074, 0x0074, 0x0074, 0x0074, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075,
+    0x0075, 0x0075, 0x0075, 0x0075, 0x0076, 0x0076, 0x0076, 0x0076, 0x0077, 0x0077, 0x0077, 0x0077,
+    0x0077, 0x0077, 0x0077, 0x0077, 0x0077, 0x0077, 0x0078, 0x0078, 0x0078, 0x0078, 0x0079, 0x0079,
+    0x007A, 0x007A, 0x007A, 0x007A, 0x007A, 0x007A, 0x0068, 0x0074, 0x0077, 0x0079, 0x1E9A, 0x0073,
+    0x1E9C, 0x1E9D, 0x1E9E, 0x1E9F, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061,
+    0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061, 0x0061,
+    0x0061, 0x0061, 0x0061, 0x0061, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065,
+    0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0065, 0x0069, 0x0069, 0x0069, 0x0069,
+    0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F,
+    0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F, 0x006F,
+    0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075, 0x0075,
+    0x0075, 0x0075, 0x0079, 0x0079, 0x0079, 0x0079, 0x0079, 0x0079, 0x0079, 0x0079, 0x1EFB, 0x1EFB,
+    0x1EFD, 0x1EFD, 0x1EFF, 0x1EFF
+};
+
+static size_t encode(uint32_t codePoint, char* out) {
+    if (codePoint < 0x80) {
+        out[0] = (char)codePoint;
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        out[0] = (char)(0xC0 | (codePoint >> 6));
+        out[1] = (char)(0x80 | (codePoint & 0x3F));
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codePoint >> 12));
+        out[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (codePoint >> 18));
+    out[1] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codePoint & 0x3F));
+    return 4;
+}
+
+size_t CaseFolder::decode(const unsigned char* text, size_t length, uint32_t& codePoint) {
+    unsigned char lead = text[0];
+    size_t needed;
+    uint32_t minimum;
+    
+    if (lead < 0x80) {
+        codePoint = lead;
+        return 1;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        needed = 2;
+        minimum = 0x80;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        needed = 3;
+        minimum = 0x800;
+        codePoint = lead & 0x0F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        needed = 4;
+        minimum = 0x10000;
+        codePoint = lead & 0x07;
+    } else {
+        codePoint = INVALID;
+        return 1;
+    }
+    
+    if (needed > length) {
+        codePoint = INVALID;
+        return 1;
+    }
+    for (size_t i = 1; i < needed; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            codePoint = INVALID;
+            return 1;
+        }
+        codePoint = (codePoint << 6) | (text[i] & 0x3F);
+    }
+    
+    // Reject overlong forms, surrogates and values past U+10FFFF
+    if (codePoint < minimum || (codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF) {
+        codePoint = INVALID;
+        return 1;
+    }
+    return needed;
+}
+
+size_t CaseFolder::fold(uint32_t codePoint, char* out) {
+    if (codePoint < 0x80) {
+        out[0] = (char)((codePoint >= 'A' && codePoint <= 'Z') ? codePoint | 0x20 : codePoint);
+        return 1;
+    }
+    
+    // Letters that fold to two ASCII letters
+    const char* expansion = nullptr;
+    switch (codePoint) {
+        case 0x00DF: case 0x1E9E: expansion = "ss"; break;
+        case 0x00C6: case 0x00E6: expansion = "ae"; break;
+        case 0x00DE: case 0x00FE: expansion = "th"; break;
+        case 0x0132: case 0x0133: expansion = "ij"; break;
+        case 0x0152: case 0x0153: expansion = "oe"; break;
+        default: break;
+    }
+    if (expansion != nullptr) {
+        out[0] = expansion[0];
+        out[1] = expansion[1];
+        return 2;
+    }
+    
+    if (codePoint >= 0x00C0 && codePoint <= 0x04FF) {
+        codePoint = FOLD_00C0[codePoint - 0x00C0];
+        if (codePoint == 0) return 0;
+    } else if (codePoint >= 0x1E00 && codePoint <= 0x1EFF) {
+        codePoint = FOLD_1E00[codePoint - 0x1E00];
+    } else if (codePoint >= 0xFF01 && codePoint <= 0xFF5E) {
+        return fold(codePoint - 0xFEE0, out);
+    }
+    return encode(codePoint, out);
+}
+
+bool CaseFolder::isSpace(uint32_t codePoint) {
+    return codePoint == 0x0085 || codePoint == 0x00A0 || codePoint == 0x1680 ||
+           (codePoint >= 0x2000 && codePoint <= 0x200A) || codePoint == 0x2028 || codePoint == 0x2029 ||
+           codePoint == 0x202F || codePoint == 0x205F || codePoint == 0x3000;
+}
@@ -0,0 +1,32 @@
+#ifndef CASE_FOLDER_H
+#define CASE_FOLDER_H
+
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+// Table-driven Unicode folding for search. A code point is mapped to lower
+// case with accents and other diacritics removed ("É" -> "e", "Ł" -> "l",
+// "ß" -> "ss", "Ά" -> "α", "Ё" -> "е"); combining marks are dropped and
+// fullwidth ASCII becomes plain ASCII. Covers Latin-1, Latin Extended-A/B,
+// Greek, Cyrillic and Latin Extended Additional (Vietnamese); other code
+// points, CJK for instance, pass through unchanged. The folded form never
+// takes more UTF-8 bytes than the original, so text can be folded in place
+// into a buffer of the same size.
+class CaseFolder {
+public:
+    static const uint32_t INVALID = 0xFFFFFFFF;
+    
+    // Decodes the UTF-8 sequence starting at text[0] (length bytes remain).
+    // Returns the bytes consumed; a malformed sequence consumes one byte and
+    // yields INVALID.
+    static size_t decode(const unsigned char* text, size_t length, uint32_t& codePoint);
+    
+    // Writes the folded form of codePoint as UTF-8; returns the bytes written (0 to drop it)
+    static size_t fold(uint32_t codePoint, char* out);
+    
+    // Unicode white space outside ASCII (no-break space, em space, ideographic space, ...)
+    static bool isSpace(uint32_t codePoint);
+};
+
+#endif
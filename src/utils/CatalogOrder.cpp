@@ -0,0 +1,300 @@
+#include "CatalogOrder.h"
+#include "AuthorRegistry.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+
+const size_t CatalogOrder::BLOCK_SIZE;
+
+CatalogOrder::CatalogOrder() {
+    Less orders[LISTS] = { byISBN, byTitle, byAuthor, byAvailableCopies, byISBN, byTitle, byAuthor };
+    for (int i = 0; i < LISTS; i++) {
+        lists[i].less = orders[i];
+    }
+}
+
+CatalogOrder::~CatalogOrder() {
+    clearUnlocked();
+}
+
+// ============ ORDERS ============
+
+bool CatalogOrder::byISBN(const Listing* a, const Listing* b) {
+    return a->isbn < b->isbn;
+}
+
+bool CatalogOrder::byTitle(const Listing* a, const Listing* b) {
+    int order = a->title.compare(b->title);
+    return order != 0 ? order < 0 : a->isbn < b->isbn;
+}
+
+bool CatalogOrder::byAuthor(const Listing* a, const Listing* b) {
+    int order = a->author.compare(b->author);
+    return order != 0 ? order < 0 : byTitle(a, b);
+}
+
+// Most copies on the shelf first, so available books form a prefix
+bool CatalogOrder::byAvailableCopies(const Listing* a, const Listing* b) {
+    if (a->availableCopies != b->availableCopies) {
+        return a->availableCopies > b->availableCopies;
+    }
+    return byTitle(a, b);
+}
+
+int CatalogOrder::listIndex(SortKey order, bool availableOnly) {
+    if (!availableOnly || order == BY_AVAILABLE_COPIES) {
+        return (int)order;
+    }
+    return ORDERS + (int)order;
+}
+
+// ============ BLOCK LISTS ============
+
+// First block whose last entry does not sort before listing, or the block
+// count when every block does
+size_t CatalogOrder::findBlock(const OrderedList& list, const Listing* listing) {
+    size_t low = 0, high = list.blocks.size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (list.less(list.blocks[mid].back(), listing)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void CatalogOrder::insertInto(OrderedList& list, Listing* listing) {
+    list.count++;
+    if (list.blocks.empty()) {
+        list.blocks.push_back(vector<Listing*>(1, listing));
+        return;
+    }
+    
+    size_t b = min(findBlock(list, listing), list.blocks.size() - 1);
+    vector<Listing*>& block = list.blocks[b];
+    block.insert(lower_bound(block.begin(), block.end(), listing, list.less), listing);
+    
+    if (block.size() > 2 * BLOCK_SIZE) {
+        vector<Listing*> upper(block.begin() + BLOCK_SIZE, block.end());
+        block.resize(BLOCK_SIZE);
+        list.blocks.insert(list.blocks.begin() + b + 1, upper);
+    }
+}
+
+void CatalogOrder::eraseFrom(OrderedList& list, Listing* listing) {
+    size_t b = findBlock(list, listing);
+    if (b == list.blocks.size()) return;
+    
+    vector<Listing*>& block = list.blocks[b];
+    auto it = lower_bound(block.begin(), block.end(), listing, list.less);
+    if (it == block.end() || *it != listing) return;
+    
+    block.erase(it);
+    list.count--;
+    
+    // Fold a shrinking block into its successor so pages never walk many near-empty blocks
+    if (block.empty()) {
+        list.blocks.erase(list.blocks.begin() + b);
+    } else if (block.size() < BLOCK_SIZE / 2 && b + 1 < list.blocks.size() &&
+               block.size() + list.blocks[b + 1].size() <= 2 * BLOCK_SIZE) {
+        block.insert(block.end(), list.blocks[b + 1].begin(), list.blocks[b + 1].end());
+        list.blocks.erase(list.blocks.begin() + b + 1);
+    }
+}
+
+// ============ CATALOG CHANGES ============
+
+CatalogOrder::Listing* CatalogOrder::makeListing(Book* book) {
+    Listing* listing = new Listing();
+    listing->book = book;
+    listing->isbn = book->getISBN();
+    listing->availableCopies = book->getAvailableCopies();
+    
+    size_t count = tokenizer.tokenize(book->getTitle());
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) listing->title += ' ';
+        listing->title.append(tokenizer.tokenData(i), tokenizer.tokenLength(i));
+    }
+    
+    // Books without an author sort after everyone (no UTF-8 byte is 0xFF)
+    const vector<uint32_t>& authorIDs = book->getAuthorIDs();
+    listing->author = authorIDs.empty() ? "\xFF" : AuthorRegistry::getInstance()->getSortKey(authorIDs[0]);
+    return listing;
+}
+
+void CatalogOrder::link(Listing* listing) {
+    for (int i = 0; i < ORDERS; i++) {
+        insertInto(lists[i], listing);
+    }
+    if (listing->availableCopies > 0) {
+        for (int i = ORDERS; i < LISTS; i++) {
+            insertInto(lists[i], listing);
+        }
+    }
+}
+
+void CatalogOrder::unlink(Listing* listing) {
+    for (int i = 0; i < ORDERS; i++) {
+        eraseFrom(lists[i], listing);
+    }
+    if (listing->availableCopies > 0) {
+        for (int i = ORDERS; i < LISTS; i++) {
+            eraseFrom(lists[i], listing);
+        }
+    }
+}
+
+void CatalogOrder::onBookAdded(Book* book) {
+    lock_guard<mutex> lock(orderMutex);
+    if (listings.count(book->getISBN())) return;
+    
+    Listing* listing = makeListing(book);
+    listings[listing->isbn] = listing;
+    link(listing);
+}
+
+void CatalogOrder::onBookRemoved(const Book* book) {
+    lock_guard<mutex> lock(orderMutex);
+    auto it = listings.find(book->getISBN());
+    if (it == listings.end()) return;
+    
+    unlink(it->second);
+    delete it->second;
+    listings.erase(it);
+}
+
+// Only the copies order and membership of the available lists depend on
+// the copy count; the listing still holds the old count to find its entry
+void CatalogOrder::onCopiesChanged(const Book* book) {
+    lock_guard<mutex> lock(orderMutex);
+    auto it = listings.find(book->getISBN());
+    if (it == listings.end()) return;
+    
+    Listing* listing = it->second;
+    int copies = book->getAvailableCopies();
+    if (copies == listing->availableCopies) return;
+    
+    bool wasAvailable = listing->availableCopies > 0;
+    eraseFrom(lists[BY_AVAILABLE_COPIES], listing);
+    listing->availableCopies = copies;
+    insertInto(lists[BY_AVAILABLE_COPIES], listing);
+    
+    if (wasAvailable != (copies > 0)) {
+        for (int i = ORDERS; i < LISTS; i++) {
+            if (copies > 0) {
+                insertInto(lists[i], listing);
+            } else {
+                eraseFrom(lists[i], listing);
+            }
+        }
+    }
+}
+
+void CatalogOrder::rebuild(const vector<Book*>& books) {
+    lock_guard<mutex> lock(orderMutex);
+    clearUnlocked();
+    vector<Listing*> all;
+    all.reserve(books.size());
+    listings.reserve(books.size());
+    for (Book* book : books) {
+        Listing* listing = makeListing(book);
+        if (!listings.insert(make_pair(listing->isbn, listing)).second) {
+            delete listing;
+            continue;
+        }
+        all.push_back(listing);
+    }
+    
+    // Only the ISBN and title orders are sorted. The author and copies orders
+    // break ties by title, so they regroup the title order by author key or
+    // copy count, keeping it within each group; the available lists keep
+    // their full list's order and are filtered from it.
+    vector<Listing*> sorted[ORDERS];
+    sorted[BY_ISBN] = all;
+    sort(sorted[BY_ISBN].begin(), sorted[BY_ISBN].end(), byISBN);
+    sorted[BY_TITLE] = all;
+    sort(sorted[BY_TITLE].begin(), sorted[BY_TITLE].end(), byTitle);
+    
+    map<string, vector<Listing*>> byAuthorKey;
+    map<int, vector<Listing*>, greater<int>> byCopies;
+    for (Listing* listing : sorted[BY_TITLE]) {
+        byAuthorKey[listing->author].push_back(listing);
+        byCopies[listing->availableCopies].push_back(listing);
+    }
+    for (const auto& group : byAuthorKey) {
+        sorted[BY_AUTHOR].insert(sorted[BY_AUTHOR].end(), group.second.begin(), group.second.end());
+    }
+    for (const auto& group : byCopies) {
+        sorted[BY_AVAILABLE_COPIES].insert(sorted[BY_AVAILABLE_COPIES].end(), group.second.begin(), group.second.end());
+    }
+    
+    for (int i = 0; i < LISTS; i++) {
+        vector<Listing*> available;
+        if (i >= ORDERS) {
+            for (Listing* listing : sorted[i - ORDERS]) {
+                if (listing->availableCopies > 0) available.push_back(listing);
+            }
+        }
+        const vector<Listing*>& entries = i < ORDERS ? sorted[i] : available;
+        
+        OrderedList& list = lists[i];
+        for (size_t start = 0; start < entries.size(); start += BLOCK_SIZE) {
+            size_t end = min(start + BLOCK_SIZE, entries.size());
+            list.blocks.push_back(vector<Listing*>(entries.begin() + start, entries.begin() + end));
+        }
+        list.count = entries.size();
+    }
+}
+
+// ============ PAGING ============
+
+vector<Book*> CatalogOrder::getPage(SortKey order, bool availableOnly, size_t offset, size_t count) const {
+    lock_guard<mutex> lock(orderMutex);
+    const OrderedList& list = lists[listIndex(order, availableOnly)];
+    // The available part of the copies order is its first getCount(true) entries
+    size_t end = min(list.count, availableOnly ? countUnlocked(true) : list.count);
+    if (offset >= end) return vector<Book*>();
+    count = min(count, end - offset);
+    
+    vector<Book*> page;
+    page.reserve(count);
+    size_t b = 0;
+    while (offset >= list.blocks[b].size()) {
+        offset -= list.blocks[b].size();
+        b++;
+    }
+    for (; page.size() < count; b++, offset = 0) {
+        const vector<Listing*>& block = list.blocks[b];
+        for (size_t i = offset; i < block.size() && page.size() < count; i++) {
+            page.push_back(block[i]->book);
+        }
+    }
+    return page;
+}
+
+size_t CatalogOrder::getCount(bool availableOnly) const {
+    lock_guard<mutex> lock(orderMutex);
+    return countUnlocked(availableOnly);
+}
+
+size_t CatalogOrder::countUnlocked(bool availableOnly) const {
+    return availableOnly ? lists[listIndex(BY_ISBN, true)].count : listings.size();
+}
+
+void CatalogOrder::clear() {
+    lock_guard<mutex> lock(orderMutex);
+    clearUnlocked();
+}
+
+void CatalogOrder::clearUnlocked() {
+    for (int i = 0; i < LISTS; i++) {
+        lists[i].blocks.clear();
+        lists[i].count = 0;
+    }
+    for (auto& entry : listings) {
+        delete entry.second;
+    }
+    listings.clear();
+}
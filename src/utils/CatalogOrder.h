@@ -0,0 +1,92 @@
+#ifndef CATALOG_ORDER_H
+#define CATALOG_ORDER_H
+
+#include "../entities/Book.h"
+#include "Tokenizer.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+using namespace std;
+
+// Catalog listing orders kept sorted as books change, so a listing page is
+// read straight off a list instead of copying and sorting the catalog on
+// every view. Each order is a list of blocks of at most 2 * BLOCK_SIZE
+// entries: an insert or removal binary-searches the blocks and shifts
+// entries within one block, and a page walks the block sizes to its first
+// entry and then reads pageSize entries. The whole catalog and the books
+// with a copy on the shelf each have their own ISBN, title and author
+// lists; the most-copies-available list serves both, since available books
+// come first in it. Sort keys are computed once per book and shared by all
+// of its list entries.
+class CatalogOrder {
+public:
+    enum SortKey { BY_ISBN, BY_TITLE, BY_AUTHOR, BY_AVAILABLE_COPIES };
+
+private:
+    static const size_t BLOCK_SIZE = 256;
+    
+    // A book's sort keys, with ISBN as the final tie-break in every order
+    struct Listing {
+        Book* book;
+        string isbn;
+        string title;       // folded
+        string author;      // first author's sort key, surname first
+        int availableCopies;
+    };
+    
+    typedef bool (*Less)(const Listing* a, const Listing* b);
+    
+    struct OrderedList {
+        vector<vector<Listing*>> blocks;
+        size_t count;
+        Less less;
+        
+        OrderedList() : count(0), less(nullptr) {}
+    };
+    
+    static const int ORDERS = 4;
+    static const int LISTS = ORDERS + 3;
+    // Indexed by listIndex(): the ORDERS orders over every book, then ISBN,
+    // title and author over available books only
+    OrderedList lists[LISTS];
+    unordered_map<string, Listing*> listings;
+    Tokenizer tokenizer;
+    // Loans move books in the copies order while other sessions read pages
+    mutable mutex orderMutex;
+    
+    static bool byISBN(const Listing* a, const Listing* b);
+    static bool byTitle(const Listing* a, const Listing* b);
+    static bool byAuthor(const Listing* a, const Listing* b);
+    static bool byAvailableCopies(const Listing* a, const Listing* b);
+    
+    static void insertInto(OrderedList& list, Listing* listing);
+    static void eraseFrom(OrderedList& list, Listing* listing);
+    static size_t findBlock(const OrderedList& list, const Listing* listing);
+    static int listIndex(SortKey order, bool availableOnly);
+    
+    Listing* makeListing(Book* book);
+    void link(Listing* listing);
+    void unlink(Listing* listing);
+    size_t countUnlocked(bool availableOnly) const;
+    void clearUnlocked();
+
+public:
+    CatalogOrder();
+    ~CatalogOrder();
+    
+    // Kept in step with every catalog mutation, like CirculationStats
+    void onBookAdded(Book* book);
+    void onBookRemoved(const Book* book);
+    void onCopiesChanged(const Book* book);
+    // Replaces the contents with books, sorting each order once
+    void rebuild(const vector<Book*>& books);
+    
+    // Up to count books starting at position offset of the order
+    vector<Book*> getPage(SortKey order, bool availableOnly, size_t offset, size_t count) const;
+    size_t getCount(bool availableOnly) const;
+    
+    void clear();
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "CirculationStats.h"
+#include "../Config.h"
+#include <sstream>
+
+CirculationStats::CirculationStats() 
+    : totalCopies(0), availableCopies(0), titlesAvailable(0), lifetimeBorrows(0) {}
+
+int CirculationStats::dayKey(time_t time) {
+    tm ltm;
+    #ifdef _WIN32
+        localtime_s(&ltm, &time);
+    #else
+        localtime_r(&time, &ltm);
+    #endif
+    return (1900 + ltm.tm_year) * 10000 + (1 + ltm.tm_mon) * 100 + ltm.tm_mday;
+}
+
+void CirculationStats::onCopiesChanged(int oldQuantity, int oldAvailable, int newQuantity, int newAvailable) {
+    lock_guard<mutex> lock(statsMutex);
+    applyCopies(oldQuantity, oldAvailable, newQuantity, newAvailable);
+}
+
+void CirculationStats::applyCopies(int oldQuantity, int oldAvailable, int newQuantity, int newAvailable) {
+    totalCopies += newQuantity - oldQuantity;
+    availableCopies += newAvailable - oldAvailable;
+    
+    if (oldAvailable > 0 && newAvailable == 0) {
+        titlesAvailable--;
+    } else if (oldAvailable == 0 && newAvailable > 0) {
+        titlesAvailable++;
+    }
+}
+
+void CirculationStats::onBookAdded(const Book* book) {
+    lock_guard<mutex> lock(statsMutex);
+    applyCopies(0, 0, book->getQuantity(), book->getAvailableCopies());
+}
+
+void CirculationStats::onBookRemoved(const Book* book) {
+    lock_guard<mutex> lock(statsMutex);
+    applyCopies(book->getQuantity(), book->getAvailableCopies(), 0, 0);
+}
+
+void CirculationStats::rebuildCopies(const vector<Book*>& books) {
+    lock_guard<mutex> lock(statsMutex);
+    totalCopies = 0;
+    availableCopies = 0;
+    titlesAvailable = 0;
+    
+    for (Book* book : books) {
+        applyCopies(0, 0, book->getQuantity(), book->getAvailableCopies());
+    }
+}
+
+void CirculationStats::recordTransaction(const Transaction* trans) {
+    lock_guard<mutex> lock(statsMutex);
+    DailyCount& today = dailyCounts[dayKey(trans->getTime())];
+    
+    if (trans->getType() == Transaction::BORROW) {
+        lifetimeBorrows++;
+        bookBorrows[trans->getISBN()]++;
+        userBorrows[trans->getUserID()]++;
+        today.borrows++;
+    } else {
+        today.returns++;
+    }
+}
+
+long CirculationStats::getTotalCopies() const {
+    lock_guard<mutex> lock(statsMutex);
+    return totalCopies;
+}
+
+long CirculationStats::getAvailableCopies() const {
+    lock_guard<mutex> lock(statsMutex);
+    return availableCopies;
+}
+
+long CirculationStats::getLoanedCopies() const {
+    lock_guard<mutex> lock(statsMutex);
+    return totalCopies - availableCopies;
+}
+
+int CirculationStats::getTitlesAvailable() const {
+    lock_guard<mutex> lock(statsMutex);
+    return titlesAvailable;
+}
+
+long CirculationStats::getLifetimeBorrows() const {
+    lock_guard<mutex> lock(statsMutex);
+    return lifetimeBorrows;
+}
+
+int CirculationStats::getBookBorrowCount(string isbn) const {
+    lock_guard<mutex> lock(statsMutex);
+    auto it = bookBorrows.find(isbn);
+    return it != bookBorrows.end() ? it->second : 0;
+}
+
+int CirculationStats::getUserBorrowCount(string userID) const {
+    lock_guard<mutex> lock(statsMutex);
+    auto it = userBorrows.find(userID);
+    return it != userBorrows.end() ? it->second : 0;
+}
+
+int CirculationStats::getBorrowsOn(time_t day) const {
+    lock_guard<mutex> lock(statsMutex);
+    auto it = dailyCounts.find(dayKey(day));
+    return it != dailyCounts.end() ? it->second.borrows : 0;
+}
+
+int CirculationStats::getReturnsOn(time_t day) const {
+    lock_guard<mutex> lock(statsMutex);
+    auto it = dailyCounts.find(dayKey(day));
+    return it != dailyCounts.end() ? it->second.returns : 0;
+}
+
+vector<string> CirculationStats::toFileLines() const {
+    lock_guard<mutex> lock(statsMutex);
+    vector<string> lines;
+    
+    for (const auto& entry : bookBorrows) {
+        lines.push_back("B" + string(1, CSV_DELIMITER) + entry.first + CSV_DELIMITER + to_string(entry.second));
+    }
+    for (const auto& entry : userBorrows) {
+        lines.push_back("U" + string(1, CSV_DELIMITER) + entry.first + CSV_DELIMITER + to_string(entry.second));
+    }
+    for (const auto& entry : dailyCounts) {
+        lines.push_back("D" + string(1, CSV_DELIMITER) + to_string(entry.first) + CSV_DELIMITER +
+                        to_string(entry.second.borrows) + CSV_DELIMITER + to_string(entry.second.returns));
+    }
+    
+    return lines;
+}
+
+void CirculationStats::loadFileLine(string line) {
+    lock_guard<mutex> lock(statsMutex);
+    stringstream ss(line);
+    string kind, key, first, second;
+    
+    getline(ss, kind, CSV_DELIMITER);
+    getline(ss, key, CSV_DELIMITER);
+    getline(ss, first, CSV_DELIMITER);
+    getline(ss, second, CSV_DELIMITER);
+    
+    if (kind == "B") {
+        int count = stoi(first);
+        bookBorrows[key] = count;
+        lifetimeBorrows += count;
+    } else if (kind == "U") {
+        userBorrows[key] = stoi(first);
+    } else if (kind == "D") {
+        DailyCount& day = dailyCounts[stoi(key)];
+        day.borrows = stoi(first);
+        day.returns = stoi(second);
+    }
+}
+
+void CirculationStats::clearCounters() {
+    lock_guard<mutex> lock(statsMutex);
+    lifetimeBorrows = 0;
+    bookBorrows.clear();
+    userBorrows.clear();
+    dailyCounts.clear();
+}
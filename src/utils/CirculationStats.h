@@ -0,0 +1,68 @@
+#ifndef CIRCULATION_STATS_H
+#define CIRCULATION_STATS_H
+
+#include "../entities/Book.h"
+#include "../entities/Transaction.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <ctime>
+#include <mutex>
+using namespace std;
+
+// Materialized circulation aggregates. Copy counters are kept in step with
+// every catalog mutation and loan; lifetime and daily counters are persisted
+// so statistics screens never walk the catalog or the transaction history.
+class CirculationStats {
+private:
+    struct DailyCount {
+        int borrows;
+        int returns;
+        
+        DailyCount() : borrows(0), returns(0) {}
+    };
+    
+    long totalCopies;
+    long availableCopies;
+    int titlesAvailable;
+    long lifetimeBorrows;
+    unordered_map<string, int> bookBorrows;
+    unordered_map<string, int> userBorrows;
+    map<int, DailyCount> dailyCounts;
+    // Loans of different books update the counters at the same time
+    mutable mutex statsMutex;
+    
+    static int dayKey(time_t time);
+    void applyCopies(int oldQuantity, int oldAvailable, int newQuantity, int newAvailable);
+
+public:
+    CirculationStats();
+    
+    // Catalog changes: pass copy counts before and after the mutation
+    void onCopiesChanged(int oldQuantity, int oldAvailable, int newQuantity, int newAvailable);
+    void onBookAdded(const Book* book);
+    void onBookRemoved(const Book* book);
+    void rebuildCopies(const vector<Book*>& books);
+    
+    // Circulation events
+    void recordTransaction(const Transaction* trans);
+    
+    // Getters
+    long getTotalCopies() const;
+    long getAvailableCopies() const;
+    long getLoanedCopies() const;
+    int getTitlesAvailable() const;
+    long getLifetimeBorrows() const;
+    int getBookBorrowCount(string isbn) const;
+    int getUserBorrowCount(string userID) const;
+    int getBorrowsOn(time_t day) const;
+    int getReturnsOn(time_t day) const;
+    
+    // Persistence of the counters that cannot be derived from the catalog
+    vector<string> toFileLines() const;
+    void loadFileLine(string line);
+    void clearCounters();
+};
+
+#endif
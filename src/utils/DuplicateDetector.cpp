@@ -0,0 +1,146 @@
+#include "DuplicateDetector.h"
+#include <algorithm>
+
+// SplitMix64 finalizer
+uint64_t DuplicateDetector::mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Records are shingled on their folded words, so case, accents and spacing
+// differences cost nothing; the padding spaces make word starts and ends
+// shingles of their own
+size_t DuplicateDetector::add(const string& title, const string& author) {
+    text = " ";
+    size_t count = tokenizer.tokenize(title);
+    for (size_t i = 0; i < count; i++) {
+        text.append(tokenizer.tokenData(i), tokenizer.tokenLength(i));
+        text += ' ';
+    }
+    text += "| ";
+    count = tokenizer.tokenize(author);
+    for (size_t i = 0; i < count; i++) {
+        text.append(tokenizer.tokenData(i), tokenizer.tokenLength(i));
+        text += ' ';
+    }
+    
+    fill(minimum, minimum + HASHES, UINT32_MAX);
+    for (size_t i = 0; i + 3 <= text.size(); i++) {
+        uint64_t shingle = (uint64_t)(unsigned char)text[i] | ((uint64_t)(unsigned char)text[i + 1] << 8) |
+                           ((uint64_t)(unsigned char)text[i + 2] << 16);
+        
+        // The HASHES hash functions are h1 + k * h2 (Kirsch-Mitzenmacher):
+        // two mixes per shingle instead of one per function, then one add each
+        uint64_t value = mix(shingle);
+        uint64_t step = mix(shingle ^ 0xA0761D6478BD642FULL) | 1;
+        for (int k = 0; k < HASHES; k++) {
+            minimum[k] = min(minimum[k], (uint32_t)(value >> 32));
+            value += step;
+        }
+    }
+    
+    size_t record = hashed.size();
+    // "| " alone, from an empty title and author, has nothing to compare
+    hashed.push_back(text.size() > 3);
+    for (int k = 0; k < HASHES; k++) {
+        signatures.push_back((uint8_t)minimum[k]);
+    }
+    return record;
+}
+
+// Two different minima still agree on their low 8 bits one time in 256;
+// that share is taken back out of the agreement rate
+double DuplicateDetector::estimateSimilarity(size_t a, size_t b) const {
+    if (!hashed[a] || !hashed[b]) return 0.0;
+    
+    const uint8_t* first = &signatures[a * HASHES];
+    const uint8_t* second = &signatures[b * HASHES];
+    int agree = 0;
+    for (int k = 0; k < HASHES; k++) {
+        agree += first[k] == second[k];
+    }
+    
+    const double chance = 1.0 / 256;
+    double estimate = ((double)agree / HASHES - chance) / (1.0 - chance);
+    return max(0.0, estimate);
+}
+
+size_t DuplicateDetector::find(vector<size_t>& parent, size_t item) {
+    while (parent[item] != item) {
+        parent[item] = parent[parent[item]];
+        item = parent[item];
+    }
+    return item;
+}
+
+// One band at a time: records are sorted by the band's key, and each record
+// in a run of equal keys is compared with the run's first record. Joined
+// groups keep their lowest index as root.
+vector<vector<size_t>> DuplicateDetector::findClusters(double threshold) const {
+    size_t count = hashed.size();
+    vector<size_t> parent(count);
+    for (size_t i = 0; i < count; i++) {
+        parent[i] = i;
+    }
+    
+    vector<pair<uint32_t, uint32_t>> keyed;
+    keyed.reserve(count);
+    for (int band = 0; band < BANDS; band++) {
+        keyed.clear();
+        for (size_t record = 0; record < count; record++) {
+            if (!hashed[record]) continue;
+            
+            const uint8_t* rows = &signatures[record * HASHES + band * ROWS];
+            uint32_t key = (uint32_t)rows[0] | ((uint32_t)rows[1] << 8) | ((uint32_t)rows[2] << 16) |
+                           ((uint32_t)rows[3] << 24);
+            keyed.push_back(make_pair(key, (uint32_t)record));
+        }
+        sort(keyed.begin(), keyed.end());
+        
+        size_t start = 0;
+        for (size_t i = 1; i < keyed.size(); i++) {
+            if (keyed[i].first != keyed[start].first) {
+                start = i;
+                continue;
+            }
+            
+            size_t first = find(parent, keyed[start].second);
+            size_t other = find(parent, keyed[i].second);
+            if (first != other && estimateSimilarity(keyed[start].second, keyed[i].second) >= threshold) {
+                parent[max(first, other)] = min(first, other);
+            }
+        }
+    }
+    
+    // A root comes before its members, so clusters open in order of their first record
+    vector<size_t> members(count, 0);
+    for (size_t record = 0; record < count; record++) {
+        members[find(parent, record)]++;
+    }
+    
+    vector<vector<size_t>> clusters;
+    vector<size_t> clusterOf(count, SIZE_MAX);
+    for (size_t record = 0; record < count; record++) {
+        size_t root = find(parent, record);
+        if (members[root] < 2) continue;
+        
+        if (root == record) {
+            clusterOf[root] = clusters.size();
+            clusters.push_back(vector<size_t>());
+            clusters.back().reserve(members[root]);
+        }
+        clusters[clusterOf[root]].push_back(record);
+    }
+    return clusters;
+}
+
+size_t DuplicateDetector::size() const {
+    return hashed.size();
+}
+
+void DuplicateDetector::clear() {
+    signatures.clear();
+    hashed.clear();
+}
@@ -0,0 +1,50 @@
+#ifndef DUPLICATE_DETECTOR_H
+#define DUPLICATE_DETECTOR_H
+
+#include "Tokenizer.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+// Near-duplicate finder for catalog records. Each record's folded
+// "title | author" text is cut into character 3-gram shingles and reduced
+// to a MinHash signature, whose agreement rate estimates the Jaccard
+// similarity of two records' shingle sets. LSH banding turns the search
+// for similar pairs into grouping: the signature is split into BANDS bands
+// of ROWS values, and only records sharing a whole band are compared, each
+// with the first record of its group, so the work grows with the number of
+// records rather than the number of pairs. Signature values are kept as
+// their low 8 bits (b-bit MinHash): 64 bytes a record, and a band's four
+// bytes are its grouping key.
+class DuplicateDetector {
+private:
+    static const int BANDS = 16;
+    static const int ROWS = 4;
+    static const int HASHES = BANDS * ROWS;
+    
+    vector<uint8_t> signatures;     // HASHES per record
+    vector<bool> hashed;            // false for records without shingles
+    
+    Tokenizer tokenizer;
+    string text;
+    uint32_t minimum[HASHES];
+    
+    static uint64_t mix(uint64_t value);
+    static size_t find(vector<size_t>& parent, size_t item);
+
+public:
+    // Returns the record's index, used by estimateSimilarity and findClusters
+    size_t add(const string& title, const string& author);
+    
+    double estimateSimilarity(size_t a, size_t b) const;
+    // Groups of two or more records, joined whenever a record's estimated
+    // similarity to one it shares a band with reaches threshold; records in
+    // each group and groups themselves are in order of index
+    vector<vector<size_t>> findClusters(double threshold) const;
+    
+    size_t size() const;
+    void clear();
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "FacetIndex.h"
+#include "AuthorRegistry.h"
+#include <algorithm>
+#include <cstdlib>
+
+const uint32_t FacetIndex::NO_VALUE;
+
+// Everything before the title number and check digit of a hyphenated ISBN:
+// "978-0-201-63361-0" -> "978-0-201", "0-13-110362-8" -> "0-13".
+// Unhyphenated ISBNs carry no registrant boundary and get no value.
+string FacetIndex::publisherPrefix(const string& isbn) {
+    size_t last = isbn.rfind('-');
+    if (last == string::npos || last == 0) return "";
+    
+    size_t titleStart = isbn.rfind('-', last - 1);
+    if (titleStart == string::npos || isbn.find('-') == titleStart) return "";
+    return isbn.substr(0, titleStart);
+}
+
+void FacetIndex::assign(Facet facet, uint32_t docID, const string& key, const string& label) {
+    FacetValues& values = facets[facet];
+    if (values.documents.size() <= docID) {
+        values.documents.resize(docID + 1, NO_VALUE);
+    }
+    
+    auto it = values.ids.find(key);
+    if (it == values.ids.end()) {
+        it = values.ids.insert(make_pair(key, (uint32_t)values.labels.size())).first;
+        values.labels.push_back(label);
+        values.members.push_back(RoaringBitmap());
+    }
+    values.members[it->second].add(docID);
+    values.documents[docID] = it->second;
+}
+
+void FacetIndex::release(Facet facet, uint32_t docID) {
+    FacetValues& values = facets[facet];
+    if (docID >= values.documents.size() || values.documents[docID] == NO_VALUE) return;
+    
+    values.members[values.documents[docID]].remove(docID);
+    values.documents[docID] = NO_VALUE;
+}
+
+void FacetIndex::add(uint32_t docID, const Book* book) {
+    if (documentAuthors.size() <= docID) {
+        documentAuthors.resize(docID + 1, NO_VALUE);
+    }
+    documentAuthors[docID] = book->getAuthorListID();
+    for (uint32_t authorID : book->getAuthorIDs()) {
+        if (authorDocs.size() <= authorID) {
+            authorDocs.resize(authorID + 1);
+        }
+        authorDocs[authorID].add(docID);
+    }
+    
+    string publisher = publisherPrefix(book->getISBN());
+    if (!publisher.empty()) {
+        assign(PUBLISHER_FACET, docID, publisher, publisher);
+    }
+    
+    string quantity = to_string(book->getQuantity());
+    assign(QUANTITY_FACET, docID, quantity, quantity);
+}
+
+void FacetIndex::remove(uint32_t docID) {
+    if (docID < documentAuthors.size() && documentAuthors[docID] != NO_VALUE) {
+        for (uint32_t authorID : AuthorRegistry::getInstance()->getList(documentAuthors[docID])) {
+            authorDocs[authorID].remove(docID);
+        }
+        documentAuthors[docID] = NO_VALUE;
+    }
+    
+    for (int facet = 0; facet < FACETS; facet++) {
+        release((Facet)facet, docID);
+    }
+}
+
+void FacetIndex::updateQuantity(uint32_t docID, int quantity) {
+    release(QUANTITY_FACET, docID);
+    string key = to_string(quantity);
+    assign(QUANTITY_FACET, docID, key, key);
+}
+
+// ============ FILTERING ============
+
+void FacetIndex::selectValues(Facet facet, const vector<uint32_t>& valueIDs, RoaringBitmap& out) const {
+    out.clear();
+    for (uint32_t valueID : valueIDs) {
+        out.uniteWith(facets[facet].members[valueID]);
+    }
+}
+
+bool FacetIndex::select(const Filter& filter, RoaringBitmap& out) {
+    out.clear();
+    bool restricted = false;
+    
+    for (int facet = 0; facet < FACETS; facet++) {
+        const FacetValues& values = facets[facet];
+        vector<uint32_t> valueIDs;
+        
+        RoaringBitmap chosen;
+        if (facet == AUTHOR_FACET) {
+            if (filter.authors.empty()) continue;
+            for (const string& author : filter.authors) {
+                uint32_t authorID;
+                if (AuthorRegistry::getInstance()->find(author, authorID) && authorID < authorDocs.size()) {
+                    chosen.uniteWith(authorDocs[authorID]);
+                }
+            }
+        } else if (facet == PUBLISHER_FACET) {
+            if (filter.publisherPrefixes.empty()) continue;
+            for (uint32_t valueID = 0; valueID < values.labels.size(); valueID++) {
+                for (const string& prefix : filter.publisherPrefixes) {
+                    if (values.labels[valueID].compare(0, prefix.size(), prefix) == 0) {
+                        valueIDs.push_back(valueID);
+                        break;
+                    }
+                }
+            }
+        } else {
+            if (filter.minQuantity < 0 && filter.maxQuantity < 0) continue;
+            for (uint32_t valueID = 0; valueID < values.labels.size(); valueID++) {
+                int quantity = atoi(values.labels[valueID].c_str());
+                if ((filter.minQuantity < 0 || quantity >= filter.minQuantity) &&
+                    (filter.maxQuantity < 0 || quantity <= filter.maxQuantity)) {
+                    valueIDs.push_back(valueID);
+                }
+            }
+        }
+        
+        if (facet != AUTHOR_FACET) {
+            selectValues((Facet)facet, valueIDs, chosen);
+        }
+        if (!restricted) {
+            out = chosen;
+            restricted = true;
+        } else {
+            out.intersectWith(chosen);
+        }
+    }
+    return restricted;
+}
+
+// ============ COUNTS ============
+
+// Largest counts first, ties in label order
+void FacetIndex::keepTop(vector<Count>& ranked, size_t k, vector<Count>& out) {
+    sort(ranked.begin(), ranked.end(), [](const Count& a, const Count& b) {
+        return a.count != b.count ? a.count > b.count : a.value < b.value;
+    });
+    
+    out.clear();
+    for (size_t i = 0; i < ranked.size() && i < k; i++) {
+        out.push_back(ranked[i]);
+    }
+}
+
+void FacetIndex::topValues(Facet facet, const vector<uint32_t>& docs, size_t k, vector<Count>& out) const {
+    const FacetValues& values = facets[facet];
+    unordered_map<uint32_t, uint32_t> tally;
+    for (uint32_t docID : docs) {
+        if (docID < values.documents.size() && values.documents[docID] != NO_VALUE) {
+            tally[values.documents[docID]]++;
+        }
+    }
+    
+    vector<Count> ranked;
+    for (const auto& entry : tally) {
+        Count count = { values.labels[entry.first], entry.second };
+        ranked.push_back(count);
+    }
+    keepTop(ranked, k, out);
+}
+
+// Documents are tallied per author list first, since books by the same
+// authors share one; each list's tally then goes to all of its authors
+void FacetIndex::topAuthors(const vector<uint32_t>& docs, size_t k, vector<Count>& out) const {
+    unordered_map<uint32_t, uint32_t> listTally;
+    for (uint32_t docID : docs) {
+        if (docID < documentAuthors.size() && documentAuthors[docID] != NO_VALUE) {
+            listTally[documentAuthors[docID]]++;
+        }
+    }
+    
+    AuthorRegistry* registry = AuthorRegistry::getInstance();
+    unordered_map<uint32_t, uint32_t> tally;
+    for (const auto& entry : listTally) {
+        for (uint32_t authorID : registry->getList(entry.first)) {
+            tally[authorID] += entry.second;
+        }
+    }
+    
+    vector<Count> ranked;
+    for (const auto& entry : tally) {
+        Count count = { registry->getName(entry.first), entry.second };
+        ranked.push_back(count);
+    }
+    keepTop(ranked, k, out);
+}
+
+void FacetIndex::count(const vector<uint32_t>& docs, const RoaringBitmap& available, size_t k, Counts& counts) const {
+    counts.total = (uint32_t)docs.size();
+    counts.available = 0;
+    for (uint32_t docID : docs) {
+        if (available.contains(docID)) counts.available++;
+    }
+    
+    topAuthors(docs, k, counts.authors);
+    topValues(PUBLISHER_FACET, docs, k, counts.publishers);
+    topValues(QUANTITY_FACET, docs, k, counts.quantities);
+}
+
+void FacetIndex::authorDocuments(uint32_t authorID, vector<uint32_t>& out) const {
+    out.clear();
+    if (authorID < authorDocs.size()) {
+        authorDocs[authorID].toVector(out);
+    }
+}
+
+uint32_t FacetIndex::authorDocumentCount(uint32_t authorID) const {
+    return authorID < authorDocs.size() ? authorDocs[authorID].getCardinality() : 0;
+}
+
+void FacetIndex::clear() {
+    for (int facet = 0; facet < FACETS; facet++) {
+        facets[facet] = FacetValues();
+    }
+    authorDocs.clear();
+    documentAuthors.clear();
+}
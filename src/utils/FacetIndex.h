@@ -0,0 +1,91 @@
+#ifndef FACET_INDEX_H
+#define FACET_INDEX_H
+
+#include "../entities/Book.h"
+#include "RoaringBitmap.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+using namespace std;
+
+// Precomputed document bitmaps for faceted search: one per author, per ISBN
+// publisher prefix (EAN prefix, group and registrant, e.g. "978-0-201") and
+// per copy count. A filter ORs the chosen values of each facet and ANDs the
+// facets together, so narrowing a search never touches the catalog. Each
+// facet also keeps the value of every document, which turns per-facet
+// counts over a result set into one pass over that set. Authors are keyed
+// by AuthorRegistry ID and a book with several authors is in each one's
+// bitmap, so an author's bitmap is the list of all their books.
+class FacetIndex {
+public:
+    enum Facet { AUTHOR_FACET = 0, PUBLISHER_FACET = 1, QUANTITY_FACET = 2 };
+    
+    // Empty lists and negative bounds leave that facet unrestricted
+    struct Filter {
+        vector<string> authors;
+        vector<string> publisherPrefixes;
+        int minQuantity;
+        int maxQuantity;
+        bool availableOnly;
+        
+        Filter() : minQuantity(-1), maxQuantity(-1), availableOnly(false) {}
+    };
+    
+    struct Count {
+        string value;
+        uint32_t count;
+    };
+    
+    // Most common values of each facet among the matches, largest first
+    struct Counts {
+        uint32_t total;
+        uint32_t available;
+        vector<Count> authors;
+        vector<Count> publishers;
+        vector<Count> quantities;
+    };
+
+private:
+    static const int FACETS = 3;
+    static const uint32_t NO_VALUE = UINT32_MAX;
+    
+    // Value dictionary of one facet; documents[docID] is that document's value
+    struct FacetValues {
+        unordered_map<string, uint32_t> ids;
+        vector<string> labels;
+        vector<RoaringBitmap> members;
+        vector<uint32_t> documents;
+    };
+    
+    // Publisher and quantity values; authors use the registry's IDs instead
+    FacetValues facets[FACETS];
+    vector<RoaringBitmap> authorDocs;
+    vector<uint32_t> documentAuthors;   // author list ID per document
+    
+    void assign(Facet facet, uint32_t docID, const string& key, const string& label);
+    void release(Facet facet, uint32_t docID);
+    void selectValues(Facet facet, const vector<uint32_t>& valueIDs, RoaringBitmap& out) const;
+    void topValues(Facet facet, const vector<uint32_t>& docs, size_t k, vector<Count>& out) const;
+    void topAuthors(const vector<uint32_t>& docs, size_t k, vector<Count>& out) const;
+    static void keepTop(vector<Count>& ranked, size_t k, vector<Count>& out);
+
+public:
+    void add(uint32_t docID, const Book* book);
+    void remove(uint32_t docID);
+    void updateQuantity(uint32_t docID, int quantity);
+    
+    // Documents passing the author, publisher and quantity parts of filter;
+    // returns false, leaving out empty, when none of them restricts anything
+    bool select(const Filter& filter, RoaringBitmap& out);
+    void count(const vector<uint32_t>& docs, const RoaringBitmap& available, size_t k, Counts& counts) const;
+    
+    // Every document crediting the author, in ID order
+    void authorDocuments(uint32_t authorID, vector<uint32_t>& out) const;
+    uint32_t authorDocumentCount(uint32_t authorID) const;
+    
+    static string publisherPrefix(const string& isbn);
+    void clear();
+};
+
+#endif
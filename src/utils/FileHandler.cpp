@@ -88,7 +88,7 @@ bool FileHandler::saveBooks(BookBST* bookTree, string filename) {
     vector<Book*> books = bookTree->getAllBooksSorted();
     vector<string> lines;
     
-    lines.push_back("ISBN,Title,Author,Quantity,AvailableCopies");
+    lines.push_back("ISBN,Title,Author,Quantity,AvailableCopies,EditionOf");
     
     for (Book* book : books) {
         lines.push_back(book->toFileString());
@@ -165,7 +165,7 @@ bool FileHandler::saveTransactions(TransactionList* transList, string filename)
     return writeLines(filename, lines);
 }
 
-bool FileHandler::loadTransactions(TransactionList* transList, string filename) {
+bool FileHandler::loadTransactions(TransactionList* transList, string filename, uint64_t skipThroughID) {
     if (!fileExists(filename)) {
         return false;
     }
@@ -177,6 +177,11 @@ bool FileHandler::loadTransactions(TransactionList* transList, string filename)
     for (size_t i = 1; i < lines.size(); i++) {
         try {
             Transaction* trans = new Transaction(Transaction::fromFileString(lines[i]));
+            if (trans->getID() <= skipThroughID) {
+                // Already archived; left over from an interrupted save
+                delete trans;
+                continue;
+            }
             transList->append(trans);
         } catch (...) {
             continue;
@@ -186,6 +191,37 @@ bool FileHandler::loadTransactions(TransactionList* transList, string filename)
     return true;
 }
 
+bool FileHandler::saveStatistics(CirculationStats* stats, string filename) {
+    vector<string> lines;
+    
+    lines.push_back("Kind,Key,Borrows,Returns");
+    
+    vector<string> statLines = stats->toFileLines();
+    lines.insert(lines.end(), statLines.begin(), statLines.end());
+    
+    return writeLines(filename, lines);
+}
+
+bool FileHandler::loadStatistics(CirculationStats* stats, string filename) {
+    if (!fileExists(filename)) {
+        return false;
+    }
+    
+    vector<string> lines = readLines(filename);
+    
+    if (lines.empty()) return false;
+    
+    for (size_t i = 1; i < lines.size(); i++) {
+        try {
+            stats->loadFileLine(lines[i]);
+        } catch (...) {
+            continue;
+        }
+    }
+    
+    return true;
+}
+
 vector<string> FileHandler::split(string str, char delimiter) {
     vector<string> tokens;
     stringstream ss(str);
@@ -4,6 +4,7 @@
 #include "BookBST.h"
 #include "UserHashMap.h"
 #include "TransactionList.h"
+#include "CirculationStats.h"
 #include <string>
 #include <vector>
 
@@ -21,7 +22,9 @@ public:
     static bool saveUsers(UserHashMap* userMap, string filename);
     static bool loadUsers(UserHashMap* userMap, string filename);
     static bool saveTransactions(TransactionList* transList, string filename);
-    static bool loadTransactions(TransactionList* transList, string filename);
+    static bool loadTransactions(TransactionList* transList, string filename, uint64_t skipThroughID = 0);
+    static bool saveStatistics(CirculationStats* stats, string filename);
+    static bool loadStatistics(CirculationStats* stats, string filename);
     
     static vector<string> split(string str, char delimiter);
     static string trim(string str);
@@ -0,0 +1,368 @@
+#include "IndexSegment.h"
+#include <algorithm>
+#include <queue>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+IndexSegment::IndexSegment() 
+    : mapping(nullptr), mappingBytes(0), words(nullptr), docBegin(0), docEnd(0), termCount(0),
+      termIDs(nullptr), segmentID(0), persisted(false) {
+    offsets[0] = offsets[1] = nullptr;
+    docs[0] = docs[1] = nullptr;
+    positionOffsets[0] = positionOffsets[1] = nullptr;
+    positions[0] = positions[1] = nullptr;
+}
+
+IndexSegment::~IndexSegment() {
+#ifndef _WIN32
+    if (mapping != nullptr) {
+        munmap(mapping, mappingBytes);
+    }
+#endif
+}
+
+// ============ POSITION RUNS ============
+
+static inline void writeVarint(uint32_t value, vector<uint8_t>& out) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static inline uint32_t readVarint(const uint8_t*& p) {
+    uint32_t value = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        value |= (uint32_t)(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= (uint32_t)(*p++) << shift;
+    return value;
+}
+
+// Bytes taken by the run starting at run, skipped without decoding the gaps
+static size_t runLength(const uint8_t* run) {
+    const uint8_t* p = run;
+    uint32_t count = readVarint(p);
+    for (uint32_t i = 0; i < count; i++) {
+        while (*p++ & 0x80) {
+        }
+    }
+    return p - run;
+}
+
+// Positions must be ascending; the first gap is measured from position 0
+void IndexSegment::encodePositions(const vector<uint32_t>& positions, vector<uint8_t>& out) {
+    writeVarint((uint32_t)positions.size(), out);
+    uint32_t previous = 0;
+    for (uint32_t position : positions) {
+        writeVarint(position - previous, out);
+        previous = position;
+    }
+}
+
+// Walks a term's postings and runs in step, decoding only the wanted documents
+void IndexSegment::collectPositions(const uint32_t* docs, size_t docCount, const uint8_t* runs,
+                                    const vector<uint32_t>& wanted, PositionLists& out) {
+    const uint8_t* p = runs;
+    size_t next = 0;
+    
+    for (size_t i = 0; i < docCount && next < wanted.size(); i++) {
+        while (next < wanted.size() && wanted[next] < docs[i]) next++;
+        if (next == wanted.size() || wanted[next] != docs[i]) {
+            p += runLength(p);
+            continue;
+        }
+        
+        out.docs.push_back(docs[i]);
+        out.starts.push_back((uint32_t)out.positions.size());
+        uint32_t count = readVarint(p);
+        uint32_t position = 0;
+        for (uint32_t k = 0; k < count; k++) {
+            position += readVarint(p);
+            out.positions.push_back(position);
+        }
+    }
+}
+
+// ============ LAYOUT ============
+
+size_t IndexSegment::wordCount() const {
+    return HEADER_WORDS + termCount + 4 * ((size_t)termCount + 1) +
+           words[4] + words[5] + words[6] + words[7];
+}
+
+// Points the views into data after checking that the layout is consistent
+bool IndexSegment::attach(const uint32_t* data, size_t wordCount) {
+    if (wordCount < HEADER_WORDS || data[0] != MAGIC) return false;
+    
+    uint32_t terms = data[3];
+    uint64_t needed = (uint64_t)HEADER_WORDS + terms + 4 * ((uint64_t)terms + 1) + 
+                      (uint64_t)data[4] + data[5] + data[6] + data[7];
+    if (needed != wordCount || data[1] > data[2]) return false;
+    
+    words = data;
+    docBegin = data[1];
+    docEnd = data[2];
+    termCount = terms;
+    termIDs = data + HEADER_WORDS;
+    offsets[TITLE_FIELD] = termIDs + terms;
+    offsets[AUTHOR_FIELD] = offsets[TITLE_FIELD] + terms + 1;
+    docs[TITLE_FIELD] = offsets[AUTHOR_FIELD] + terms + 1;
+    docs[AUTHOR_FIELD] = docs[TITLE_FIELD] + data[4];
+    positionOffsets[TITLE_FIELD] = docs[AUTHOR_FIELD] + data[5];
+    positionOffsets[AUTHOR_FIELD] = positionOffsets[TITLE_FIELD] + terms + 1;
+    positions[TITLE_FIELD] = (const uint8_t*)(positionOffsets[AUTHOR_FIELD] + terms + 1);
+    positions[AUTHOR_FIELD] = positions[TITLE_FIELD] + (size_t)data[6] * sizeof(uint32_t);
+    
+    return offsets[TITLE_FIELD][terms] == data[4] && offsets[AUTHOR_FIELD][terms] == data[5] &&
+           positionOffsets[TITLE_FIELD][terms] <= (uint64_t)data[6] * sizeof(uint32_t) &&
+           positionOffsets[AUTHOR_FIELD][terms] <= (uint64_t)data[7] * sizeof(uint32_t);
+}
+
+IndexSegment* IndexSegment::fromWords(vector<uint32_t>& data) {
+    IndexSegment* segment = new IndexSegment();
+    segment->owned.swap(data);
+    if (!segment->attach(segment->owned.data(), segment->owned.size())) {
+        delete segment;
+        return nullptr;
+    }
+    return segment;
+}
+
+IndexSegment* IndexSegment::build(uint32_t docBegin, uint32_t docEnd, const vector<TermPostings>& terms) {
+    size_t docCount[2] = { 0, 0 };
+    size_t byteCount[2] = { 0, 0 };
+    for (const TermPostings& term : terms) {
+        docCount[TITLE_FIELD] += term.title ? term.title->size() : 0;
+        docCount[AUTHOR_FIELD] += term.author ? term.author->size() : 0;
+        byteCount[TITLE_FIELD] += term.titlePositions ? term.titlePositions->size() : 0;
+        byteCount[AUTHOR_FIELD] += term.authorPositions ? term.authorPositions->size() : 0;
+    }
+    uint32_t positionWords[2];
+    for (int field = 0; field < 2; field++) {
+        positionWords[field] = (uint32_t)((byteCount[field] + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    }
+    
+    uint32_t termTotal = (uint32_t)terms.size();
+    vector<uint32_t> data;
+    data.reserve(HEADER_WORDS + termTotal + 4 * ((size_t)termTotal + 1) + docCount[0] + docCount[1] +
+                 positionWords[0] + positionWords[1]);
+    uint32_t header[HEADER_WORDS] = { MAGIC, docBegin, docEnd, termTotal,
+                                      (uint32_t)docCount[TITLE_FIELD], (uint32_t)docCount[AUTHOR_FIELD],
+                                      positionWords[TITLE_FIELD], positionWords[AUTHOR_FIELD] };
+    data.insert(data.end(), header, header + HEADER_WORDS);
+    
+    for (const TermPostings& term : terms) {
+        data.push_back(term.termID);
+    }
+    for (int field = 0; field < 2; field++) {
+        uint32_t offset = 0;
+        data.push_back(offset);
+        for (const TermPostings& term : terms) {
+            const vector<uint32_t>* list = field == TITLE_FIELD ? term.title : term.author;
+            offset += list ? (uint32_t)list->size() : 0;
+            data.push_back(offset);
+        }
+    }
+    for (int field = 0; field < 2; field++) {
+        for (const TermPostings& term : terms) {
+            const vector<uint32_t>* list = field == TITLE_FIELD ? term.title : term.author;
+            if (list) {
+                data.insert(data.end(), list->begin(), list->end());
+            }
+        }
+    }
+    for (int field = 0; field < 2; field++) {
+        uint32_t offset = 0;
+        data.push_back(offset);
+        for (const TermPostings& term : terms) {
+            const vector<uint8_t>* runs = field == TITLE_FIELD ? term.titlePositions : term.authorPositions;
+            offset += runs ? (uint32_t)runs->size() : 0;
+            data.push_back(offset);
+        }
+    }
+    for (int field = 0; field < 2; field++) {
+        size_t start = data.size();
+        data.resize(start + positionWords[field], 0);
+        uint8_t* bytes = (uint8_t*)(data.data() + start);
+        for (const TermPostings& term : terms) {
+            const vector<uint8_t>* runs = field == TITLE_FIELD ? term.titlePositions : term.authorPositions;
+            if (runs && !runs->empty()) {
+                bytes = copy(runs->begin(), runs->end(), bytes);
+            }
+        }
+    }
+    
+    return fromWords(data);
+}
+
+IndexSegment* IndexSegment::merge(const vector<const IndexSegment*>& inputs, const RoaringBitmap& deleted) {
+    typedef pair<uint32_t, size_t> Cursor;    // (term ID, input index)
+    priority_queue<Cursor, vector<Cursor>, greater<Cursor>> heap;
+    vector<uint32_t> slots(inputs.size(), 0);
+    
+    uint32_t docBegin = inputs.empty() ? 0 : inputs.front()->docBegin;
+    uint32_t docEnd = inputs.empty() ? 0 : inputs.back()->docEnd;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (inputs[i]->termCount > 0) {
+            heap.push(Cursor(inputs[i]->termIDs[0], i));
+        }
+    }
+    
+    vector<uint32_t> termList;
+    vector<vector<uint32_t>> docLists[2];
+    vector<vector<uint8_t>> runLists[2];
+    
+    // Entries for one term pop in input order, which is document order
+    while (!heap.empty()) {
+        uint32_t termID = heap.top().first;
+        vector<uint32_t> merged[2];
+        vector<uint8_t> runs[2];
+        
+        while (!heap.empty() && heap.top().first == termID) {
+            size_t i = heap.top().second;
+            heap.pop();
+            
+            const IndexSegment* input = inputs[i];
+            uint32_t slot = slots[i]++;
+            for (int field = 0; field < 2; field++) {
+                const uint8_t* run = input->positions[field] + input->positionOffsets[field][slot];
+                for (uint32_t p = input->offsets[field][slot]; p < input->offsets[field][slot + 1]; p++) {
+                    uint32_t docID = input->docs[field][p];
+                    size_t length = runLength(run);
+                    if (!deleted.contains(docID)) {
+                        merged[field].push_back(docID);
+                        runs[field].insert(runs[field].end(), run, run + length);
+                    }
+                    run += length;
+                }
+            }
+            
+            if (slots[i] < input->termCount) {
+                heap.push(Cursor(input->termIDs[slots[i]], i));
+            }
+        }
+        
+        if (!merged[TITLE_FIELD].empty() || !merged[AUTHOR_FIELD].empty()) {
+            termList.push_back(termID);
+            for (int field = 0; field < 2; field++) {
+                docLists[field].push_back(vector<uint32_t>());
+                docLists[field].back().swap(merged[field]);
+                runLists[field].push_back(vector<uint8_t>());
+                runLists[field].back().swap(runs[field]);
+            }
+        }
+    }
+    
+    vector<TermPostings> terms(termList.size());
+    for (size_t i = 0; i < termList.size(); i++) {
+        terms[i].termID = termList[i];
+        terms[i].title = &docLists[TITLE_FIELD][i];
+        terms[i].author = &docLists[AUTHOR_FIELD][i];
+        terms[i].titlePositions = &runLists[TITLE_FIELD][i];
+        terms[i].authorPositions = &runLists[AUTHOR_FIELD][i];
+    }
+    return build(docBegin, docEnd, terms);
+}
+
+IndexSegment* IndexSegment::mapFile(const string& path) {
+#ifdef _WIN32
+    // No mmap here: read the file into owned memory instead
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open()) return nullptr;
+    
+    streamoff bytes = file.tellg();
+    if (bytes <= 0 || bytes % sizeof(uint32_t) != 0) return nullptr;
+    
+    vector<uint32_t> data((size_t)bytes / sizeof(uint32_t));
+    file.seekg(0);
+    if (!file.read((char*)data.data(), bytes)) return nullptr;
+    
+    IndexSegment* segment = fromWords(data);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0 || info.st_size % sizeof(uint32_t) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    
+    void* region = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) return nullptr;
+    
+    IndexSegment* segment = new IndexSegment();
+    segment->mapping = region;
+    segment->mappingBytes = (size_t)info.st_size;
+    if (!segment->attach((const uint32_t*)region, segment->mappingBytes / sizeof(uint32_t))) {
+        delete segment;
+        return nullptr;
+    }
+#endif
+    if (segment != nullptr) {
+        segment->persisted = true;
+    }
+    return segment;
+}
+
+bool IndexSegment::writeFile(const string& path) const {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) return false;
+    
+    file.write((const char*)words, wordCount() * sizeof(uint32_t));
+    return file.good();
+}
+
+bool IndexSegment::appendPostings(uint32_t termID, Field field, vector<uint32_t>& out) const {
+    const uint32_t* end = termIDs + termCount;
+    const uint32_t* pos = lower_bound(termIDs, end, termID);
+    if (pos == end || *pos != termID) return false;
+    
+    size_t slot = pos - termIDs;
+    out.insert(out.end(), docs[field] + offsets[field][slot], docs[field] + offsets[field][slot + 1]);
+    return true;
+}
+
+void IndexSegment::appendPositions(uint32_t termID, Field field, const vector<uint32_t>& wanted, 
+                                   PositionLists& out) const {
+    const uint32_t* end = termIDs + termCount;
+    const uint32_t* pos = lower_bound(termIDs, end, termID);
+    if (pos == end || *pos != termID) return;
+    
+    size_t slot = pos - termIDs;
+    collectPositions(docs[field] + offsets[field][slot], offsets[field][slot + 1] - offsets[field][slot],
+                     positions[field] + positionOffsets[field][slot], wanted, out);
+}
+
+uint32_t IndexSegment::getDocBegin() const { return docBegin; }
+uint32_t IndexSegment::getDocEnd() const { return docEnd; }
+uint32_t IndexSegment::getTermCount() const { return termCount; }
+
+size_t IndexSegment::getPostingCount() const {
+    return (size_t)offsets[TITLE_FIELD][termCount] + offsets[AUTHOR_FIELD][termCount];
+}
+
+size_t IndexSegment::getPositionBytes() const {
+    return (size_t)positionOffsets[TITLE_FIELD][termCount] + positionOffsets[AUTHOR_FIELD][termCount];
+}
+
+size_t IndexSegment::getMemoryBytes() const {
+    return mapping != nullptr ? 0 : owned.capacity() * sizeof(uint32_t);
+}
+
+bool IndexSegment::isMapped() const { return mapping != nullptr; }
+int IndexSegment::getSegmentID() const { return segmentID; }
+void IndexSegment::setSegmentID(int id) { segmentID = id; }
+bool IndexSegment::isPersisted() const { return persisted; }
+void IndexSegment::setPersisted(bool value) { persisted = value; }
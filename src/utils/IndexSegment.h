@@ -0,0 +1,109 @@
+#ifndef INDEX_SEGMENT_H
+#define INDEX_SEGMENT_H
+
+#include "RoaringBitmap.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+// Immutable slice of the inverted index covering the document IDs
+// [docBegin, docEnd). Terms and postings are stored as one flat array of
+// 32-bit words, which is also the file format, so a persisted segment can be
+// memory-mapped and queried without being parsed:
+//
+//   header | term IDs (sorted) | title offsets | author offsets | title docs | author docs
+//          | title position offsets | author position offsets | title positions | author positions
+//
+// Offsets have termCount + 1 entries; term i's postings in a field are
+// docs[offsets[i] .. offsets[i + 1]). Each posting also has a run of token
+// positions: a varint count followed by varint gaps between positions. A
+// term's runs are stored back to back in posting order, starting at its
+// byte offset into the field's position bytes (padded to whole words).
+class IndexSegment {
+public:
+    enum Field { TITLE_FIELD = 0, AUTHOR_FIELD = 1 };
+    
+    // Postings of one term in both fields, as handed to build(); the position
+    // vectors hold one encoded run per posting, in the same order
+    struct TermPostings {
+        uint32_t termID;
+        const vector<uint32_t>* title;
+        const vector<uint32_t>* author;
+        const vector<uint8_t>* titlePositions;
+        const vector<uint8_t>* authorPositions;
+    };
+    
+    // Decoded positions of one term: document i's positions are
+    // positions[starts[i] .. starts[i + 1]), or up to the end for the last one
+    struct PositionLists {
+        vector<uint32_t> docs;
+        vector<uint32_t> starts;
+        vector<uint32_t> positions;
+    };
+
+private:
+    static const uint32_t MAGIC = 0x4C4D5332;    // "LMS2"
+    static const uint32_t HEADER_WORDS = 8;
+    
+    vector<uint32_t> owned;
+    void* mapping;
+    size_t mappingBytes;
+    
+    const uint32_t* words;
+    uint32_t docBegin;
+    uint32_t docEnd;
+    uint32_t termCount;
+    const uint32_t* termIDs;
+    const uint32_t* offsets[2];
+    const uint32_t* docs[2];
+    const uint32_t* positionOffsets[2];
+    const uint8_t* positions[2];
+    
+    int segmentID;
+    bool persisted;
+    
+    IndexSegment();
+    size_t wordCount() const;
+    bool attach(const uint32_t* data, size_t wordCount);
+    static IndexSegment* fromWords(vector<uint32_t>& data);
+    
+    // Non-copyable: views point into owned storage or a mapping
+    IndexSegment(const IndexSegment&);
+    IndexSegment& operator=(const IndexSegment&);
+
+public:
+    ~IndexSegment();
+    
+    static IndexSegment* build(uint32_t docBegin, uint32_t docEnd, const vector<TermPostings>& terms);
+    // k-way merge of adjacent segments (in document order), dropping deleted documents
+    static IndexSegment* merge(const vector<const IndexSegment*>& inputs, const RoaringBitmap& deleted);
+    static IndexSegment* mapFile(const string& path);
+    bool writeFile(const string& path) const;
+    
+    // Appends the term's postings in field to out; returns false if the term is absent
+    bool appendPostings(uint32_t termID, Field field, vector<uint32_t>& out) const;
+    // Appends the term's positions in those of wanted (sorted) that contain it
+    void appendPositions(uint32_t termID, Field field, const vector<uint32_t>& wanted, PositionLists& out) const;
+    
+    // Position runs, shared with the engine's in-memory segment
+    static void encodePositions(const vector<uint32_t>& positions, vector<uint8_t>& out);
+    static void collectPositions(const uint32_t* docs, size_t docCount, const uint8_t* runs,
+                                 const vector<uint32_t>& wanted, PositionLists& out);
+    
+    uint32_t getDocBegin() const;
+    uint32_t getDocEnd() const;
+    uint32_t getTermCount() const;
+    size_t getPostingCount() const;
+    size_t getPositionBytes() const;
+    size_t getMemoryBytes() const;
+    bool isMapped() const;
+    
+    int getSegmentID() const;
+    void setSegmentID(int id);
+    bool isPersisted() const;
+    void setPersisted(bool value);
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "PrefixDictionary.h"
+#include <algorithm>
+
+PrefixDictionary::PrefixDictionary() {}
+
+void PrefixDictionary::writeVarint(string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+uint32_t PrefixDictionary::readVarint(const string& in, size_t& pos) {
+    uint32_t value = 0;
+    int shift = 0;
+    
+    while (pos < in.size()) {
+        unsigned char byte = (unsigned char)in[pos++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) break;
+        shift += 7;
+    }
+    
+    return value;
+}
+
+void PrefixDictionary::build(const vector<string>& terms) {
+    clear();
+    
+    for (uint32_t i = 0; i < terms.size(); i++) {
+        if (!terms[i].empty()) {
+            sortedTermIDs.push_back(i);
+        }
+    }
+    sort(sortedTermIDs.begin(), sortedTermIDs.end(), [&terms](uint32_t a, uint32_t b) {
+        return terms[a] < terms[b];
+    });
+    
+    const string* previous = nullptr;
+    for (size_t i = 0; i < sortedTermIDs.size(); i++) {
+        const string& term = terms[sortedTermIDs[i]];
+        
+        if (i % BLOCK_SIZE == 0) {
+            blockOffsets.push_back((uint32_t)data.size());
+            writeVarint(data, (uint32_t)term.length());
+            data += term;
+        } else {
+            size_t shared = 0;
+            while (shared < term.length() && shared < previous->length() && 
+                   term[shared] == (*previous)[shared]) {
+                shared++;
+            }
+            writeVarint(data, (uint32_t)shared);
+            writeVarint(data, (uint32_t)(term.length() - shared));
+            data.append(term, shared, string::npos);
+        }
+        
+        previous = &term;
+    }
+}
+
+string PrefixDictionary::blockHead(size_t block) const {
+    size_t pos = blockOffsets[block];
+    uint32_t length = readVarint(data, pos);
+    return data.substr(pos, length);
+}
+
+void PrefixDictionary::findPrefix(const string& prefix, vector<uint32_t>& termIDs) const {
+    if (blockOffsets.empty()) return;
+    
+    // Last block whose head sorts before the prefix; matches may start there
+    size_t low = 0, high = blockOffsets.size();
+    while (high - low > 1) {
+        size_t mid = (low + high) / 2;
+        if (blockHead(mid) < prefix) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    
+    string term;
+    for (size_t block = low; block < blockOffsets.size(); block++) {
+        size_t pos = blockOffsets[block];
+        size_t end = block + 1 < blockOffsets.size() ? blockOffsets[block + 1] : data.size();
+        size_t index = block * BLOCK_SIZE;
+        
+        while (pos < end) {
+            if (index % BLOCK_SIZE == 0) {
+                uint32_t length = readVarint(data, pos);
+                term.assign(data, pos, length);
+                pos += length;
+            } else {
+                uint32_t shared = readVarint(data, pos);
+                uint32_t length = readVarint(data, pos);
+                term.resize(shared);
+                term.append(data, pos, length);
+                pos += length;
+            }
+            
+            if (term.compare(0, prefix.length(), prefix) == 0) {
+                termIDs.push_back(sortedTermIDs[index]);
+            } else if (term > prefix) {
+                return;
+            }
+            index++;
+        }
+    }
+}
+
+int PrefixDictionary::getTermCount() const {
+    return (int)sortedTermIDs.size();
+}
+
+size_t PrefixDictionary::getMemoryBytes() const {
+    return data.capacity() + blockOffsets.capacity() * sizeof(uint32_t) + 
+           sortedTermIDs.capacity() * sizeof(uint32_t);
+}
+
+void PrefixDictionary::clear() {
+    data.clear();
+    blockOffsets.clear();
+    sortedTermIDs.clear();
+}
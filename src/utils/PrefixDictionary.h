@@ -0,0 +1,37 @@
+#ifndef PREFIX_DICTIONARY_H
+#define PREFIX_DICTIONARY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+// Sorted, front-coded term array for prefix lookups. Terms are stored in
+// blocks: the first term of each block verbatim, the rest as the length of
+// the prefix shared with the previous term plus the remaining suffix. A
+// lookup binary-searches the block heads and decodes forward from there.
+class PrefixDictionary {
+private:
+    static const int BLOCK_SIZE = 16;
+    
+    string data;
+    vector<uint32_t> blockOffsets;
+    vector<uint32_t> sortedTermIDs;
+    
+    static void writeVarint(string& out, uint32_t value);
+    static uint32_t readVarint(const string& in, size_t& pos);
+    string blockHead(size_t block) const;
+
+public:
+    PrefixDictionary();
+    
+    // terms[i] is the text of term ID i; empty entries are skipped
+    void build(const vector<string>& terms);
+    void findPrefix(const string& prefix, vector<uint32_t>& termIDs) const;
+    
+    int getTermCount() const;
+    size_t getMemoryBytes() const;
+    void clear();
+};
+
+#endif
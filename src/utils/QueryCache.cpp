@@ -0,0 +1,79 @@
+#include "QueryCache.h"
+
+QueryCache::QueryCache(size_t capacity) : capacity(capacity) {
+    clear();
+}
+
+bool QueryCache::lookup(const string& key, uint64_t indexGeneration, uint64_t availabilityGeneration,
+                        vector<uint32_t>& docs) {
+    auto it = lookupTable.find(key);
+    if (it == lookupTable.end()) {
+        stats.misses++;
+        return false;
+    }
+    
+    Entry& entry = *it->second;
+    if (entry.indexGeneration != indexGeneration || entry.availabilityGeneration != availabilityGeneration) {
+        entries.erase(it->second);
+        lookupTable.erase(it);
+        stats.misses++;
+        stats.staleMisses++;
+        return false;
+    }
+    
+    entries.splice(entries.begin(), entries, it->second);
+    docs = entry.docs;
+    stats.hits++;
+    return true;
+}
+
+void QueryCache::store(const string& key, uint64_t indexGeneration, uint64_t availabilityGeneration,
+                       const vector<uint32_t>& docs) {
+    if (capacity == 0) return;
+    
+    auto it = lookupTable.find(key);
+    if (it != lookupTable.end()) {
+        entries.erase(it->second);
+        lookupTable.erase(it);
+    }
+    
+    if (entries.size() >= capacity) {
+        lookupTable.erase(entries.back().key);
+        entries.pop_back();
+        stats.evictions++;
+    }
+    
+    Entry entry;
+    entry.key = key;
+    entry.indexGeneration = indexGeneration;
+    entry.availabilityGeneration = availabilityGeneration;
+    entry.docs = docs;
+    entries.push_front(entry);
+    lookupTable[key] = entries.begin();
+}
+
+void QueryCache::recordLatency(bool hit, double micros) {
+    if (hit) {
+        stats.hitMicros += micros;
+    } else {
+        stats.missMicros += micros;
+    }
+}
+
+QueryCache::Stats QueryCache::getStats() const {
+    Stats current = stats;
+    current.entries = entries.size();
+    current.capacity = capacity;
+    return current;
+}
+
+double QueryCache::getHitRatio() const {
+    uint64_t total = stats.hits + stats.misses;
+    return total == 0 ? 0.0 : (double)stats.hits / total;
+}
+
+void QueryCache::clear() {
+    entries.clear();
+    lookupTable.clear();
+    stats = Stats();
+}
@@ -0,0 +1,58 @@
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+using namespace std;
+
+// Bounded LRU cache of search results (document IDs) keyed by normalized
+// query. Each entry remembers the index generation it was computed at, and
+// the availability generation for queries filtered on availability; a
+// lookup against a newer generation is a miss, so a catalog change
+// invalidates exactly the results it could affect.
+class QueryCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t staleMisses;
+        uint64_t evictions;
+        double hitMicros;
+        double missMicros;
+        size_t entries;
+        size_t capacity;
+    };
+
+private:
+    struct Entry {
+        string key;
+        uint64_t indexGeneration;
+        uint64_t availabilityGeneration;
+        vector<uint32_t> docs;
+    };
+    
+    size_t capacity;
+    list<Entry> entries;    // most recently used first
+    unordered_map<string, list<Entry>::iterator> lookupTable;
+    Stats stats;
+
+public:
+    explicit QueryCache(size_t capacity);
+    
+    bool lookup(const string& key, uint64_t indexGeneration, uint64_t availabilityGeneration,
+                vector<uint32_t>& docs);
+    void store(const string& key, uint64_t indexGeneration, uint64_t availabilityGeneration,
+               const vector<uint32_t>& docs);
+    
+    // Time taken to answer a query, split by whether the cache answered it
+    void recordLatency(bool hit, double micros);
+    
+    Stats getStats() const;
+    double getHitRatio() const;
+    void clear();
+};
+
+#endif
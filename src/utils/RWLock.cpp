@@ -0,0 +1,67 @@
+#include "RWLock.h"
+#include <vector>
+#include <utility>
+
+// Shared holds of the calling thread: which locks, and how deeply nested
+static thread_local vector<pair<const RWLock*, int>> sharedHolds;
+
+RWLock::RWLock() : readers(0), writersWaiting(0), writing(false) {}
+
+int& RWLock::sharedDepth() const {
+    for (pair<const RWLock*, int>& hold : sharedHolds) {
+        if (hold.first == this) return hold.second;
+    }
+    sharedHolds.push_back(make_pair(this, 0));
+    return sharedHolds.back().second;
+}
+
+void RWLock::lockShared() {
+    int& depth = sharedDepth();
+    if (depth > 0) {
+        depth++;
+        return;
+    }
+    
+    unique_lock<mutex> lock(stateMutex);
+    readersMayEnter.wait(lock, [this] { return !writing && writersWaiting == 0; });
+    readers++;
+    depth = 1;
+}
+
+void RWLock::unlockShared() {
+    int& depth = sharedDepth();
+    if (--depth > 0) return;
+    
+    // Forget the lock so the list only ever holds locks this thread is in
+    for (size_t i = 0; i < sharedHolds.size(); i++) {
+        if (sharedHolds[i].first == this) {
+            sharedHolds[i] = sharedHolds.back();
+            sharedHolds.pop_back();
+            break;
+        }
+    }
+    
+    lock_guard<mutex> lock(stateMutex);
+    if (--readers == 0 && writersWaiting > 0) {
+        writerMayEnter.notify_one();
+    }
+}
+
+void RWLock::lock() {
+    unique_lock<mutex> lock(stateMutex);
+    writersWaiting++;
+    writerMayEnter.wait(lock, [this] { return !writing && readers == 0; });
+    writersWaiting--;
+    writing = true;
+}
+
+void RWLock::unlock() {
+    lock_guard<mutex> lock(stateMutex);
+    writing = false;
+    // The next writer goes first; readers only enter once none is waiting
+    if (writersWaiting > 0) {
+        writerMayEnter.notify_one();
+    } else {
+        readersMayEnter.notify_all();
+    }
+}
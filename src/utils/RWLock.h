@@ -0,0 +1,54 @@
+#ifndef RW_LOCK_H
+#define RW_LOCK_H
+
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+
+// Reader-writer lock: any number of threads may hold it shared, or one
+// thread exclusively. Writers are preferred, so a steady stream of readers
+// cannot starve an admin's catalog change: once a writer is waiting, new
+// readers queue behind it. A thread that already holds the lock shared may
+// take it shared again without queueing (the outer hold keeps it safe), so
+// a caller can keep pointers returned by a locked operation valid; a thread
+// must not take it exclusively while holding it in either mode.
+class RWLock {
+private:
+    mutex stateMutex;
+    condition_variable readersMayEnter;
+    condition_variable writerMayEnter;
+    int readers;
+    int writersWaiting;
+    bool writing;
+    
+    // Nesting depth of the calling thread's shared hold on this lock
+    int& sharedDepth() const;
+
+public:
+    RWLock();
+    
+    void lockShared();
+    void unlockShared();
+    void lock();
+    void unlock();
+    
+    class ReadGuard {
+    private:
+        RWLock& rwLock;
+
+    public:
+        explicit ReadGuard(RWLock& lock) : rwLock(lock) { rwLock.lockShared(); }
+        ~ReadGuard() { rwLock.unlockShared(); }
+    };
+    
+    class WriteGuard {
+    private:
+        RWLock& rwLock;
+
+    public:
+        explicit WriteGuard(RWLock& lock) : rwLock(lock) { rwLock.lock(); }
+        ~WriteGuard() { rwLock.unlock(); }
+    };
+};
+
+#endif
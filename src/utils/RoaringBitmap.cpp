@@ -0,0 +1,305 @@
+#include "RoaringBitmap.h"
+#include <algorithm>
+
+RoaringBitmap::RoaringBitmap() : cardinality(0) {}
+
+static inline uint32_t lowestBit(uint64_t bits) {
+#ifdef __GNUC__
+    return (uint32_t)__builtin_ctzll(bits);
+#else
+    uint32_t index = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Index of the container for key, or containers.size() if there is none
+size_t RoaringBitmap::findContainer(uint16_t key) const {
+    size_t low = 0, high = containers.size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (containers[mid].key < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return (low < containers.size() && containers[low].key == key) ? low : containers.size();
+}
+
+bool RoaringBitmap::containerHas(const Container& container, uint16_t low) {
+    if (container.isBitset()) {
+        return (container.bits[low >> 6] >> (low & 63)) & 1;
+    }
+    return binary_search(container.array.begin(), container.array.end(), low);
+}
+
+void RoaringBitmap::toBitset(Container& container) {
+    container.bits.assign(BITSET_WORDS, 0);
+    for (uint16_t low : container.array) {
+        container.bits[low >> 6] |= (uint64_t)1 << (low & 63);
+    }
+    vector<uint16_t>().swap(container.array);
+}
+
+void RoaringBitmap::toArray(Container& container) {
+    container.array.clear();
+    container.array.reserve(container.cardinality);
+    for (uint32_t word = 0; word < BITSET_WORDS; word++) {
+        for (uint64_t bits = container.bits[word]; bits != 0; bits &= bits - 1) {
+            container.array.push_back((uint16_t)(word * 64 + lowestBit(bits)));
+        }
+    }
+    vector<uint64_t>().swap(container.bits);
+}
+
+bool RoaringBitmap::add(uint32_t id) {
+    uint16_t key = (uint16_t)(id >> 16);
+    uint16_t low = (uint16_t)(id & 0xFFFF);
+    
+    auto pos = lower_bound(containers.begin(), containers.end(), key,
+                           [](const Container& c, uint16_t k) { return c.key < k; });
+    if (pos == containers.end() || pos->key != key) {
+        Container container;
+        container.key = key;
+        container.cardinality = 0;
+        pos = containers.insert(pos, container);
+    }
+    
+    Container& container = *pos;
+    if (container.isBitset()) {
+        uint64_t& word = container.bits[low >> 6];
+        uint64_t mask = (uint64_t)1 << (low & 63);
+        if (word & mask) return false;
+        word |= mask;
+    } else {
+        auto slot = lower_bound(container.array.begin(), container.array.end(), low);
+        if (slot != container.array.end() && *slot == low) return false;
+        container.array.insert(slot, low);
+        if (container.array.size() > ARRAY_LIMIT) {
+            toBitset(container);
+        }
+    }
+    
+    container.cardinality++;
+    cardinality++;
+    return true;
+}
+
+bool RoaringBitmap::remove(uint32_t id) {
+    size_t index = findContainer((uint16_t)(id >> 16));
+    if (index == containers.size()) return false;
+    
+    Container& container = containers[index];
+    uint16_t low = (uint16_t)(id & 0xFFFF);
+    
+    if (container.isBitset()) {
+        uint64_t& word = container.bits[low >> 6];
+        uint64_t mask = (uint64_t)1 << (low & 63);
+        if (!(word & mask)) return false;
+        word &= ~mask;
+    } else {
+        auto slot = lower_bound(container.array.begin(), container.array.end(), low);
+        if (slot == container.array.end() || *slot != low) return false;
+        container.array.erase(slot);
+    }
+    
+    container.cardinality--;
+    cardinality--;
+    
+    // Convert back well below the limit so a container hovering around it
+    // does not flip representation on every add/remove
+    if (container.cardinality == 0) {
+        containers.erase(containers.begin() + index);
+    } else if (container.isBitset() && container.cardinality <= ARRAY_LIMIT / 2) {
+        toArray(container);
+    }
+    return true;
+}
+
+bool RoaringBitmap::contains(uint32_t id) const {
+    size_t index = findContainer((uint16_t)(id >> 16));
+    return index != containers.size() && containerHas(containers[index], (uint16_t)(id & 0xFFFF));
+}
+
+uint32_t RoaringBitmap::getCardinality() const {
+    return cardinality;
+}
+
+size_t RoaringBitmap::getMemoryBytes() const {
+    size_t bytes = containers.capacity() * sizeof(Container);
+    for (const Container& container : containers) {
+        bytes += container.array.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+void RoaringBitmap::toVector(vector<uint32_t>& out) const {
+    out.clear();
+    out.reserve(cardinality);
+    
+    for (const Container& container : containers) {
+        uint32_t high = (uint32_t)container.key << 16;
+        if (!container.isBitset()) {
+            for (uint16_t low : container.array) {
+                out.push_back(high | low);
+            }
+            continue;
+        }
+        
+        for (uint32_t word = 0; word < BITSET_WORDS; word++) {
+            for (uint64_t bits = container.bits[word]; bits != 0; bits &= bits - 1) {
+                out.push_back(high | (word * 64 + lowestBit(bits)));
+            }
+        }
+    }
+}
+
+// Walks the list once; the container only changes when the high half does
+void RoaringBitmap::filter(const vector<uint32_t>& sorted, vector<uint32_t>& out) const {
+    out.clear();
+    
+    size_t current = 0;
+    for (uint32_t id : sorted) {
+        uint16_t key = (uint16_t)(id >> 16);
+        while (current < containers.size() && containers[current].key < key) {
+            current++;
+        }
+        if (current == containers.size()) break;
+        
+        if (containers[current].key == key && containerHas(containers[current], (uint16_t)(id & 0xFFFF))) {
+            out.push_back(id);
+        }
+    }
+}
+
+static inline uint32_t popcount(uint64_t bits) {
+#ifdef __GNUC__
+    return (uint32_t)__builtin_popcountll(bits);
+#else
+    uint32_t count = 0;
+    for (; bits != 0; bits &= bits - 1) count++;
+    return count;
+#endif
+}
+
+void RoaringBitmap::intersectContainers(Container& target, const Container& other) {
+    if (target.isBitset() && other.isBitset()) {
+        uint32_t count = 0;
+        for (uint32_t word = 0; word < BITSET_WORDS; word++) {
+            target.bits[word] &= other.bits[word];
+            count += popcount(target.bits[word]);
+        }
+        target.cardinality = count;
+        if (count <= ARRAY_LIMIT) {
+            toArray(target);
+        }
+        return;
+    }
+    
+    // At least one side is an array, so the result is one too
+    vector<uint16_t> kept;
+    if (target.isBitset()) {
+        for (uint16_t low : other.array) {
+            if (containerHas(target, low)) kept.push_back(low);
+        }
+        vector<uint64_t>().swap(target.bits);
+    } else if (other.isBitset()) {
+        for (uint16_t low : target.array) {
+            if (containerHas(other, low)) kept.push_back(low);
+        }
+    } else {
+        set_intersection(target.array.begin(), target.array.end(), other.array.begin(), other.array.end(),
+                         back_inserter(kept));
+    }
+    target.array.swap(kept);
+    target.cardinality = (uint32_t)target.array.size();
+}
+
+void RoaringBitmap::uniteContainers(Container& target, const Container& other) {
+    if (!target.isBitset() && !other.isBitset()) {
+        vector<uint16_t> merged;
+        merged.reserve(target.array.size() + other.array.size());
+        set_union(target.array.begin(), target.array.end(), other.array.begin(), other.array.end(),
+                  back_inserter(merged));
+        target.array.swap(merged);
+        target.cardinality = (uint32_t)target.array.size();
+        if (target.cardinality > ARRAY_LIMIT) {
+            toBitset(target);
+        }
+        return;
+    }
+    
+    if (!target.isBitset()) {
+        toBitset(target);
+    }
+    if (other.isBitset()) {
+        uint32_t count = 0;
+        for (uint32_t word = 0; word < BITSET_WORDS; word++) {
+            target.bits[word] |= other.bits[word];
+            count += popcount(target.bits[word]);
+        }
+        target.cardinality = count;
+    } else {
+        for (uint16_t low : other.array) {
+            uint64_t& word = target.bits[low >> 6];
+            uint64_t mask = (uint64_t)1 << (low & 63);
+            target.cardinality += (word & mask) ? 0 : 1;
+            word |= mask;
+        }
+    }
+}
+
+void RoaringBitmap::recount() {
+    cardinality = 0;
+    for (const Container& container : containers) {
+        cardinality += container.cardinality;
+    }
+}
+
+// Containers are matched by key in one merge-style pass; empty results are dropped
+void RoaringBitmap::intersectWith(const RoaringBitmap& other) {
+    vector<Container> kept;
+    size_t j = 0;
+    for (Container& container : containers) {
+        while (j < other.containers.size() && other.containers[j].key < container.key) j++;
+        if (j == other.containers.size()) break;
+        if (other.containers[j].key != container.key) continue;
+        
+        intersectContainers(container, other.containers[j]);
+        if (container.cardinality > 0) {
+            kept.push_back(Container());
+            swap(kept.back(), container);
+        }
+    }
+    containers.swap(kept);
+    recount();
+}
+
+void RoaringBitmap::uniteWith(const RoaringBitmap& other) {
+    vector<Container> merged;
+    merged.reserve(containers.size() + other.containers.size());
+    size_t i = 0, j = 0;
+    while (i < containers.size() || j < other.containers.size()) {
+        if (j == other.containers.size() || (i < containers.size() && containers[i].key < other.containers[j].key)) {
+            merged.push_back(Container());
+            swap(merged.back(), containers[i++]);
+        } else if (i == containers.size() || other.containers[j].key < containers[i].key) {
+            merged.push_back(other.containers[j++]);
+        } else {
+            uniteContainers(containers[i], other.containers[j++]);
+            merged.push_back(Container());
+            swap(merged.back(), containers[i++]);
+        }
+    }
+    containers.swap(merged);
+    recount();
+}
+
+void RoaringBitmap::clear() {
+    containers.clear();
+    cardinality = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef ROARING_BITMAP_H
+#define ROARING_BITMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+// Compressed set of 32-bit IDs in the style of Roaring bitmaps. IDs are
+// grouped by their high 16 bits into containers; a sparse container keeps a
+// sorted array of low halves, and one that grows past ARRAY_LIMIT entries
+// switches to a 65536-bit bitset. Membership tests are a binary search or a
+// single word lookup, so filtering a posting list costs O(list size).
+// Whole sets combine container by container; two bitsets are ANDed or ORed
+// 64 bits per step, with popcounts for the new cardinality.
+class RoaringBitmap {
+private:
+    static const uint32_t ARRAY_LIMIT = 4096;
+    static const uint32_t BITSET_WORDS = 65536 / 64;
+    
+    struct Container {
+        uint16_t key;
+        uint32_t cardinality;
+        vector<uint16_t> array;
+        vector<uint64_t> bits;
+        
+        bool isBitset() const { return !bits.empty(); }
+    };
+    
+    vector<Container> containers;
+    uint32_t cardinality;
+    
+    size_t findContainer(uint16_t key) const;
+    static bool containerHas(const Container& container, uint16_t low);
+    static void toBitset(Container& container);
+    static void toArray(Container& container);
+    static void intersectContainers(Container& target, const Container& other);
+    static void uniteContainers(Container& target, const Container& other);
+    void recount();
+
+public:
+    RoaringBitmap();
+    
+    // Return true when the set actually changed
+    bool add(uint32_t id);
+    bool remove(uint32_t id);
+    bool contains(uint32_t id) const;
+    
+    uint32_t getCardinality() const;
+    size_t getMemoryBytes() const;
+    
+    // All members in increasing order
+    void toVector(vector<uint32_t>& out) const;
+    // The members of a sorted ID list that are also in the set
+    void filter(const vector<uint32_t>& sorted, vector<uint32_t>& out) const;
+    
+    // In-place set algebra: this = this AND other, this = this OR other
+    void intersectWith(const RoaringBitmap& other);
+    void uniteWith(const RoaringBitmap& other);
+    
+    void clear();
+};
+
+#endif
@@ -1,159 +1,1383 @@
 #include "SearchEngine.h"
-#include <cctype>
+#include "FileHandler.h"
+#include <queue>
+#include <cmath>
+#include <chrono>
+#include <functional>
 #include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include "../Config.h"
 
-SearchEngine::SearchEngine() : bookTree(nullptr) {}
+SearchEngine::SearchEngine() 
+    : bookTree(nullptr), totalTitleLength(0), totalAuthorLength(0), segmentEpoch(0), nextSegmentID(1),
+      mergerRunning(false), mergeRequested(false), indexGeneration(0), availabilityGeneration(0),
+      queryCache(QUERY_CACHE_CAPACITY), typeAheadGeneration(0), vocabularyDirty(false) {
+    memorySegment.docBegin = 0;
+}
+
+SearchEngine::~SearchEngine() {
+    stopMerger();
+}
 
 void SearchEngine::setBookTree(BookBST* tree) {
     bookTree = tree;
 }
 
-string SearchEngine::normalize(string str) {
-    string result = "";
-    for (char c : str) {
-        result += tolower(c);
+// Lowercased whitespace-separated words of text
+vector<string> SearchEngine::tokenize(const string& text) {
+    size_t count = tokenizer.tokenize(text);
+    vector<string> tokens(count);
+    for (size_t i = 0; i < count; i++) {
+        tokenizer.tokenAt(i, tokens[i]);
+    }
+    return tokens;
+}
+
+// ============ INDEX MAINTENANCE ============
+
+uint32_t SearchEngine::getOrCreateTermID(const string& term) {
+    auto it = termIDs.find(term);
+    if (it != termIDs.end()) {
+        return it->second;
     }
     
-    while (!result.empty() && result[0] == ' ') {
-        result = result.substr(1);
+    uint32_t termID = (uint32_t)terms.size();
+    termIDs[term] = termID;
+    terms.push_back(term);
+    titleFrequency.push_back(0);
+    authorFrequency.push_back(0);
+    vocabularyDirty = true;
+    return termID;
+}
+
+// Appends one field's tokens and their positions to the in-memory segment
+// and records how often each term occurs
+uint32_t SearchEngine::indexField(const string& text, Field field, uint32_t docID, TermCounts& counts) {
+    vector<pair<uint32_t, uint32_t>>& occurrences = occurrenceScratch;
+    occurrences.clear();
+    size_t count = tokenizer.tokenize(text);
+    for (size_t i = 0; i < count; i++) {
+        tokenizer.tokenAt(i, termScratch);
+        occurrences.push_back(make_pair(getOrCreateTermID(termScratch), (uint32_t)i));
     }
-    while (!result.empty() && result[result.length() - 1] == ' ') {
-        result = result.substr(0, result.length() - 1);
+    
+    unordered_map<uint32_t, MemoryPostings>& postings = 
+        field == TITLE ? memorySegment.titlePostings : memorySegment.authorPostings;
+    vector<uint32_t>& frequency = field == TITLE ? titleFrequency : authorFrequency;
+    
+    // Sorting (term, position) pairs groups each term with its positions in order
+    sort(occurrences.begin(), occurrences.end());
+    for (size_t i = 0; i < occurrences.size(); ) {
+        uint32_t termID = occurrences[i].first;
+        positionScratch.clear();
+        size_t j = i;
+        while (j < occurrences.size() && occurrences[j].first == termID) {
+            positionScratch.push_back(occurrences[j++].second);
+        }
+        
+        MemoryPostings& entry = postings[termID];
+        entry.docs.push_back(docID);
+        IndexSegment::encodePositions(positionScratch, entry.positions);
+        frequency[termID]++;
+        counts.push_back(make_pair(termID, (uint16_t)min<size_t>(j - i, UINT16_MAX)));
+        i = j;
     }
     
-    return result;
+    return (uint32_t)occurrences.size();
 }
 
-vector<string> SearchEngine::tokenize(string str) {
-    vector<string> tokens;
-    stringstream ss(str);
-    string token;
+void SearchEngine::addBookToIndex(Book* book) {
+    uint32_t docID = (uint32_t)documents.size();
+    documents.push_back(book->getHandle());
+    indexGeneration++;
+    documentIDs[book->getISBN()] = docID;
+    
+    documentStats.push_back(DocumentStats());
+    DocumentStats& stats = documentStats.back();
+    stats.titleLength = indexField(book->getTitle(), TITLE, docID, stats.titleTerms);
+    stats.authorLength = indexField(book->getAuthor(), AUTHOR, docID, stats.authorTerms);
     
-    while (ss >> token) {
-        tokens.push_back(token);
+    totalTitleLength += stats.titleLength;
+    totalAuthorLength += stats.authorLength;
+    
+    if (book->getAvailability()) {
+        availableDocs.add(docID);
     }
+    facetIndex.add(docID, book);
+    book->setObserver(this);
     
-    return tokens;
+    if (documents.size() - memorySegment.docBegin >= (size_t)MUTABLE_SEGMENT_DOCS) {
+        sealMemorySegment();
+    }
 }
 
-void SearchEngine::buildIndices() {
-    if (bookTree == nullptr) return;
+// Removal is a tombstone; the postings disappear when the segment is next
+// merged, and the document ID once enough of them are dead to compact
+void SearchEngine::removeBookFromIndex(Book* book) {
+    auto it = documentIDs.find(book->getISBN());
+    if (it == documentIDs.end()) return;
+    
+    uint32_t docID = it->second;
+    documentIDs.erase(it);
+    documents[docID] = Handle();
+    availableDocs.remove(docID);
+    facetIndex.remove(docID);
+    book->setObserver(nullptr);
+    indexGeneration++;
+    
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        tombstones.add(docID);
+    }
+    
+    DocumentStats& stats = documentStats[docID];
+    for (const auto& entry : stats.titleTerms) {
+        titleFrequency[entry.first]--;
+    }
+    for (const auto& entry : stats.authorTerms) {
+        authorFrequency[entry.first]--;
+    }
     
-    titleIndex.clear();
-    authorIndex.clear();
+    totalTitleLength -= stats.titleLength;
+    totalAuthorLength -= stats.authorLength;
+    stats = DocumentStats();
     
-    vector<Book*> allBooks = bookTree->getAllBooksSorted();
-    for (Book* book : allBooks) {
-        addBookToIndex(book);
+    size_t deadDocuments = documents.size() - documentIDs.size();
+    if (deadDocuments * 100 >= documents.size() * INDEX_COMPACT_DEAD_PERCENT) {
+        compactDocuments();
     }
 }
 
-void SearchEngine::addBookToIndex(Book* book) {
-    string lowerTitle = normalize(book->getTitle());
-    string lowerAuthor = normalize(book->getAuthor());
+// Renumbers the live documents from 0 by indexing them again, which drops
+// every dead ID along with its postings, stats and bitmap bits
+void SearchEngine::compactDocuments() {
+    vector<Book*> liveBooks;
+    liveBooks.reserve(documentIDs.size());
+    for (uint32_t docID = 0; docID < documents.size(); docID++) {
+        Book* book = documentBook(docID);
+        if (book != nullptr) {
+            liveBooks.push_back(book);
+        }
+    }
+    indexBooks(liveBooks, 0);
+}
+
+// ============ SEGMENTS ============
+
+// Freezes the in-memory postings into an immutable segment at the end of the list
+void SearchEngine::sealMemorySegment() {
+    uint32_t docEnd = (uint32_t)documents.size();
+    if (docEnd == memorySegment.docBegin) return;
+    
+    vector<uint32_t> termList;
+    for (const auto& entry : memorySegment.titlePostings) {
+        termList.push_back(entry.first);
+    }
+    for (const auto& entry : memorySegment.authorPostings) {
+        if (memorySegment.titlePostings.find(entry.first) == memorySegment.titlePostings.end()) {
+            termList.push_back(entry.first);
+        }
+    }
+    sort(termList.begin(), termList.end());
     
-    titleIndex.insert({lowerTitle, book});
-    vector<string> titleWords = tokenize(lowerTitle);
-    for (const string& word : titleWords) {
-        titleIndex.insert({word, book});
+    vector<IndexSegment::TermPostings> postings(termList.size());
+    for (size_t i = 0; i < termList.size(); i++) {
+        auto title = memorySegment.titlePostings.find(termList[i]);
+        auto author = memorySegment.authorPostings.find(termList[i]);
+        bool inTitle = title != memorySegment.titlePostings.end();
+        bool inAuthor = author != memorySegment.authorPostings.end();
+        postings[i].termID = termList[i];
+        postings[i].title = inTitle ? &title->second.docs : nullptr;
+        postings[i].author = inAuthor ? &author->second.docs : nullptr;
+        postings[i].titlePositions = inTitle ? &title->second.positions : nullptr;
+        postings[i].authorPositions = inAuthor ? &author->second.positions : nullptr;
     }
     
-    authorIndex.insert({lowerAuthor, book});
-    vector<string> authorWords = tokenize(lowerAuthor);
-    for (const string& word : authorWords) {
-        authorIndex.insert({word, book});
+    shared_ptr<IndexSegment> sealed(IndexSegment::build(memorySegment.docBegin, docEnd, postings));
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        sealed->setSegmentID(nextSegmentID++);
+        segments.push_back(sealed);
+        memorySegment.titlePostings.clear();
+        memorySegment.authorPostings.clear();
+        memorySegment.docBegin = docEnd;
     }
+    
+    requestMerge();
 }
 
-void SearchEngine::removeBookFromIndex(Book* book) {
-    string lowerTitle = normalize(book->getTitle());
-    string lowerAuthor = normalize(book->getAuthor());
+// Tiered policy: a segment's tier is how many times MERGE_FACTOR fits into
+// its size relative to a freshly sealed one; the first run of MERGE_FACTOR
+// adjacent segments in the same tier is merged. Caller holds segmentMutex.
+bool SearchEngine::findMergeRun(size_t& first, size_t& count) const {
+    vector<int> tiers;
+    for (const shared_ptr<IndexSegment>& segment : segments) {
+        uint64_t size = segment->getDocEnd() - segment->getDocBegin();
+        uint64_t limit = (uint64_t)MUTABLE_SEGMENT_DOCS * SEGMENT_MERGE_FACTOR;
+        int tier = 0;
+        while (size >= limit) {
+            tier++;
+            limit *= SEGMENT_MERGE_FACTOR;
+        }
+        tiers.push_back(tier);
+    }
     
-    auto titleRange = titleIndex.equal_range(lowerTitle);
-    for (auto it = titleRange.first; it != titleRange.second; ) {
-        if (it->second->getISBN() == book->getISBN()) {
-            it = titleIndex.erase(it);
-        } else {
-            ++it;
+    for (size_t i = 0; i + SEGMENT_MERGE_FACTOR <= tiers.size(); i++) {
+        size_t j = i + 1;
+        while (j < tiers.size() && tiers[j] == tiers[i] && j - i < (size_t)SEGMENT_MERGE_FACTOR) j++;
+        if (j - i == (size_t)SEGMENT_MERGE_FACTOR) {
+            first = i;
+            count = j - i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Merges one run outside the lock, then swaps it in if the segment list has
+// not been rebuilt meanwhile. Tombstones the merge applied are retired.
+bool SearchEngine::mergeOnce() {
+    vector<shared_ptr<IndexSegment>> inputs;
+    RoaringBitmap deleted;
+    uint64_t epoch;
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        size_t first, count;
+        if (!findMergeRun(first, count)) return false;
+        
+        inputs.assign(segments.begin() + first, segments.begin() + first + count);
+        deleted = tombstones;
+        epoch = segmentEpoch;
+    }
+    
+    vector<const IndexSegment*> views;
+    for (const shared_ptr<IndexSegment>& input : inputs) {
+        views.push_back(input.get());
+    }
+    shared_ptr<IndexSegment> merged(IndexSegment::merge(views, deleted));
+    
+    lock_guard<mutex> lock(segmentMutex);
+    auto pos = find(segments.begin(), segments.end(), inputs.front());
+    if (epoch != segmentEpoch || pos == segments.end() || 
+        (size_t)(segments.end() - pos) < inputs.size() || !equal(inputs.begin(), inputs.end(), pos)) {
+        return true;
+    }
+    
+    merged->setSegmentID(nextSegmentID++);
+    pos = segments.erase(pos, pos + inputs.size());
+    segments.insert(pos, merged);
+    
+    vector<uint32_t> purged;
+    deleted.toVector(purged);
+    for (uint32_t docID : purged) {
+        if (docID >= merged->getDocBegin() && docID < merged->getDocEnd()) {
+            tombstones.remove(docID);
+        }
+    }
+    return true;
+}
+
+void SearchEngine::mergeLoop() {
+    while (true) {
+        {
+            unique_lock<mutex> lock(segmentMutex);
+            mergeCondition.wait(lock, [this]() { return mergeRequested || !mergerRunning.load(); });
+            if (!mergerRunning.load()) return;
+            mergeRequested = false;
+        }
+        
+        while (mergerRunning.load() && mergeOnce()) {
+        }
+    }
+}
+
+// With no merge thread running, merges happen inline on the writer's thread
+void SearchEngine::requestMerge() {
+    if (!mergerRunning.load()) {
+        while (mergeOnce()) {
+        }
+        return;
+    }
+    
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        mergeRequested = true;
+    }
+    mergeCondition.notify_one();
+}
+
+void SearchEngine::startMerger() {
+    if (mergerRunning.load()) return;
+    
+    mergerRunning.store(true);
+    mergeThread = thread(&SearchEngine::mergeLoop, this);
+}
+
+void SearchEngine::stopMerger() {
+    if (!mergerRunning.load()) return;
+    
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        mergerRunning.store(false);
+    }
+    mergeCondition.notify_one();
+    mergeThread.join();
+}
+
+void SearchEngine::waitForMerges() {
+    while (mergeOnce()) {
+    }
+}
+
+int SearchEngine::getSegmentCount() const {
+    lock_guard<mutex> lock(segmentMutex);
+    return (int)segments.size();
+}
+
+int SearchEngine::getMappedSegmentCount() const {
+    lock_guard<mutex> lock(segmentMutex);
+    int mapped = 0;
+    for (const shared_ptr<IndexSegment>& segment : segments) {
+        if (segment->isMapped()) mapped++;
+    }
+    return mapped;
+}
+
+// Bytes held by document IDs and by encoded positions, across all segments
+void SearchEngine::getIndexFootprint(size_t& postingBytes, size_t& positionBytes) const {
+    lock_guard<mutex> lock(segmentMutex);
+    postingBytes = 0;
+    positionBytes = 0;
+    for (const shared_ptr<IndexSegment>& segment : segments) {
+        postingBytes += segment->getPostingCount() * sizeof(uint32_t);
+        positionBytes += segment->getPositionBytes();
+    }
+    for (const auto* recent : {&memorySegment.titlePostings, &memorySegment.authorPostings}) {
+        for (const auto& entry : *recent) {
+            postingBytes += entry.second.docs.size() * sizeof(uint32_t);
+            positionBytes += entry.second.positions.size();
+        }
+    }
+}
+
+size_t SearchEngine::getTombstoneCount() const {
+    lock_guard<mutex> lock(segmentMutex);
+    return tombstones.getCardinality();
+}
+
+// ============ PARALLEL BUILD ============
+
+static void runParallel(int threadCount, const function<void(int)>& task) {
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; t++) {
+        workers.push_back(thread(task, t));
+    }
+    task(0);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Tokenizes books [begin, end) into a thread-local dictionary and postings.
+// Document IDs are the global ones, so each slice covers a contiguous range.
+void SearchEngine::indexSlice(const vector<Book*>& books, size_t begin, size_t end, PartialIndex& part) {
+    Tokenizer localTokenizer;
+    string word;
+    vector<pair<uint32_t, uint32_t>> occurrences;
+    vector<uint32_t> positions;
+    
+    for (size_t docID = begin; docID < end; docID++) {
+        Book* book = books[docID];
+        part.stats.push_back(DocumentStats());
+        DocumentStats& stats = part.stats.back();
+        
+        for (int field = 0; field < 2; field++) {
+            size_t count = localTokenizer.tokenize(field == 0 ? book->getTitle() : book->getAuthor());
+            occurrences.clear();
+            for (size_t i = 0; i < count; i++) {
+                localTokenizer.tokenAt(i, word);
+                auto found = part.termIDs.find(word);
+                if (found == part.termIDs.end()) {
+                    found = part.termIDs.insert(make_pair(word, (uint32_t)part.terms.size())).first;
+                    part.terms.push_back(word);
+                    part.titlePostings.push_back(PostingList());
+                    part.authorPostings.push_back(PostingList());
+                    part.titlePositions.push_back(vector<uint8_t>());
+                    part.authorPositions.push_back(vector<uint8_t>());
+                }
+                occurrences.push_back(make_pair(found->second, (uint32_t)i));
+            }
+            
+            vector<PostingList>& postings = field == 0 ? part.titlePostings : part.authorPostings;
+            vector<vector<uint8_t>>& runs = field == 0 ? part.titlePositions : part.authorPositions;
+            TermCounts& counts = field == 0 ? stats.titleTerms : stats.authorTerms;
+            sort(occurrences.begin(), occurrences.end());
+            for (size_t i = 0; i < occurrences.size(); ) {
+                uint32_t termID = occurrences[i].first;
+                positions.clear();
+                size_t j = i;
+                while (j < occurrences.size() && occurrences[j].first == termID) {
+                    positions.push_back(occurrences[j++].second);
+                }
+                
+                postings[termID].push_back((uint32_t)docID);
+                IndexSegment::encodePositions(positions, runs[termID]);
+                counts.push_back(make_pair(termID, (uint16_t)min<size_t>(j - i, UINT16_MAX)));
+                i = j;
+            }
+            (field == 0 ? stats.titleLength : stats.authorLength) = (uint32_t)count;
+        }
+        
+        book->setObserver(this);
+    }
+}
+
+
+// Folds the partial indexes into a single sealed segment. Term IDs are
+// assigned in slice order, which reproduces the IDs a sequential build
+// would give. Slices own ascending, disjoint document ranges, so the k-way
+// merge of a term's partial posting lists is their concatenation in slice
+// order; it runs in parallel over disjoint ranges of term IDs.
+void SearchEngine::mergePartials(vector<PartialIndex>& parts, int threadCount, uint32_t docCount) {
+    for (PartialIndex& part : parts) {
+        part.globalIDs.resize(part.terms.size());
+        for (size_t local = 0; local < part.terms.size(); local++) {
+            part.globalIDs[local] = getOrCreateTermID(part.terms[local]);
+        }
+    }
+    
+    uint32_t termCount = (uint32_t)terms.size();
+    vector<PostingList> titlePostings(termCount), authorPostings(termCount);
+    vector<vector<uint8_t>> titlePositions(termCount), authorPositions(termCount);
+    
+    runParallel(threadCount, [&](int t) {
+        uint32_t from = (uint32_t)((uint64_t)termCount * t / threadCount);
+        uint32_t to = (uint32_t)((uint64_t)termCount * (t + 1) / threadCount);
+        
+        for (PartialIndex& part : parts) {
+            for (size_t local = 0; local < part.terms.size(); local++) {
+                uint32_t global = part.globalIDs[local];
+                if (global < from || global >= to) continue;
+                
+                PostingList& title = titlePostings[global];
+                title.insert(title.end(), part.titlePostings[local].begin(), part.titlePostings[local].end());
+                PostingList& author = authorPostings[global];
+                author.insert(author.end(), part.authorPostings[local].begin(), part.authorPostings[local].end());
+                
+                // Runs are self-delimiting, so they concatenate like the postings
+                vector<uint8_t>& titleRuns = titlePositions[global];
+                titleRuns.insert(titleRuns.end(), part.titlePositions[local].begin(), part.titlePositions[local].end());
+                vector<uint8_t>& authorRuns = authorPositions[global];
+                authorRuns.insert(authorRuns.end(), part.authorPositions[local].begin(), part.authorPositions[local].end());
+            }
+        }
+        
+        // Each slice's stats are renumbered by the thread with the same index
+        for (size_t p = t; p < parts.size(); p += threadCount) {
+            const vector<uint32_t>& globalIDs = parts[p].globalIDs;
+            for (DocumentStats& stats : parts[p].stats) {
+                for (TermCounts* counts : {&stats.titleTerms, &stats.authorTerms}) {
+                    for (auto& entry : *counts) {
+                        entry.first = globalIDs[entry.first];
+                    }
+                    sort(counts->begin(), counts->end());
+                }
+            }
+        }
+    });
+    
+    vector<IndexSegment::TermPostings> postings;
+    for (uint32_t termID = 0; termID < termCount; termID++) {
+        titleFrequency[termID] = (uint32_t)titlePostings[termID].size();
+        authorFrequency[termID] = (uint32_t)authorPostings[termID].size();
+        if (titlePostings[termID].empty() && authorPostings[termID].empty()) continue;
+        
+        IndexSegment::TermPostings entry = { termID, &titlePostings[termID], &authorPostings[termID],
+                                             &titlePositions[termID], &authorPositions[termID] };
+        postings.push_back(entry);
+    }
+    
+    shared_ptr<IndexSegment> segment(IndexSegment::build(0, docCount, postings));
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        segment->setSegmentID(nextSegmentID++);
+        segments.push_back(segment);
+        memorySegment.docBegin = docCount;
+    }
+    
+    for (PartialIndex& part : parts) {
+        for (DocumentStats& stats : part.stats) {
+            totalTitleLength += stats.titleLength;
+            totalAuthorLength += stats.authorLength;
+            documentStats.push_back(DocumentStats());
+            documentStats.back().titleTerms.swap(stats.titleTerms);
+            documentStats.back().authorTerms.swap(stats.authorTerms);
+            documentStats.back().titleLength = stats.titleLength;
+            documentStats.back().authorLength = stats.authorLength;
         }
     }
+}
+
+void SearchEngine::buildIndices(int threadCount) {
+    if (bookTree == nullptr) return;
+    
+    indexBooks(bookTree->getAllBooksSorted(), threadCount);
+}
+
+void SearchEngine::indexBooks(const vector<Book*>& allBooks, int threadCount) {
+    clear();
+    
+    if (threadCount <= 0) {
+        threadCount = max(1, (int)thread::hardware_concurrency());
+    }
+    threadCount = max(1, min(threadCount, (int)(allBooks.size() / INDEX_BUILD_MIN_SLICE)));
+    
+    if (threadCount == 1) {
+        documents.reserve(allBooks.size());
+        documentStats.reserve(allBooks.size());
+        for (Book* book : allBooks) {
+            addBookToIndex(book);
+        }
+        return;
+    }
+    
+    vector<PartialIndex> parts(threadCount);
+    runParallel(threadCount, [&](int t) {
+        size_t begin = allBooks.size() * t / threadCount;
+        size_t end = allBooks.size() * (t + 1) / threadCount;
+        indexSlice(allBooks, begin, end, parts[t]);
+    });
+    
+    documentStats.reserve(allBooks.size());
+    mergePartials(parts, threadCount, (uint32_t)allBooks.size());
+    
+    documents.reserve(allBooks.size());
+    documentIDs.reserve(allBooks.size());
+    for (uint32_t docID = 0; docID < allBooks.size(); docID++) {
+        documents.push_back(allBooks[docID]->getHandle());
+        documentIDs[allBooks[docID]->getISBN()] = docID;
+        if (allBooks[docID]->getAvailability()) {
+            availableDocs.add(docID);
+        }
+        facetIndex.add(docID, allBooks[docID]);
+    }
+    indexGeneration++;
+}
+
+// ============ POSTING LIST ALGEBRA ============
+
+// First index >= from whose value is >= target: exponential probe, then binary search
+size_t SearchEngine::gallop(const PostingList& list, size_t from, uint32_t target) {
+    size_t step = 1;
+    size_t low = from;
+    size_t high = from;
+    
+    while (high < list.size() && list[high] < target) {
+        low = high + 1;
+        high = from + step;
+        step <<= 1;
+    }
+    if (high > list.size()) {
+        high = list.size();
+    }
+    
+    return lower_bound(list.begin() + low, list.begin() + high, target) - list.begin();
+}
+
+void SearchEngine::intersect(const PostingList& a, const PostingList& b, PostingList& out) {
+    out.clear();
+    const PostingList& small = a.size() <= b.size() ? a : b;
+    const PostingList& large = a.size() <= b.size() ? b : a;
     
-    vector<string> titleWords = tokenize(lowerTitle);
-    for (const string& word : titleWords) {
-        auto wordRange = titleIndex.equal_range(word);
-        for (auto it = wordRange.first; it != wordRange.second; ) {
-            if (it->second->getISBN() == book->getISBN()) {
-                it = titleIndex.erase(it);
-            } else {
-                ++it;
+    if (small.empty()) return;
+    
+    // Skewed sizes: gallop through the long list instead of scanning it
+    if (large.size() / small.size() >= 8) {
+        size_t pos = 0;
+        for (uint32_t docID : small) {
+            pos = gallop(large, pos, docID);
+            if (pos == large.size()) break;
+            if (large[pos] == docID) {
+                out.push_back(docID);
             }
         }
+        return;
     }
     
-    auto authorRange = authorIndex.equal_range(lowerAuthor);
-    for (auto it = authorRange.first; it != authorRange.second; ) {
-        if (it->second->getISBN() == book->getISBN()) {
-            it = authorIndex.erase(it);
+    size_t i = 0, j = 0;
+    while (i < small.size() && j < large.size()) {
+        if (small[i] < large[j]) {
+            i++;
+        } else if (small[i] > large[j]) {
+            j++;
         } else {
-            ++it;
+            out.push_back(small[i]);
+            i++;
+            j++;
         }
     }
+}
+
+void SearchEngine::unite(const PostingList& a, const PostingList& b, PostingList& out) {
+    out.clear();
+    out.reserve(a.size() + b.size());
+    set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(out));
+}
+
+// ============ QUERY EVALUATION ============
+
+static void addDistinct(vector<string>& terms, const vector<string>& words) {
+    for (const string& word : words) {
+        if (find(terms.begin(), terms.end(), word) == terms.end()) {
+            terms.push_back(word);
+        }
+    }
+}
+
+// Splits a query into distinct normalized terms. An upper-case OR between
+// words switches the query from all-terms to any-term matching. Text in
+// double quotes is a phrase: when phrases is given, multi-word phrases are
+// returned there instead of among the terms.
+vector<string> SearchEngine::parseQuery(string query, MatchMode& mode, vector<Phrase>* phrases) {
+    mode = MATCH_ALL;
+    vector<string> queryTerms;
+    vector<Phrase> quoted;
     
-    vector<string> authorWords = tokenize(lowerAuthor);
-    for (const string& word : authorWords) {
-        auto wordRange = authorIndex.equal_range(word);
-        for (auto it = wordRange.first; it != wordRange.second; ) {
-            if (it->second->getISBN() == book->getISBN()) {
-                it = authorIndex.erase(it);
-            } else {
-                ++it;
+    // Blank out each quoted span so only loose words remain; an unclosed quote runs to the end
+    size_t open = query.find('"');
+    while (open != string::npos) {
+        size_t close = query.find('"', open + 1);
+        size_t end = close == string::npos ? query.size() : close + 1;
+        Phrase phrase = tokenize(query.substr(open + 1, end - open - 1 - (close != string::npos)));
+        if (!phrase.empty()) {
+            quoted.push_back(phrase);
+        }
+        query.replace(open, end - open, end - open, ' ');
+        open = query.find('"', end);
+    }
+    
+    size_t count = tokenizer.tokenize(query);
+    for (size_t i = 0; i < count; i++) {
+        // Operators are recognised on the original, case-sensitive text
+        size_t offset = tokenizer.tokenOffset(i);
+        size_t length = tokenizer.tokenSourceLength(i);
+        if (query.compare(offset, length, "OR") == 0) {
+            mode = MATCH_ANY;
+            continue;
+        }
+        if (query.compare(offset, length, "AND") == 0) {
+            continue;
+        }
+        
+        tokenizer.tokenAt(i, termScratch);
+        if (find(queryTerms.begin(), queryTerms.end(), termScratch) == queryTerms.end()) {
+            queryTerms.push_back(termScratch);
+        }
+    }
+    
+    for (const Phrase& phrase : quoted) {
+        if (phrases != nullptr && phrase.size() > 1) {
+            phrases->push_back(phrase);
+        } else {
+            addDistinct(queryTerms, phrase);
+        }
+    }
+    return queryTerms;
+}
+
+// Gathers a term's postings from every segment. Segments cover ascending,
+// disjoint document ranges, so appending them in order keeps the list
+// sorted; tombstoned documents are dropped on the way out.
+SearchEngine::PostingList SearchEngine::termPostings(Field field, const string& term) const {
+    PostingList result;
+    auto it = termIDs.find(term);
+    if (it == termIDs.end()) return result;
+    uint32_t termID = it->second;
+    
+    lock_guard<mutex> lock(segmentMutex);
+    PostingList title, author, merged;
+    
+    for (const shared_ptr<IndexSegment>& segment : segments) {
+        if (field == TITLE) {
+            segment->appendPostings(termID, IndexSegment::TITLE_FIELD, result);
+        } else if (field == AUTHOR) {
+            segment->appendPostings(termID, IndexSegment::AUTHOR_FIELD, result);
+        } else {
+            title.clear();
+            author.clear();
+            segment->appendPostings(termID, IndexSegment::TITLE_FIELD, title);
+            segment->appendPostings(termID, IndexSegment::AUTHOR_FIELD, author);
+            unite(title, author, merged);
+            result.insert(result.end(), merged.begin(), merged.end());
+        }
+    }
+    
+    auto memoryTitle = memorySegment.titlePostings.find(termID);
+    auto memoryAuthor = memorySegment.authorPostings.find(termID);
+    const PostingList empty;
+    const PostingList& recentTitle = memoryTitle != memorySegment.titlePostings.end() ? memoryTitle->second.docs : empty;
+    const PostingList& recentAuthor = memoryAuthor != memorySegment.authorPostings.end() ? memoryAuthor->second.docs : empty;
+    
+    if (field == TITLE) {
+        result.insert(result.end(), recentTitle.begin(), recentTitle.end());
+    } else if (field == AUTHOR) {
+        result.insert(result.end(), recentAuthor.begin(), recentAuthor.end());
+    } else {
+        unite(recentTitle, recentAuthor, merged);
+        result.insert(result.end(), merged.begin(), merged.end());
+    }
+    
+    if (tombstones.getCardinality() > 0) {
+        const RoaringBitmap& deleted = tombstones;
+        result.erase(remove_if(result.begin(), result.end(), [&deleted](uint32_t docID) {
+            return deleted.contains(docID);
+        }), result.end());
+    }
+    return result;
+}
+
+// Positions of the term in field for those wanted documents that contain it,
+// gathered segment by segment in document order
+void SearchEngine::termPositions(Field field, uint32_t termID, const PostingList& wanted,
+                                 IndexSegment::PositionLists& out) const {
+    IndexSegment::Field segmentField = field == TITLE ? IndexSegment::TITLE_FIELD : IndexSegment::AUTHOR_FIELD;
+    const unordered_map<uint32_t, MemoryPostings>& recent = 
+        field == TITLE ? memorySegment.titlePostings : memorySegment.authorPostings;
+    
+    lock_guard<mutex> lock(segmentMutex);
+    for (const shared_ptr<IndexSegment>& segment : segments) {
+        segment->appendPositions(termID, segmentField, wanted, out);
+    }
+    
+    auto it = recent.find(termID);
+    if (it != recent.end()) {
+        IndexSegment::collectPositions(it->second.docs.data(), it->second.docs.size(),
+                                       it->second.positions.data(), wanted, out);
+    }
+}
+
+SearchEngine::PostingList SearchEngine::evaluate(Field field, const vector<string>& queryTerms, MatchMode mode) const {
+    PostingList result;
+    if (queryTerms.empty()) return result;
+    
+    vector<PostingList> lists;
+    for (const string& term : queryTerms) {
+        lists.push_back(termPostings(field, term));
+    }
+    
+    PostingList scratch;
+    
+    if (mode == MATCH_ANY) {
+        for (const PostingList& list : lists) {
+            unite(result, list, scratch);
+            result.swap(scratch);
+        }
+        return result;
+    }
+    
+    // Intersect shortest lists first so the running result only shrinks
+    sort(lists.begin(), lists.end(), [](const PostingList& a, const PostingList& b) {
+        return a.size() < b.size();
+    });
+    
+    result = lists[0];
+    for (size_t i = 1; i < lists.size() && !result.empty(); i++) {
+        intersect(result, lists[i], scratch);
+        result.swap(scratch);
+    }
+    
+    return result;
+}
+
+// Loose words combine as usual. Under AND every phrase must match as well;
+// under OR each phrase is one more alternative.
+SearchEngine::PostingList SearchEngine::evaluatePhrases(Field field, const vector<string>& words,
+                                                        const vector<Phrase>& phrases, MatchMode mode) const {
+    if (mode == MATCH_ALL) {
+        vector<string> allWords = words;
+        for (const Phrase& phrase : phrases) {
+            addDistinct(allWords, phrase);
+        }
+        
+        PostingList result = evaluate(field, allWords, MATCH_ALL);
+        for (size_t i = 0; i < phrases.size() && !result.empty(); i++) {
+            result = matchPhrase(field, phrases[i], result);
+        }
+        return result;
+    }
+    
+    PostingList result = evaluate(field, words, MATCH_ANY);
+    PostingList scratch;
+    for (const Phrase& phrase : phrases) {
+        unite(result, matchPhrase(field, phrase, evaluate(field, phrase, MATCH_ALL)), scratch);
+        result.swap(scratch);
+    }
+    return result;
+}
+
+// Positional intersection: keeps the candidates where word i of the phrase
+// sits i tokens after the first word, within a single field
+SearchEngine::PostingList SearchEngine::matchPhrase(Field field, const Phrase& phrase, 
+                                                    const PostingList& candidates) const {
+    PostingList result;
+    if (field == ANY_FIELD) {
+        unite(matchPhrase(TITLE, phrase, candidates), matchPhrase(AUTHOR, phrase, candidates), result);
+        return result;
+    }
+    
+    vector<IndexSegment::PositionLists> lists(phrase.size());
+    for (size_t i = 0; i < phrase.size(); i++) {
+        auto it = termIDs.find(phrase[i]);
+        if (it == termIDs.end()) return result;
+        
+        termPositions(field, it->second, candidates, lists[i]);
+        if (lists[i].docs.empty()) return result;
+    }
+    
+    auto range = [](const IndexSegment::PositionLists& list, size_t slot) {
+        size_t end = slot + 1 < list.starts.size() ? list.starts[slot + 1] : list.positions.size();
+        return make_pair(list.positions.begin() + list.starts[slot], list.positions.begin() + end);
+    };
+    
+    vector<size_t> cursors(phrase.size(), 0);
+    vector<uint32_t> starts, survivors;
+    for (size_t first = 0; first < lists[0].docs.size(); first++) {
+        uint32_t docID = lists[0].docs[first];
+        bool present = true;
+        for (size_t i = 1; i < phrase.size() && present; i++) {
+            const vector<uint32_t>& docs = lists[i].docs;
+            while (cursors[i] < docs.size() && docs[cursors[i]] < docID) cursors[i]++;
+            present = cursors[i] < docs.size() && docs[cursors[i]] == docID;
+        }
+        if (!present) continue;
+        
+        auto firstRange = range(lists[0], first);
+        starts.assign(firstRange.first, firstRange.second);
+        for (size_t i = 1; i < phrase.size() && !starts.empty(); i++) {
+            auto words = range(lists[i], cursors[i]);
+            survivors.clear();
+            for (uint32_t start : starts) {
+                while (words.first != words.second && *words.first < start + i) ++words.first;
+                if (words.first == words.second) break;
+                if (*words.first == start + i) {
+                    survivors.push_back(start);
+                }
             }
+            starts.swap(survivors);
+        }
+        
+        if (!starts.empty()) {
+            result.push_back(docID);
         }
     }
+    return result;
+}
+
+Book* SearchEngine::documentBook(uint32_t docID) const {
+    return bookTree != nullptr ? bookTree->resolve(documents[docID]) : nullptr;
 }
 
-vector<Book*> SearchEngine::searchByTitle(string title) {
-    string normalized = normalize(title);
+vector<Book*> SearchEngine::toBooks(const PostingList& docs) const {
     vector<Book*> results;
+    results.reserve(docs.size());
     
-    auto range = titleIndex.equal_range(normalized);
-    for (auto it = range.first; it != range.second; ++it) {
-        results.push_back(it->second);
+    for (uint32_t docID : docs) {
+        Book* book = documentBook(docID);
+        if (book != nullptr) {
+            results.push_back(book);
+        }
+    }
+    
+    return results;
+}
+
+// ============ RANKING ============
+
+uint16_t SearchEngine::termFrequency(const TermCounts& counts, uint32_t termID) {
+    auto pos = lower_bound(counts.begin(), counts.end(), make_pair(termID, (uint16_t)0));
+    return (pos != counts.end() && pos->first == termID) ? pos->second : 0;
+}
+
+// BM25 contribution of one term in one field of one document
+double SearchEngine::fieldScore(uint32_t df, const TermCounts& counts, uint32_t termID,
+                                uint32_t fieldLength, double averageLength) const {
+    uint16_t tf = termFrequency(counts, termID);
+    if (tf == 0) return 0.0;
+    
+    double n = (double)documentIDs.size();
+    double idf = log(1.0 + (n - df + 0.5) / (df + 0.5));
+    double norm = averageLength > 0 ? fieldLength / averageLength : 1.0;
+    
+    return idf * (tf * (BM25_K1 + 1.0)) / (tf + BM25_K1 * (1.0 - BM25_B + BM25_B * norm));
+}
+
+// Scores every candidate and keeps the best k in a min-heap, so only the
+// winners are ever sorted. Ties go to the earlier document ID.
+SearchEngine::PostingList SearchEngine::rankTopK(Field field, const vector<string>& queryTerms, const PostingList& candidates,
+                                                size_t k, bool availableOnly) const {
+    vector<uint32_t> queryIDs;
+    for (const string& term : queryTerms) {
+        auto it = termIDs.find(term);
+        if (it != termIDs.end()) {
+            queryIDs.push_back(it->second);
+        }
+    }
+    
+    double live = documentIDs.empty() ? 1.0 : (double)documentIDs.size();
+    double averageTitle = totalTitleLength / live;
+    double averageAuthor = totalAuthorLength / live;
+    
+    typedef pair<double, uint32_t> Scored;
+    auto better = [](const Scored& a, const Scored& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    priority_queue<Scored, vector<Scored>, decltype(better)> heap(better);
+    
+    PostingList available;
+    if (availableOnly) {
+        lock_guard<mutex> lock(availabilityMutex);
+        availableDocs.filter(candidates, available);
+    }
+    
+    for (uint32_t docID : availableOnly ? available : candidates) {
+        if (documents[docID].isNull()) continue;
+        
+        const DocumentStats& stats = documentStats[docID];
+        double score = 0.0;
+        for (uint32_t termID : queryIDs) {
+            if (field != AUTHOR) {
+                score += TITLE_BOOST * fieldScore(titleFrequency[termID], stats.titleTerms, termID,
+                                                  stats.titleLength, averageTitle);
+            }
+            if (field != TITLE) {
+                score += AUTHOR_BOOST * fieldScore(authorFrequency[termID], stats.authorTerms, termID,
+                                                   stats.authorLength, averageAuthor);
+            }
+        }
+        
+        Scored entry(score, docID);
+        if (heap.size() < k) {
+            heap.push(entry);
+        } else if (k > 0 && better(entry, heap.top())) {
+            heap.pop();
+            heap.push(entry);
+        }
+    }
+    
+    PostingList ranked(heap.size());
+    for (size_t i = heap.size(); i > 0; i--) {
+        ranked[i - 1] = heap.top().second;
+        heap.pop();
+    }
+    return ranked;
+}
+
+// Cache key: field, filter, match mode and the sorted distinct terms, so
+// "Harry  Potter" and "potter harry" share an entry
+vector<Book*> SearchEngine::cachedSearch(Field field, const string& query, bool availableOnly) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    unique_lock<mutex> lock(queryMutex);
+    
+    MatchMode mode;
+    vector<Phrase> phrases;
+    vector<string> queryTerms = parseQuery(query, mode, &phrases);
+    vector<string> sortedTerms = queryTerms;
+    sort(sortedTerms.begin(), sortedTerms.end());
+    
+    string key;
+    key += (char)('0' + field);
+    key += availableOnly ? 'A' : '-';
+    key += mode == MATCH_ANY ? '|' : '&';
+    for (const string& term : sortedTerms) {
+        key += ' ';
+        key += term;
+    }
+    for (const Phrase& phrase : phrases) {
+        key += " \"";
+        for (size_t i = 0; i < phrase.size(); i++) {
+            key += i > 0 ? " " : "";
+            key += phrase[i];
+        }
+        key += '"';
     }
     
-    sort(results.begin(), results.end());
-    results.erase(unique(results.begin(), results.end()), results.end());
+    uint64_t availability = availableOnly ? availabilityGeneration.load() : 0;
+    PostingList docs;
+    bool hit = queryCache.lookup(key, indexGeneration, availability, docs);
+    if (!hit) {
+        lock.unlock();
+        vector<string> rankingTerms = queryTerms;
+        for (const Phrase& phrase : phrases) {
+            addDistinct(rankingTerms, phrase);
+        }
+        docs = rankTopK(field, rankingTerms, evaluatePhrases(field, queryTerms, phrases, mode),
+                        MAX_SEARCH_RESULTS, availableOnly);
+        lock.lock();
+        queryCache.store(key, indexGeneration, availability, docs);
+    }
     
+    queryCache.recordLatency(hit, chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    lock.unlock();
+    return toBooks(docs);
+}
+
+// ============ SEARCH ============
+
+vector<Book*> SearchEngine::searchByTitle(string title, bool availableOnly) {
+    return cachedSearch(TITLE, title, availableOnly);
+}
+
+vector<Book*> SearchEngine::searchByAuthor(string author, bool availableOnly) {
+    return cachedSearch(AUTHOR, author, availableOnly);
+}
+
+vector<Book*> SearchEngine::searchByKeyword(string keyword, bool availableOnly) {
+    return cachedSearch(ANY_FIELD, keyword, availableOnly);
+}
+
+// The author's facet bitmap already is the list of their books, so no
+// query is parsed and no posting lists are intersected
+vector<Book*> SearchEngine::searchByAuthorID(uint32_t authorID) {
+    PostingList docs;
+    facetIndex.authorDocuments(authorID, docs);
+    vector<Book*> books = toBooks(docs);
+    sort(books.begin(), books.end(), [](const Book* a, const Book* b) {
+        return a->getTitle() < b->getTitle();
+    });
+    return books;
+}
+
+size_t SearchEngine::countBooksByAuthor(uint32_t authorID) const {
+    return facetIndex.authorDocumentCount(authorID);
+}
+
+// ============ BATCH SEARCH ============
+
+// Duplicates are dropped before the lookup and filled back in afterwards
+vector<Book*> SearchEngine::searchByISBNs(const vector<string>& isbns) {
+    vector<Book*> results(isbns.size(), nullptr);
+    if (bookTree == nullptr) return results;
+    
+    vector<string> sorted = isbns;
+    sort(sorted.begin(), sorted.end());
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+    
+    vector<Book*> found;
+    bookTree->searchSorted(sorted, found);
+    for (size_t i = 0; i < isbns.size(); i++) {
+        size_t index = lower_bound(sorted.begin(), sorted.end(), isbns[i]) - sorted.begin();
+        results[i] = found[index];
+    }
     return results;
 }
 
-vector<Book*> SearchEngine::searchByAuthor(string author) {
-    string normalized = normalize(author);
-    vector<Book*> results;
+// Workers pull the next distinct query off a shared counter, so a few slow
+// queries do not hold up a whole slice of the batch
+vector<vector<Book*>> SearchEngine::searchBatch(Field field, const vector<string>& queries, bool availableOnly,
+                                                int threadCount) {
+    vector<string> distinct;
+    vector<size_t> slot(queries.size());
+    unordered_map<string, size_t> seen;
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto it = seen.find(queries[i]);
+        if (it == seen.end()) {
+            it = seen.insert(make_pair(queries[i], distinct.size())).first;
+            distinct.push_back(queries[i]);
+        }
+        slot[i] = it->second;
+    }
     
-    auto range = authorIndex.equal_range(normalized);
-    for (auto it = range.first; it != range.second; ++it) {
-        results.push_back(it->second);
+    if (threadCount <= 0) {
+        threadCount = max(1, (int)thread::hardware_concurrency());
     }
+    threadCount = max(1, min(threadCount, (int)(distinct.size() / BATCH_QUERIES_PER_THREAD)));
     
-    sort(results.begin(), results.end());
-    results.erase(unique(results.begin(), results.end()), results.end());
+    vector<vector<Book*>> answers(distinct.size());
+    atomic<size_t> next(0);
+    runParallel(threadCount, [&](int) {
+        for (size_t i = next++; i < distinct.size(); i = next++) {
+            answers[i] = cachedSearch(field, distinct[i], availableOnly);
+        }
+    });
     
+    vector<vector<Book*>> results(queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        results[i] = answers[slot[i]];
+    }
     return results;
 }
 
-vector<Book*> SearchEngine::searchByKeyword(string keyword) {
-    vector<Book*> titleResults = searchByTitle(keyword);
-    vector<Book*> authorResults = searchByAuthor(keyword);
+// ============ AUTOCOMPLETE ============
+
+size_t SearchEngine::documentFrequency(uint32_t termID) const {
+    return (size_t)titleFrequency[termID] + authorFrequency[termID];
+}
+
+size_t SearchEngine::fieldFrequency(Field field, uint32_t termID) const {
+    if (field == TITLE) return titleFrequency[termID];
+    if (field == AUTHOR) return authorFrequency[termID];
+    return documentFrequency(termID);
+}
+
+void SearchEngine::refreshVocabulary() {
+    if (!vocabularyDirty) return;
     
-    vector<Book*> combined;
-    combined.insert(combined.end(), titleResults.begin(), titleResults.end());
-    combined.insert(combined.end(), authorResults.begin(), authorResults.end());
+    prefixDictionary.build(terms);
+    trigramIndex.build(terms);
+    vocabularyDirty = false;
+}
+
+// The k most frequent live terms starting with prefix, best first
+vector<uint32_t> SearchEngine::topCompletions(const string& prefix, size_t k) {
+    refreshVocabulary();
     
-    sort(combined.begin(), combined.end());
-    combined.erase(unique(combined.begin(), combined.end()), combined.end());
+    vector<uint32_t> matches;
+    prefixDictionary.findPrefix(prefix, matches);
     
-    return combined;
+    // Bounded min-heap on document frequency keeps only the best k
+    typedef pair<size_t, uint32_t> Candidate;
+    priority_queue<Candidate, vector<Candidate>, greater<Candidate>> heap;
+    for (uint32_t termID : matches) {
+        size_t frequency = documentFrequency(termID);
+        if (frequency == 0) continue;
+        
+        if (heap.size() < k) {
+            heap.push(Candidate(frequency, termID));
+        } else if (frequency > heap.top().first) {
+            heap.pop();
+            heap.push(Candidate(frequency, termID));
+        }
+    }
+    
+    vector<uint32_t> best(heap.size());
+    for (size_t i = best.size(); i > 0; i--) {
+        best[i - 1] = heap.top().second;
+        heap.pop();
+    }
+    return best;
+}
+
+vector<string> SearchEngine::suggestCompletions(string prefix, int k) {
+    lock_guard<mutex> lock(queryMutex);
+    vector<string> suggestions;
+    vector<string> words = tokenize(prefix);
+    if (words.empty() || k <= 0) return suggestions;
+    
+    for (uint32_t termID : topCompletions(words.back(), k)) {
+        suggestions.push_back(terms[termID]);
+    }
+    return suggestions;
+}
+
+vector<Book*> SearchEngine::searchByPrefix(string query, int k) {
+    lock_guard<mutex> lock(queryMutex);
+    MatchMode mode;
+    vector<string> queryTerms = parseQuery(query, mode);
+    if (queryTerms.empty() || k <= 0) return vector<Book*>();
+    
+    string prefix = queryTerms.back();
+    queryTerms.pop_back();
+    
+    // Union the postings of the most frequent completions of the last word
+    PostingList expanded, scratch;
+    vector<string> rankingTerms = queryTerms;
+    for (uint32_t termID : topCompletions(prefix, PREFIX_EXPANSION_LIMIT)) {
+        unite(expanded, termPostings(ANY_FIELD, terms[termID]), scratch);
+        expanded.swap(scratch);
+        rankingTerms.push_back(terms[termID]);
+    }
+    
+    PostingList result = expanded;
+    if (!queryTerms.empty()) {
+        intersect(evaluate(ANY_FIELD, queryTerms, MATCH_ALL), expanded, result);
+    }
+    
+    return toBooks(rankTopK(ANY_FIELD, rankingTerms, result, k, false));
+}
+
+// ============ INCREMENTAL SEARCH ============
+
+// True when every document matching (words, prefix) also matches step: the
+// step's words come first, and its prefix starts the next word or the prefix
+bool SearchEngine::narrows(const TypeAheadStep& step, const vector<string>& words, const string& prefix) {
+    if (step.words.size() > words.size() || !equal(step.words.begin(), step.words.end(), words.begin())) {
+        return false;
+    }
+    
+    const string& next = step.words.size() < words.size() ? words[step.words.size()] : prefix;
+    return next.compare(0, step.prefix.size(), step.prefix) == 0;
+}
+
+bool SearchEngine::matchesTypeAhead(uint32_t docID, const vector<uint32_t>& wordIDs, const string& prefix) const {
+    const DocumentStats& stats = documentStats[docID];
+    for (uint32_t termID : wordIDs) {
+        if (termFrequency(stats.titleTerms, termID) == 0 && termFrequency(stats.authorTerms, termID) == 0) {
+            return false;
+        }
+    }
+    if (prefix.empty()) return true;
+    
+    for (const TermCounts* counts : {&stats.titleTerms, &stats.authorTerms}) {
+        for (const pair<uint32_t, uint16_t>& entry : *counts) {
+            if (terms[entry.first].compare(0, prefix.size(), prefix) == 0) return true;
+        }
+    }
+    return false;
+}
+
+vector<Book*> SearchEngine::searchAsYouType(const string& query, int k, size_t& matchCount) {
+    lock_guard<mutex> lock(queryMutex);
+    matchCount = 0;
+    vector<string> words;
+    string prefix;
+    size_t count = tokenizer.tokenize(query);
+    for (size_t i = 0; i < count; i++) {
+        tokenizer.tokenAt(i, termScratch);
+        words.push_back(termScratch);
+    }
+    // The last word is still being typed unless whitespace follows it
+    if (count > 0 && tokenizer.tokenOffset(count - 1) + tokenizer.tokenSourceLength(count - 1) == query.size()) {
+        prefix = words.back();
+        words.pop_back();
+    }
+    
+    // Any index change makes every remembered step stale
+    if (typeAheadGeneration != indexGeneration) {
+        typeAhead.clear();
+        typeAheadGeneration = indexGeneration;
+    }
+    while (!typeAhead.empty() && !narrows(typeAhead.back(), words, prefix)) {
+        typeAhead.pop_back();
+    }
+    if (words.empty() && prefix.empty()) return vector<Book*>();
+    
+    if (typeAhead.empty() || typeAhead.back().words != words || typeAhead.back().prefix != prefix) {
+        TypeAheadStep step;
+        step.words = words;
+        step.prefix = prefix;
+        
+        vector<uint32_t> wordIDs;
+        bool known = true;
+        for (const string& word : words) {
+            auto it = termIDs.find(word);
+            if (it == termIDs.end()) {
+                known = false;
+                break;
+            }
+            wordIDs.push_back(it->second);
+        }
+        
+        // A word missing from the vocabulary leaves the step empty
+        if (known && !typeAhead.empty()) {
+            for (uint32_t docID : typeAhead.back().candidates) {
+                if (matchesTypeAhead(docID, wordIDs, prefix)) {
+                    step.candidates.push_back(docID);
+                }
+            }
+        } else if (known && !words.empty()) {
+            for (uint32_t docID : evaluate(ANY_FIELD, words, MATCH_ALL)) {
+                if (matchesTypeAhead(docID, vector<uint32_t>(), prefix)) {
+                    step.candidates.push_back(docID);
+                }
+            }
+        } else if (known) {
+            // First keystroke: the documents of every term with this prefix
+            refreshVocabulary();
+            vector<uint32_t> matches;
+            prefixDictionary.findPrefix(prefix, matches);
+            for (uint32_t termID : matches) {
+                PostingList docs = termPostings(ANY_FIELD, terms[termID]);
+                step.candidates.insert(step.candidates.end(), docs.begin(), docs.end());
+            }
+            sort(step.candidates.begin(), step.candidates.end());
+            step.candidates.erase(unique(step.candidates.begin(), step.candidates.end()), step.candidates.end());
+        }
+        typeAhead.push_back(step);
+    }
+    
+    const PostingList& candidates = typeAhead.back().candidates;
+    matchCount = candidates.size();
+    
+    // Rank by the complete words and the likeliest completions of the last one
+    vector<string> rankingTerms = words;
+    if (!prefix.empty()) {
+        for (uint32_t termID : topCompletions(prefix, SUGGESTION_COUNT)) {
+            rankingTerms.push_back(terms[termID]);
+        }
+    }
+    return toBooks(rankTopK(ANY_FIELD, rankingTerms, candidates, k, false));
+}
+
+// ============ FUZZY MATCHING ============
+
+int SearchEngine::fuzzyDistanceFor(const string& term) {
+    return term.length() <= 4 ? 1 : FUZZY_MAX_DISTANCE;
+}
+
+vector<Book*> SearchEngine::searchFuzzy(string query, Field field) {
+    lock_guard<mutex> lock(queryMutex);
+    MatchMode mode;
+    vector<Phrase> phrases;
+    vector<string> queryTerms = parseQuery(query, mode, &phrases);
+    
+    // A quoted phrase asks for exact words in order, which respelling cannot keep
+    if (queryTerms.empty() || !phrases.empty()) return vector<Book*>();
+    
+    refreshVocabulary();
+    
+    // For every query word, the smallest edit distance at which each book matches
+    unordered_map<uint32_t, int> totalDistance;
+    unordered_map<uint32_t, int> matchedWords;
+    
+    for (const string& word : queryTerms) {
+        unordered_map<uint32_t, int> best;
+        for (const TrigramIndex::Match& match : trigramIndex.findSimilar(word, fuzzyDistanceFor(word))) {
+            if (fieldFrequency(field, match.termID) == 0) continue;
+            
+            for (uint32_t docID : termPostings(field, terms[match.termID])) {
+                // Matches arrive closest first, so the first distance seen is the minimum
+                best.insert({docID, match.distance});
+            }
+        }
+        
+        for (const auto& entry : best) {
+            totalDistance[entry.first] += entry.second;
+            matchedWords[entry.first]++;
+        }
+    }
+    
+    vector<pair<int, uint32_t>> ranked;
+    for (const auto& entry : totalDistance) {
+        if (mode == MATCH_ANY || matchedWords[entry.first] == (int)queryTerms.size()) {
+            ranked.push_back(make_pair(entry.second, entry.first));
+        }
+    }
+    sort(ranked.begin(), ranked.end());
+    
+    PostingList docs;
+    for (const auto& entry : ranked) {
+        docs.push_back(entry.second);
+    }
+    return toBooks(docs);
+}
+
+vector<string> SearchEngine::suggestCorrections(string word, int k) {
+    lock_guard<mutex> lock(queryMutex);
+    vector<string> suggestions;
+    vector<string> words = tokenize(word);
+    if (words.empty() || k <= 0) return suggestions;
+    
+    refreshVocabulary();
+    
+    const string& target = words.back();
+    for (const TrigramIndex::Match& match : trigramIndex.findSimilar(target, fuzzyDistanceFor(target))) {
+        if (documentFrequency(match.termID) == 0 || terms[match.termID] == target) continue;
+        
+        suggestions.push_back(terms[match.termID]);
+        if ((int)suggestions.size() >= k) break;
+    }
+    return suggestions;
 }
 
 Book* SearchEngine::searchByISBN(string isbn) {
@@ -161,19 +1385,317 @@ Book* SearchEngine::searchByISBN(string isbn) {
     return bookTree->search(isbn);
 }
 
+// Available books in ISBN order, read straight off the availability bitmap
 vector<Book*> SearchEngine::searchAvailableBooks() {
-    if (bookTree == nullptr) return vector<Book*>();
+    PostingList docs;
+    {
+        lock_guard<mutex> lock(availabilityMutex);
+        availableDocs.toVector(docs);
+    }
     
-    vector<Book*> allBooks = bookTree->getAllBooksSorted();
-    vector<Book*> available;
+    vector<Book*> available = toBooks(docs);
+    sort(available.begin(), available.end(), [](Book* a, Book* b) {
+        return a->getISBN() < b->getISBN();
+    });
+    return available;
+}
+
+void SearchEngine::onAvailabilityChanged(Book* book, bool available) {
+    auto it = documentIDs.find(book->getISBN());
+    if (it == documentIDs.end() || documents[it->second] != book->getHandle()) return;
     
-    for (Book* book : allBooks) {
-        if (book->getAvailability()) {
-            available.push_back(book);
+    lock_guard<mutex> lock(availabilityMutex);
+    if (available) {
+        availableDocs.add(it->second);
+    } else {
+        availableDocs.remove(it->second);
+    }
+    availabilityGeneration++;
+}
+
+void SearchEngine::onQuantityChanged(Book* book) {
+    auto it = documentIDs.find(book->getISBN());
+    if (it == documentIDs.end() || documents[it->second] != book->getHandle()) return;
+    
+    facetIndex.updateQuantity(it->second, book->getQuantity());
+}
+
+// ============ FACETED SEARCH ============
+
+// The facet bitmaps are combined first; free text then only has to be
+// checked against that set, and an empty query reads it off directly
+vector<Book*> SearchEngine::searchFaceted(string query, const FacetIndex::Filter& filter, FacetIndex::Counts& counts) {
+    // One copy of the availability bitmap serves the filter and the counts
+    RoaringBitmap available;
+    {
+        lock_guard<mutex> lock(availabilityMutex);
+        available = availableDocs;
+    }
+    
+    RoaringBitmap selected;
+    bool restricted = facetIndex.select(filter, selected);
+    if (filter.availableOnly) {
+        if (restricted) {
+            selected.intersectWith(available);
+        } else {
+            selected = available;
+            restricted = true;
         }
     }
     
-    return available;
+    MatchMode mode;
+    vector<Phrase> phrases;
+    unique_lock<mutex> lock(queryMutex);
+    vector<string> queryTerms = parseQuery(query, mode, &phrases);
+    lock.unlock();
+    vector<string> rankingTerms = queryTerms;
+    for (const Phrase& phrase : phrases) {
+        addDistinct(rankingTerms, phrase);
+    }
+    
+    PostingList docs;
+    if (!rankingTerms.empty()) {
+        PostingList candidates = evaluatePhrases(ANY_FIELD, queryTerms, phrases, mode);
+        if (restricted) {
+            selected.filter(candidates, docs);
+        } else {
+            docs.swap(candidates);
+        }
+    } else if (restricted) {
+        selected.toVector(docs);
+    } else {
+        for (uint32_t docID = 0; docID < documents.size(); docID++) {
+            if (!documents[docID].isNull()) docs.push_back(docID);
+        }
+    }
+    
+    facetIndex.count(docs, available, FACET_VALUE_LIMIT, counts);
+    return toBooks(rankTopK(ANY_FIELD, rankingTerms, docs, MAX_SEARCH_RESULTS, false));
+}
+
+QueryCache::Stats SearchEngine::getCacheStats() const {
+    lock_guard<mutex> lock(queryMutex);
+    return queryCache.getStats();
+}
+
+double SearchEngine::getCacheHitRatio() const {
+    lock_guard<mutex> lock(queryMutex);
+    return queryCache.getHitRatio();
+}
+
+// ============ PERSISTENCE ============
+
+// FNV-1a hash of the indexed text, used to check a saved index still matches
+// the catalog. The version tag changes whenever tokenizing does (2: Unicode
+// case folding), so indexes built by older rules are rebuilt, not trusted.
+uint64_t SearchEngine::fingerprint(const Book* book) {
+    uint64_t hash = 1469598103934665603ULL;
+    string text = "2\n" + book->getTitle() + "\n" + book->getAuthor();
+    for (char c : text) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static string segmentFileName(int segmentID) {
+    stringstream ss;
+    ss << "segment_" << setfill('0') << setw(6) << segmentID << ".seg";
+    return ss.str();
+}
+
+static string formatTermCounts(const vector<pair<uint32_t, uint16_t>>& counts) {
+    stringstream ss;
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (i > 0) ss << LIST_DELIMITER;
+        ss << counts[i].first << ':' << counts[i].second;
+    }
+    return ss.str();
+}
+
+// Layout: manifest.txt lists the live segment files in document order,
+// terms.txt holds one term per line (line i is term ID i), and
+// documents.txt holds each document's ISBN, text fingerprint and term
+// counts. Dead documents are compacted away first, so every line is a live
+// book; segment files are written once.
+bool SearchEngine::saveIndex(const string& directory) {
+    if (documents.size() > documentIDs.size()) {
+        compactDocuments();
+    }
+    sealMemorySegment();
+    FileHandler::createDirectory(directory);
+    
+    vector<shared_ptr<IndexSegment>> snapshot;
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        snapshot = segments;
+    }
+    
+    bool success = true;
+    vector<string> manifest;
+    manifest.push_back("SegmentID,DocBegin,DocEnd");
+    for (const shared_ptr<IndexSegment>& segment : snapshot) {
+        if (!segment->isPersisted()) {
+            if (!segment->writeFile(directory + segmentFileName(segment->getSegmentID()))) {
+                success = false;
+                continue;
+            }
+            segment->setPersisted(true);
+        }
+        
+        stringstream ss;
+        ss << segment->getSegmentID() << CSV_DELIMITER << segment->getDocBegin() 
+           << CSV_DELIMITER << segment->getDocEnd();
+        manifest.push_back(ss.str());
+    }
+    if (!success) return false;
+    
+    vector<string> documentLines;
+    documentLines.push_back("ISBN,Fingerprint,TitleLength,AuthorLength,TitleTerms,AuthorTerms");
+    for (size_t docID = 0; docID < documents.size(); docID++) {
+        Book* book = documentBook((uint32_t)docID);
+        const DocumentStats& stats = documentStats[docID];
+        stringstream ss;
+        ss << book->getISBN() << CSV_DELIMITER << fingerprint(book)
+           << CSV_DELIMITER << stats.titleLength << CSV_DELIMITER << stats.authorLength
+           << CSV_DELIMITER << formatTermCounts(stats.titleTerms)
+           << CSV_DELIMITER << formatTermCounts(stats.authorTerms);
+        documentLines.push_back(ss.str());
+    }
+    
+    // The manifest goes last; files it no longer lists were merged away
+    vector<string> previous = FileHandler::readLines(directory + "manifest.txt");
+    success &= FileHandler::writeLines(directory + "terms.txt", terms);
+    success &= FileHandler::writeLines(directory + "documents.txt", documentLines);
+    success &= FileHandler::writeLines(directory + "manifest.txt", manifest);
+    if (!success) return false;
+    
+    for (size_t i = 1; i < previous.size(); i++) {
+        vector<string> fields = FileHandler::split(previous[i], CSV_DELIMITER);
+        if (fields.empty()) continue;
+        
+        bool stillListed = false;
+        for (size_t j = 1; j < manifest.size() && !stillListed; j++) {
+            stillListed = FileHandler::split(manifest[j], CSV_DELIMITER)[0] == fields[0];
+        }
+        if (!stillListed) {
+            try {
+                remove((directory + segmentFileName(stoi(fields[0]))).c_str());
+            } catch (...) {
+                continue;
+            }
+        }
+    }
+    return true;
+}
+
+static bool parseTermCounts(const string& text, size_t termCount, vector<pair<uint32_t, uint16_t>>& counts) {
+    for (const string& item : FileHandler::split(text, LIST_DELIMITER)) {
+        size_t colon = item.find(':');
+        if (colon == string::npos) return false;
+        
+        unsigned long termID = stoul(item.substr(0, colon));
+        unsigned long count = stoul(item.substr(colon + 1));
+        if (termID >= termCount || count > UINT16_MAX) return false;
+        counts.push_back(make_pair((uint32_t)termID, (uint16_t)count));
+    }
+    return true;
+}
+
+// Restores a saved index, mapping its segment files. Returns false (leaving
+// the engine empty) when the files are missing or no longer match the catalog.
+bool SearchEngine::loadIndex(const string& directory) {
+    if (bookTree == nullptr) return false;
+    
+    vector<string> manifest = FileHandler::readLines(directory + "manifest.txt");
+    vector<string> termLines = FileHandler::readLines(directory + "terms.txt");
+    vector<string> documentLines = FileHandler::readLines(directory + "documents.txt");
+    if (manifest.empty() || documentLines.empty()) return false;
+    
+    clear();
+    
+    bool valid = true;
+    int liveDocuments = 0;
+    try {
+        for (const string& term : termLines) {
+            getOrCreateTermID(term);
+        }
+        valid = terms.size() == termLines.size();
+        
+        for (size_t i = 1; i < documentLines.size() && valid; i++) {
+            uint32_t docID = (uint32_t)documents.size();
+            documents.push_back(Handle());
+            documentStats.push_back(DocumentStats());
+            // Indexes saved before dead documents were compacted list them as "-"
+            if (documentLines[i] == "-") {
+                lock_guard<mutex> lock(segmentMutex);
+                tombstones.add(docID);
+                continue;
+            }
+            
+            vector<string> fields = FileHandler::split(documentLines[i], CSV_DELIMITER);
+            Book* book = fields.size() >= 4 ? bookTree->search(fields[0]) : nullptr;
+            if (book == nullptr || stoull(fields[1]) != fingerprint(book) || documentIDs.count(fields[0])) {
+                valid = false;
+                break;
+            }
+            
+            DocumentStats& stats = documentStats.back();
+            stats.titleLength = (uint32_t)stoul(fields[2]);
+            stats.authorLength = (uint32_t)stoul(fields[3]);
+            valid = parseTermCounts(fields.size() > 4 ? fields[4] : "", terms.size(), stats.titleTerms) &&
+                    parseTermCounts(fields.size() > 5 ? fields[5] : "", terms.size(), stats.authorTerms);
+            
+            for (const auto& entry : stats.titleTerms) titleFrequency[entry.first]++;
+            for (const auto& entry : stats.authorTerms) authorFrequency[entry.first]++;
+            totalTitleLength += stats.titleLength;
+            totalAuthorLength += stats.authorLength;
+            
+            documents[docID] = book->getHandle();
+            documentIDs[fields[0]] = docID;
+            liveDocuments++;
+        }
+        
+        uint32_t expectedBegin = 0;
+        for (size_t i = 1; i < manifest.size() && valid; i++) {
+            vector<string> fields = FileHandler::split(manifest[i], CSV_DELIMITER);
+            int segmentID = fields.empty() ? 0 : stoi(fields[0]);
+            shared_ptr<IndexSegment> segment(IndexSegment::mapFile(directory + segmentFileName(segmentID)));
+            if (!segment || segment->getDocBegin() != expectedBegin) {
+                valid = false;
+                break;
+            }
+            
+            segment->setSegmentID(segmentID);
+            lock_guard<mutex> lock(segmentMutex);
+            segments.push_back(segment);
+            expectedBegin = segment->getDocEnd();
+            nextSegmentID = max(nextSegmentID, segmentID + 1);
+        }
+        valid = valid && expectedBegin == documents.size() && liveDocuments == bookTree->getCount();
+    } catch (...) {
+        valid = false;
+    }
+    
+    if (!valid) {
+        clear();
+        return false;
+    }
+    
+    memorySegment.docBegin = (uint32_t)documents.size();
+    for (uint32_t docID = 0; docID < documents.size(); docID++) {
+        Book* book = documentBook(docID);
+        if (book == nullptr) continue;
+        
+        if (book->getAvailability()) {
+            availableDocs.add(docID);
+        }
+        facetIndex.add(docID, book);
+        book->setObserver(this);
+    }
+    indexGeneration++;
+    requestMerge();
+    return true;
 }
 
 void SearchEngine::rebuildIndices() {
@@ -181,6 +1703,36 @@ void SearchEngine::rebuildIndices() {
 }
 
 void SearchEngine::clear() {
-    titleIndex.clear();
-    authorIndex.clear();
+    for (uint32_t docID = 0; docID < documents.size(); docID++) {
+        Book* book = documentBook(docID);
+        if (book != nullptr) {
+            book->setObserver(nullptr);
+        }
+    }
+    documents.clear();
+    documentStats.clear();
+    availableDocs.clear();
+    facetIndex.clear();
+    indexGeneration++;
+    totalTitleLength = 0;
+    totalAuthorLength = 0;
+    documentIDs.clear();
+    termIDs.clear();
+    terms.clear();
+    titleFrequency.clear();
+    authorFrequency.clear();
+    
+    {
+        lock_guard<mutex> lock(segmentMutex);
+        segments.clear();
+        memorySegment.titlePostings.clear();
+        memorySegment.authorPostings.clear();
+        memorySegment.docBegin = 0;
+        tombstones.clear();
+        segmentEpoch++;
+    }
+    
+    prefixDictionary.clear();
+    trigramIndex.clear();
+    vocabularyDirty = false;
 }
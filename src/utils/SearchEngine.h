@@ -2,32 +2,262 @@
 #define SEARCH_ENGINE_H
 
 #include "BookBST.h"
-#include <map>
+#include "PrefixDictionary.h"
+#include "TrigramIndex.h"
+#include "Tokenizer.h"
+#include "RoaringBitmap.h"
+#include "QueryCache.h"
+#include "IndexSegment.h"
+#include "FacetIndex.h"
 #include <vector>
+#include <string>
+#include <unordered_map>
 #include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+// Inverted index over book titles and authors. Every book gets a dense
+// document ID; the term dictionary maps each token to a sorted posting list
+// of document IDs per field, and multi-word queries intersect (AND) or merge
+// (OR) those lists. Postings also carry the token positions of the term in
+// the field, so a quoted phrase only matches consecutive words. Matches are
+// ranked with BM25 over per-field term frequencies and field lengths. The
+// engine observes every indexed book and keeps a bitmap of the documents
+// with copies on the shelf, so any search can be restricted to available
+// titles; a FacetIndex adds bitmaps per author, publisher and copy count for
+// filtered searches.
+//
+// Postings are stored LSM-style: new documents are appended to a small
+// in-memory segment, which is sealed into an immutable IndexSegment once it
+// holds MUTABLE_SEGMENT_DOCS documents. Removal only records a tombstone.
+// A background thread merges runs of similar-sized adjacent segments
+// (tiered policy) and drops tombstoned documents as it goes. Queries
+// concatenate a term's postings across the segments, which cover disjoint,
+// ascending document ranges. Sealed segments are saved to INDEX_DIR and
+// memory-mapped on the next start.
+class SearchEngine : public BookObserver {
+public:
+    enum Field { TITLE, AUTHOR, ANY_FIELD };
+    enum MatchMode { MATCH_ALL, MATCH_ANY };
 
-class SearchEngine {
 private:
-    multimap<string, Book*> titleIndex;
-    multimap<string, Book*> authorIndex;
+    typedef vector<uint32_t> PostingList;
+    typedef vector<string> Phrase;
+    typedef vector<pair<uint32_t, uint16_t>> TermCounts;
+    
+    // Per-document term frequencies (sorted by term ID) and field lengths
+    struct DocumentStats {
+        TermCounts titleTerms;
+        TermCounts authorTerms;
+        uint32_t titleLength;
+        uint32_t authorLength;
+    };
+    
+    // A term's documents in one field and their encoded position runs
+    struct MemoryPostings {
+        PostingList docs;
+        vector<uint8_t> positions;
+    };
+    
+    // Postings of documents added since the last seal; IDs only ever grow,
+    // so every list is an append-only sorted run
+    struct MemorySegment {
+        uint32_t docBegin;
+        unordered_map<uint32_t, MemoryPostings> titlePostings;
+        unordered_map<uint32_t, MemoryPostings> authorPostings;
+    };
+    
+    // One worker's share of a full rebuild: its own term dictionary and the
+    // postings and stats of a contiguous range of document IDs
+    struct PartialIndex {
+        unordered_map<string, uint32_t> termIDs;
+        vector<string> terms;
+        vector<PostingList> titlePostings;
+        vector<PostingList> authorPostings;
+        vector<vector<uint8_t>> titlePositions;
+        vector<vector<uint8_t>> authorPositions;
+        vector<DocumentStats> stats;
+        vector<uint32_t> globalIDs;
+    };
+    
     BookBST* bookTree;
+    // Each document's book by handle, resolved through bookTree; a removed
+    // book's handle goes stale, so a document can never reach a freed Book
+    vector<Handle> documents;
+    vector<DocumentStats> documentStats;
+    unordered_map<string, uint32_t> documentIDs;
+    uint64_t totalTitleLength;
+    uint64_t totalAuthorLength;
+    // Loans flip availability while other sessions search, so readers and
+    // onAvailabilityChanged take availabilityMutex around availableDocs
+    RoaringBitmap availableDocs;
+    mutable mutex availabilityMutex;
+    FacetIndex facetIndex;
+    
+    // Term dictionary and live document frequency per field
+    unordered_map<string, uint32_t> termIDs;
+    vector<string> terms;
+    vector<uint32_t> titleFrequency;
+    vector<uint32_t> authorFrequency;
+    
+    // Segments in document order; segmentMutex guards them and the
+    // tombstones, which the merge thread also updates
+    vector<shared_ptr<IndexSegment>> segments;
+    MemorySegment memorySegment;
+    RoaringBitmap tombstones;
+    mutable mutex segmentMutex;
+    uint64_t segmentEpoch;
+    int nextSegmentID;
+    
+    thread mergeThread;
+    atomic<bool> mergerRunning;
+    bool mergeRequested;
+    condition_variable mergeCondition;
+    
+    // Bumped by every index change and every availability flip respectively;
+    // cached results computed under an older generation are discarded
+    uint64_t indexGeneration;
+    atomic<uint64_t> availabilityGeneration;
+    QueryCache queryCache;
+    
+    // Batches and server sessions search on several threads. queryMutex
+    // guards the query tokenizer, the cache, the vocabulary structures and
+    // the search-as-you-type steps; evaluation and ranking of cached
+    // searches run unlocked.
+    mutable mutex queryMutex;
+    
+    // Search-as-you-type history: each step's complete words, the word being
+    // typed and the documents matching both. A step whose query implies the
+    // one below it only filters that step's candidates.
+    struct TypeAheadStep {
+        vector<string> words;
+        string prefix;
+        PostingList candidates;
+    };
+    vector<TypeAheadStep> typeAhead;
+    uint64_t typeAheadGeneration;
+    
+    // Vocabulary structures, rebuilt lazily once new terms have been added
+    PrefixDictionary prefixDictionary;
+    TrigramIndex trigramIndex;
+    bool vocabularyDirty;
     
-    string normalize(string str);
-    vector<string> tokenize(string str);
+    // Reused for every title, author and query so tokens need no allocation
+    Tokenizer tokenizer;
+    string termScratch;
+    vector<pair<uint32_t, uint32_t>> occurrenceScratch;
+    vector<uint32_t> positionScratch;
+    
+    vector<string> tokenize(const string& text);
+    
+    uint32_t getOrCreateTermID(const string& term);
+    uint32_t indexField(const string& text, Field field, uint32_t docID, TermCounts& counts);
+    void indexSlice(const vector<Book*>& books, size_t begin, size_t end, PartialIndex& part);
+    void mergePartials(vector<PartialIndex>& parts, int threadCount, uint32_t docCount);
+    void indexBooks(const vector<Book*>& allBooks, int threadCount);
+    void compactDocuments();
+    
+    void sealMemorySegment();
+    void requestMerge();
+    bool findMergeRun(size_t& first, size_t& count) const;
+    bool mergeOnce();
+    void mergeLoop();
+    static uint64_t fingerprint(const Book* book);
+    
+    vector<string> parseQuery(string query, MatchMode& mode, vector<Phrase>* phrases = nullptr);
+    PostingList termPostings(Field field, const string& term) const;
+    void termPositions(Field field, uint32_t termID, const PostingList& wanted, 
+                       IndexSegment::PositionLists& out) const;
+    PostingList evaluate(Field field, const vector<string>& queryTerms, MatchMode mode) const;
+    PostingList evaluatePhrases(Field field, const vector<string>& words, const vector<Phrase>& phrases,
+                                MatchMode mode) const;
+    PostingList matchPhrase(Field field, const Phrase& phrase, const PostingList& candidates) const;
+    Book* documentBook(uint32_t docID) const;
+    vector<Book*> toBooks(const PostingList& docs) const;
+    PostingList rankTopK(Field field, const vector<string>& queryTerms, const PostingList& candidates,
+                         size_t k, bool availableOnly) const;
+    vector<Book*> cachedSearch(Field field, const string& query, bool availableOnly);
+    double fieldScore(uint32_t df, const TermCounts& counts, uint32_t termID,
+                      uint32_t fieldLength, double averageLength) const;
+    static uint16_t termFrequency(const TermCounts& counts, uint32_t termID);
+    size_t documentFrequency(uint32_t termID) const;
+    size_t fieldFrequency(Field field, uint32_t termID) const;
+    void refreshVocabulary();
+    vector<uint32_t> topCompletions(const string& prefix, size_t k);
+    static int fuzzyDistanceFor(const string& term);
+    static bool narrows(const TypeAheadStep& step, const vector<string>& words, const string& prefix);
+    bool matchesTypeAhead(uint32_t docID, const vector<uint32_t>& wordIDs, const string& prefix) const;
+    
+    static void intersect(const PostingList& a, const PostingList& b, PostingList& out);
+    static void unite(const PostingList& a, const PostingList& b, PostingList& out);
+    static size_t gallop(const PostingList& list, size_t from, uint32_t target);
 
 public:
     SearchEngine();
+    ~SearchEngine();
     void setBookTree(BookBST* tree);
-    void buildIndices();
+    // threadCount 0 picks one thread per core, capped by INDEX_BUILD_MIN_SLICE
+    void buildIndices(int threadCount = 0);
     void addBookToIndex(Book* book);
     void removeBookFromIndex(Book* book);
     
-    vector<Book*> searchByTitle(string title);
-    vector<Book*> searchByAuthor(string author);
-    vector<Book*> searchByKeyword(string keyword);
+    vector<Book*> searchByTitle(string title, bool availableOnly = false);
+    vector<Book*> searchByAuthor(string author, bool availableOnly = false);
+    vector<Book*> searchByKeyword(string keyword, bool availableOnly = false);
+    // Every book crediting an AuthorRegistry author, in title order
+    vector<Book*> searchByAuthorID(uint32_t authorID);
+    size_t countBooksByAuthor(uint32_t authorID) const;
     Book* searchByISBN(string isbn);
     vector<Book*> searchAvailableBooks();
     
+    // Batch lookups answer each distinct query once and return results in
+    // input order. ISBNs are sorted and found in one walk of the tree (nullptr
+    // where absent); text queries are spread over threadCount workers, 0
+    // meaning one per core, capped by BATCH_QUERIES_PER_THREAD.
+    vector<Book*> searchByISBNs(const vector<string>& isbns);
+    vector<vector<Book*>> searchBatch(Field field, const vector<string>& queries, bool availableOnly = false,
+                                      int threadCount = 0);
+    
+    // Free text (may be empty) narrowed by facet filters; counts cover every
+    // match, the returned books only the best MAX_SEARCH_RESULTS
+    vector<Book*> searchFaceted(string query, const FacetIndex::Filter& filter, FacetIndex::Counts& counts);
+    
+    void onAvailabilityChanged(Book* book, bool available);
+    void onQuantityChanged(Book* book);
+    
+    QueryCache::Stats getCacheStats() const;
+    double getCacheHitRatio() const;
+    
+    // Segment maintenance: background merging and persistence of sealed segments
+    void startMerger();
+    void stopMerger();
+    void waitForMerges();
+    bool saveIndex(const string& directory);
+    bool loadIndex(const string& directory);
+    int getSegmentCount() const;
+    int getMappedSegmentCount() const;
+    void getIndexFootprint(size_t& postingBytes, size_t& positionBytes) const;
+    size_t getTombstoneCount() const;
+    
+    // Autocomplete: the last word of the query is treated as a prefix
+    vector<string> suggestCompletions(string prefix, int k);
+    vector<Book*> searchByPrefix(string query, int k);
+    
+    // Incremental search, called with the whole query after every keystroke.
+    // Complete words must all match and the last, unfinished word matches as
+    // a prefix; extending the query narrows the previous matches instead of
+    // searching again, and deleting characters returns to earlier ones.
+    vector<Book*> searchAsYouType(const string& query, int k, size_t& matchCount);
+    
+    // Typo tolerance: terms within edit distance 1-2, closest matches first.
+    // Queries with a quoted phrase get no fuzzy matches.
+    vector<Book*> searchFuzzy(string query, Field field);
+    vector<string> suggestCorrections(string word, int k);
+    
     void rebuildIndices();
     void clear();
 };
@@ -0,0 +1,97 @@
+#ifndef SLOT_TABLE_H
+#define SLOT_TABLE_H
+
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+// Reference to an entity in a SlotTable: its slot and the slot's generation
+// when the entity was placed there. Generation 0 is never handed out, so a
+// default Handle refers to nothing.
+struct Handle {
+    uint32_t index;
+    uint32_t generation;
+    
+    Handle() : index(0), generation(0) {}
+    Handle(uint32_t slot, uint32_t gen) : index(slot), generation(gen) {}
+    
+    bool isNull() const { return generation == 0; }
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Owning table of entities addressed by Handle. Entities stay at the same
+// address for their whole life, so they can be updated in place; erasing
+// one deletes it and bumps its slot's generation, which makes every handle
+// still naming it resolve to nullptr instead of dangling. Freed slots are
+// reused, keeping indexes dense.
+template <typename T>
+class SlotTable {
+private:
+    struct Slot {
+        T* item;
+        uint32_t generation;
+    };
+    
+    vector<Slot> slots;
+    vector<uint32_t> freeSlots;
+    size_t count;
+
+public:
+    SlotTable() : count(0) {}
+    ~SlotTable() { clear(); }
+    
+    Handle insert(T* item) {
+        uint32_t index;
+        if (freeSlots.empty()) {
+            index = (uint32_t)slots.size();
+            Slot slot = {nullptr, 1};
+            slots.push_back(slot);
+        } else {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        slots[index].item = item;
+        count++;
+        return Handle(index, slots[index].generation);
+    }
+    
+    T* get(Handle handle) const {
+        if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) {
+            return nullptr;
+        }
+        return slots[handle.index].item;
+    }
+    
+    bool contains(Handle handle) const {
+        return get(handle) != nullptr;
+    }
+    
+    // Deletes the entity; false if the handle was already stale
+    bool erase(Handle handle) {
+        T* item = get(handle);
+        if (item == nullptr) return false;
+        
+        delete item;
+        Slot& slot = slots[handle.index];
+        slot.item = nullptr;
+        // Skip 0 on wrap-around so it keeps meaning "no entity"
+        slot.generation = slot.generation == UINT32_MAX ? 1 : slot.generation + 1;
+        freeSlots.push_back(handle.index);
+        count--;
+        return true;
+    }
+    
+    size_t size() const { return count; }
+    
+    // Deletes every entity; generations are kept so old handles stay stale
+    void clear() {
+        for (uint32_t index = 0; index < slots.size(); index++) {
+            if (slots[index].item != nullptr) {
+                erase(Handle(index, slots[index].generation));
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "StringPool.h"
+
+StringPool::StringPool() {
+    intern("");
+}
+
+StringPool* StringPool::getInstance() {
+    // The first intern may come from any session thread; a local static is
+    // built exactly once. Never freed, so symbols resolve until exit.
+    static StringPool* pool = new StringPool();
+    return pool;
+}
+
+uint32_t StringPool::intern(const string& str) {
+    lock_guard<mutex> lock(poolMutex);
+    auto it = symbols.find(str);
+    if (it != symbols.end()) {
+        return it->second;
+    }
+    
+    uint32_t symbol = (uint32_t)strings.size();
+    auto inserted = symbols.insert({str, symbol});
+    // unordered_map nodes never move, so the key can back the reverse table
+    strings.push_back(&inserted.first->first);
+    return symbol;
+}
+
+const string& StringPool::resolve(uint32_t symbol) const {
+    lock_guard<mutex> lock(poolMutex);
+    if (symbol >= strings.size()) {
+        return *strings[0];
+    }
+    return *strings[symbol];
+}
+
+int StringPool::getCount() const {
+    lock_guard<mutex> lock(poolMutex);
+    return (int)strings.size();
+}
@@ -0,0 +1,31 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+using namespace std;
+
+// Process-wide intern table for strings repeated across many records
+// (book titles and user names in transactions). Each distinct string is
+// stored once and referenced by a 32-bit symbol; symbol 0 is "".
+class StringPool {
+private:
+    unordered_map<string, uint32_t> symbols;
+    vector<const string*> strings;
+    // Transactions are created on session threads
+    mutable mutex poolMutex;
+    
+    StringPool();
+
+public:
+    static StringPool* getInstance();
+    
+    uint32_t intern(const string& str);
+    const string& resolve(uint32_t symbol) const;
+    int getCount() const;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "Tokenizer.h"
+#include "CaseFolder.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOKENIZER_SSE2 1
+#endif
+
+Tokenizer::Tokenizer(bool useVectorPath) 
+    : vectorized(useVectorPath && hasVectorPath()), written(0), inToken(false), tokenStart(0), sourceStart(0) {}
+
+bool Tokenizer::hasVectorPath() {
+#ifdef TOKENIZER_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Same whitespace set as isspace() in the C locale
+static inline bool isSeparator(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int lowestBit(uint32_t bits) {
+#ifdef __GNUC__
+    return __builtin_ctz(bits);
+#else
+    int index = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+size_t Tokenizer::tokenize(const string& text) {
+    buffer.resize(text.length());
+    spans.clear();
+    written = 0;
+    inToken = false;
+    tokenStart = 0;
+    sourceStart = 0;
+    
+    // Alternate between the two loops: the vector one stops at the first
+    // block holding a non-ASCII byte, the scalar one hands back after it
+    size_t pos = 0;
+    while (pos < text.length()) {
+        if (vectorized) {
+            pos = scanVector(text, pos);
+        }
+        pos = scanScalar(text, pos);
+    }
+    
+    if (inToken) {
+        endToken(written, text.length());
+    }
+    return spans.size();
+}
+
+// Tokens made only of dropped combining marks leave nothing to record
+void Tokenizer::endToken(size_t end, size_t sourceEnd) {
+    if (end > tokenStart) {
+        Span span = { (uint32_t)tokenStart, (uint32_t)(end - tokenStart), 
+                      (uint32_t)sourceStart, (uint32_t)(sourceEnd - sourceStart) };
+        spans.push_back(span);
+    }
+    inToken = false;
+}
+
+// Lowercases whole 16-byte ASCII blocks and turns their whitespace masks
+// into token boundaries: a token starts where a non-space byte follows a
+// space and ends at the first space after it. Returns where it stopped.
+size_t Tokenizer::scanVector(const string& text, size_t pos) {
+#ifdef TOKENIZER_SSE2
+    const size_t BLOCK = 16;
+    const size_t length = text.length();
+    const char* in = text.data();
+    char* out = &buffer[0];
+    
+    const __m128i beforeA = _mm_set1_epi8('A' - 1);
+    const __m128i afterZ = _mm_set1_epi8('Z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i beforeTab = _mm_set1_epi8('\t' - 1);
+    const __m128i afterReturn = _mm_set1_epi8('\r' + 1);
+    
+    // Scan state is kept in locals: stores into the buffer may alias members
+    size_t outPos = written;
+    bool open = inToken;
+    
+    for (; pos + BLOCK <= length; pos += BLOCK, outPos += BLOCK) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(in + pos));
+        
+        // Any byte >= 0x80 belongs to a UTF-8 sequence: leave the block to the scalar loop
+        if (_mm_movemask_epi8(bytes) != 0) break;
+        
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeA), _mm_cmplt_epi8(bytes, afterZ));
+        _mm_storeu_si128((__m128i*)(out + outPos), _mm_or_si128(bytes, _mm_and_si128(upper, caseBit)));
+        
+        __m128i control = _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeTab), _mm_cmplt_epi8(bytes, afterReturn));
+        uint32_t spaces = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), control));
+        
+        // Common cases: the block is entirely inside a word or entirely blank
+        if ((spaces == 0 && open) || (spaces == 0xFFFF && !open)) continue;
+        
+        uint32_t word = ~spaces & 0xFFFF;
+        uint32_t previous = ((word << 1) | (open ? 1u : 0u)) & 0xFFFF;
+        uint32_t starts = word & ~previous;
+        uint32_t events = starts | (~word & previous);
+        
+        while (events != 0) {
+            int bit = lowestBit(events);
+            if (starts & (1u << bit)) {
+                tokenStart = outPos + bit;
+                sourceStart = pos + bit;
+            } else {
+                endToken(outPos + bit, pos + bit);
+            }
+            events &= events - 1;
+        }
+        open = (word & 0x8000) != 0;
+    }
+    
+    written = outPos;
+    inToken = open;
+    return pos;
+#else
+    (void)text;
+    return pos;
+#endif
+}
+
+// One byte or UTF-8 sequence at a time. With the vector loop available it
+// returns after each non-ASCII sequence while a full block remains.
+size_t Tokenizer::scanScalar(const string& text, size_t pos) {
+    const unsigned char* in = (const unsigned char*)text.data();
+    const size_t length = text.length();
+    char* out = &buffer[0];
+    size_t outPos = written;
+    
+    while (pos < length) {
+        unsigned char c = in[pos];
+        if (c < 0x80) {
+            if (isSeparator(c)) {
+                if (inToken) endToken(outPos, pos);
+            } else if (!inToken) {
+                tokenStart = outPos;
+                sourceStart = pos;
+                inToken = true;
+            }
+            out[outPos++] = (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : (char)c;
+            pos++;
+            continue;
+        }
+        
+        uint32_t codePoint;
+        size_t consumed = CaseFolder::decode(in + pos, length - pos, codePoint);
+        if (codePoint != CaseFolder::INVALID && CaseFolder::isSpace(codePoint)) {
+            if (inToken) endToken(outPos, pos);
+        } else {
+            if (!inToken) {
+                tokenStart = outPos;
+                sourceStart = pos;
+                inToken = true;
+            }
+            // Malformed bytes are kept as they are rather than guessed at
+            if (codePoint == CaseFolder::INVALID) {
+                out[outPos++] = (char)c;
+            } else {
+                outPos += CaseFolder::fold(codePoint, out + outPos);
+            }
+        }
+        pos += consumed;
+        
+        if (vectorized && length - pos >= 16) break;
+    }
+    
+    written = outPos;
+    return pos;
+}
+
+size_t Tokenizer::getTokenCount() const {
+    return spans.size();
+}
+
+const char* Tokenizer::tokenData(size_t i) const {
+    return buffer.data() + spans[i].offset;
+}
+
+size_t Tokenizer::tokenLength(size_t i) const {
+    return spans[i].length;
+}
+
+size_t Tokenizer::tokenOffset(size_t i) const {
+    return spans[i].sourceOffset;
+}
+
+size_t Tokenizer::tokenSourceLength(size_t i) const {
+    return spans[i].sourceLength;
+}
+
+void Tokenizer::tokenAt(size_t i, string& out) const {
+    out.assign(buffer, spans[i].offset, spans[i].length);
+}
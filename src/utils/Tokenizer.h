@@ -0,0 +1,57 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+// Single-pass folding tokenizer. Text is case-folded into an internal
+// buffer and split on whitespace in the same sweep; tokens are recorded as
+// (offset, length) pairs into that buffer, so repeated calls reuse memory
+// instead of allocating a string per word. Pure-ASCII runs go through SSE2
+// sixteen bytes at a time when available; UTF-8 sequences drop to a scalar
+// loop that folds them with CaseFolder (lower case, accents stripped), so
+// "Gabriel García Márquez" and "gabriel garcia marquez" give the same tokens.
+class Tokenizer {
+private:
+    // Position in the folded buffer and in the original text
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t sourceOffset;
+        uint32_t sourceLength;
+    };
+    
+    string buffer;
+    vector<Span> spans;
+    bool vectorized;
+    
+    // Scan state: bytes written to buffer and the token being read, if any
+    size_t written;
+    bool inToken;
+    size_t tokenStart;
+    size_t sourceStart;
+    
+    size_t scanVector(const string& text, size_t pos);
+    size_t scanScalar(const string& text, size_t pos);
+    void endToken(size_t end, size_t sourceEnd);
+    
+public:
+    explicit Tokenizer(bool useVectorPath = true);
+    
+    // Replaces the current tokens with those of text; returns the token count
+    size_t tokenize(const string& text);
+    
+    size_t getTokenCount() const;
+    const char* tokenData(size_t i) const;
+    size_t tokenLength(size_t i) const;
+    // Where the token came from in the original text, before folding
+    size_t tokenOffset(size_t i) const;
+    size_t tokenSourceLength(size_t i) const;
+    void tokenAt(size_t i, string& out) const;
+    
+    static bool hasVectorPath();
+};
+
+#endif
@@ -0,0 +1,292 @@
+#include "TransactionArchive.h"
+#include "FileHandler.h"
+#include "../Config.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+
+TransactionArchive::TransactionArchive(string directory) 
+    : directory(directory), archivedCount(0) {}
+
+string TransactionArchive::manifestPath() const {
+    return directory + "manifest.txt";
+}
+
+string TransactionArchive::dataPath(int segmentID) const {
+    stringstream ss;
+    ss << directory << "segment_" << setfill('0') << setw(6) << segmentID << ".txt";
+    return ss.str();
+}
+
+string TransactionArchive::indexPath(int segmentID) const {
+    stringstream ss;
+    ss << directory << "segment_" << setfill('0') << setw(6) << segmentID << ".idx";
+    return ss.str();
+}
+
+string TransactionArchive::filterPath(int segmentID) const {
+    stringstream ss;
+    ss << directory << "segment_" << setfill('0') << setw(6) << segmentID << ".flt";
+    return ss.str();
+}
+
+bool TransactionArchive::load() {
+    segments.clear();
+    archivedCount = 0;
+    
+    vector<string> lines = FileHandler::readLines(manifestPath());
+    if (lines.empty()) return false;
+    
+    for (size_t i = 1; i < lines.size(); i++) {
+        vector<string> fields = FileHandler::split(lines[i], CSV_DELIMITER);
+        if (fields.size() < 6) continue;
+        
+        try {
+            SegmentInfo info;
+            info.segmentID = stoi(fields[0]);
+            info.count = stoi(fields[1]);
+            info.firstID = stoull(fields[2]);
+            info.lastID = stoull(fields[3]);
+            info.minTime = (time_t)stoll(fields[4]);
+            info.maxTime = (time_t)stoll(fields[5]);
+            
+            // Segments archived before filters existed have none and are always searched
+            vector<string> filter = FileHandler::readLines(filterPath(info.segmentID));
+            if (filter.empty() || !info.keys.fromString(filter[0])) {
+                info.keys = BloomFilter();
+            }
+            
+            segments.push_back(info);
+            archivedCount += info.count;
+            Transaction::observeID(info.lastID);
+        } catch (...) {
+            continue;
+        }
+    }
+    
+    return true;
+}
+
+bool TransactionArchive::archive(const vector<Transaction*>& oldest) {
+    if (oldest.empty()) return true;
+    
+    FileHandler::createDirectory(directory);
+    
+    SegmentInfo info;
+    info.segmentID = segments.empty() ? 1 : segments.back().segmentID + 1;
+    info.count = (int)oldest.size();
+    info.firstID = oldest.front()->getID();
+    info.lastID = oldest.back()->getID();
+    info.minTime = oldest.front()->getTime();
+    info.maxTime = oldest.front()->getTime();
+    
+    // Binary mode keeps the recorded offsets exact on every platform
+    ofstream data(dataPath(info.segmentID), ios::binary);
+    if (!data.is_open()) return false;
+    
+    map<string, vector<long>> userOffsets;
+    map<string, vector<long>> bookOffsets;
+    long offset = 0;
+    
+    for (Transaction* trans : oldest) {
+        string line = trans->toFileString();
+        data << line << "\n";
+        
+        userOffsets[trans->getUserID()].push_back(offset);
+        bookOffsets[trans->getISBN()].push_back(offset);
+        offset += (long)line.length() + 1;
+        
+        if (trans->getTime() < info.minTime) info.minTime = trans->getTime();
+        if (trans->getTime() > info.maxTime) info.maxTime = trans->getTime();
+    }
+    data.close();
+    
+    vector<string> indexLines;
+    for (int pass = 0; pass < 2; pass++) {
+        const map<string, vector<long>>& offsets = pass == 0 ? userOffsets : bookOffsets;
+        for (const auto& entry : offsets) {
+            stringstream ss;
+            ss << (pass == 0 ? 'U' : 'B') << CSV_DELIMITER << entry.first << CSV_DELIMITER;
+            for (size_t i = 0; i < entry.second.size(); i++) {
+                if (i > 0) ss << LIST_DELIMITER;
+                ss << entry.second[i];
+            }
+            indexLines.push_back(ss.str());
+        }
+    }
+    if (!FileHandler::writeLines(indexPath(info.segmentID), indexLines)) return false;
+    
+    info.keys = BloomFilter(userOffsets.size() + bookOffsets.size(), ARCHIVE_FILTER_BITS_PER_KEY);
+    for (const auto& entry : userOffsets) {
+        info.keys.add("U" + entry.first);
+    }
+    for (const auto& entry : bookOffsets) {
+        info.keys.add("B" + entry.first);
+    }
+    if (!FileHandler::writeLines(filterPath(info.segmentID), vector<string>{info.keys.toString()})) return false;
+    
+    // The manifest entry is written last: a segment only exists once listed
+    if (!FileHandler::fileExists(manifestPath())) {
+        FileHandler::appendLine(manifestPath(), "SegmentID,Count,FirstID,LastID,MinTime,MaxTime");
+    }
+    stringstream entry;
+    entry << info.segmentID << CSV_DELIMITER << info.count << CSV_DELIMITER
+          << info.firstID << CSV_DELIMITER << info.lastID << CSV_DELIMITER
+          << (long long)info.minTime << CSV_DELIMITER << (long long)info.maxTime;
+    if (!FileHandler::appendLine(manifestPath(), entry.str())) return false;
+    
+    segments.push_back(info);
+    archivedCount += info.count;
+    return true;
+}
+
+// Order of index lines as archive() writes them: every user line, then
+// every ISBN line, each group sorted by key
+static int compareIndexLine(const string& line, char kind, const string& key) {
+    if (line.length() < 2) return -1;
+    
+    int group = line[0] == 'U' ? 0 : 1;
+    int wanted = kind == 'U' ? 0 : 1;
+    if (group != wanted) return group - wanted;
+    
+    size_t end = line.find(CSV_DELIMITER, 2);
+    return line.compare(2, end == string::npos ? string::npos : end - 2, key);
+}
+
+// Bisects the sorted index on byte offsets, then reads the few lines left
+vector<long> TransactionArchive::lookupOffsets(int segmentID, char kind, const string& key) const {
+    vector<long> offsets;
+    ifstream index(indexPath(segmentID), ios::binary);
+    if (!index.is_open()) return offsets;
+    
+    // Lines starting before low all sort before the key; its line, if
+    // present, starts at or before high
+    index.seekg(0, ios::end);
+    long low = 0;
+    long high = (long)index.tellg();
+    string line;
+    
+    while (low < high) {
+        long mid = low + (high - low) / 2;
+        index.clear();
+        index.seekg(mid);
+        getline(index, line);
+        long start = (long)index.tellg();
+        if (start < 0 || start >= high || !getline(index, line)) break;
+        
+        if (compareIndexLine(line, kind, key) < 0) {
+            low = start + (long)line.length() + 1;
+        } else {
+            high = start;
+        }
+    }
+    
+    index.clear();
+    index.seekg(low);
+    while (getline(index, line)) {
+        int order = compareIndexLine(line, kind, key);
+        if (order < 0) continue;
+        if (order > 0) break;
+        
+        stringstream ss(line.substr(3 + key.length()));
+        string offset;
+        while (getline(ss, offset, LIST_DELIMITER)) {
+            offsets.push_back(stol(offset));
+        }
+        break;
+    }
+    
+    return offsets;
+}
+
+vector<Transaction> TransactionArchive::readAt(int segmentID, const vector<long>& offsets) const {
+    vector<Transaction> result;
+    ifstream data(dataPath(segmentID), ios::binary);
+    if (!data.is_open()) return result;
+    
+    string line;
+    for (long offset : offsets) {
+        data.seekg(offset);
+        if (getline(data, line)) {
+            try {
+                result.push_back(Transaction::fromFileString(line));
+            } catch (...) {
+                continue;
+            }
+        }
+    }
+    
+    return result;
+}
+
+vector<Transaction> TransactionArchive::getByKey(char kind, const string& key) const {
+    vector<Transaction> result;
+    
+    for (const SegmentInfo& info : segments) {
+        if (!info.keys.mightContain(kind + key)) continue;
+        
+        vector<long> offsets = lookupOffsets(info.segmentID, kind, key);
+        if (offsets.empty()) continue;
+        
+        vector<Transaction> found = readAt(info.segmentID, offsets);
+        result.insert(result.end(), found.begin(), found.end());
+    }
+    
+    return result;
+}
+
+vector<Transaction> TransactionArchive::getByUserID(string userID) const {
+    return getByKey('U', userID);
+}
+
+vector<Transaction> TransactionArchive::getByISBN(string isbn) const {
+    return getByKey('B', isbn);
+}
+
+vector<Transaction> TransactionArchive::getByTimeRange(time_t from, time_t to) const {
+    vector<Transaction> result;
+    
+    for (const SegmentInfo& info : segments) {
+        if (info.maxTime < from || info.minTime > to) continue;
+        
+        vector<string> lines = FileHandler::readLines(dataPath(info.segmentID));
+        for (const string& line : lines) {
+            try {
+                Transaction trans = Transaction::fromFileString(line);
+                if (trans.getTime() >= from && trans.getTime() <= to) {
+                    result.push_back(trans);
+                }
+            } catch (...) {
+                continue;
+            }
+        }
+    }
+    
+    return result;
+}
+
+void TransactionArchive::forEach(const function<void(const Transaction&)>& visit) const {
+    for (const SegmentInfo& info : segments) {
+        vector<string> lines = FileHandler::readLines(dataPath(info.segmentID));
+        for (const string& line : lines) {
+            try {
+                visit(Transaction::fromFileString(line));
+            } catch (...) {
+                continue;
+            }
+        }
+    }
+}
+
+long TransactionArchive::getCount() const {
+    return archivedCount;
+}
+
+int TransactionArchive::getSegmentCount() const {
+    return (int)segments.size();
+}
+
+uint64_t TransactionArchive::getLastID() const {
+    return segments.empty() ? 0 : segments.back().lastID;
+}
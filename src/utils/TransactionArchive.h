@@ -0,0 +1,60 @@
+#ifndef TRANSACTION_ARCHIVE_H
+#define TRANSACTION_ARCHIVE_H
+
+#include "../entities/Transaction.h"
+#include "BloomFilter.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+using namespace std;
+
+// Cold tier of the transaction history. Transactions that fall out of the
+// in-memory window are written to immutable segment files, each with a
+// sorted index of byte offsets per user and per ISBN and a Bloom filter of
+// those keys. Only the manifest (one line per segment) and the filters stay
+// resident: a lookup skips segments whose filter rules the key out and
+// binary-searches the index of the rest; segment data is read on demand.
+class TransactionArchive {
+private:
+    struct SegmentInfo {
+        int segmentID;
+        int count;
+        uint64_t firstID;
+        uint64_t lastID;
+        time_t minTime;
+        time_t maxTime;
+        BloomFilter keys;       // "U" + user ID and "B" + ISBN; empty if unsaved
+    };
+    
+    string directory;
+    vector<SegmentInfo> segments;
+    long archivedCount;
+    
+    string manifestPath() const;
+    string dataPath(int segmentID) const;
+    string indexPath(int segmentID) const;
+    string filterPath(int segmentID) const;
+    vector<long> lookupOffsets(int segmentID, char kind, const string& key) const;
+    vector<Transaction> readAt(int segmentID, const vector<long>& offsets) const;
+    vector<Transaction> getByKey(char kind, const string& key) const;
+
+public:
+    TransactionArchive(string directory);
+    
+    bool load();
+    bool archive(const vector<Transaction*>& oldest);
+    
+    vector<Transaction> getByUserID(string userID) const;
+    vector<Transaction> getByISBN(string isbn) const;
+    vector<Transaction> getByTimeRange(time_t from, time_t to) const;
+    // Visits every archived transaction oldest first, one segment in memory at a time
+    void forEach(const function<void(const Transaction&)>& visit) const;
+    
+    long getCount() const;
+    int getSegmentCount() const;
+    uint64_t getLastID() const;
+};
+
+#endif
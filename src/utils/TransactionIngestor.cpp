@@ -0,0 +1,130 @@
+#include "TransactionIngestor.h"
+
+TransactionIngestor::TransactionIngestor(TransactionList* list, size_t capacity, size_t batchSize)
+    : queue(capacity), transList(list), batchSize(batchSize), running(false), 
+      consumerIdle(false), publishedCount(0), appliedCount(0), inFlight(0) {}
+
+TransactionIngestor::~TransactionIngestor() {
+    stop();
+}
+
+void TransactionIngestor::start() {
+    if (running.exchange(true)) return;
+    consumer = thread(&TransactionIngestor::consumeLoop, this);
+}
+
+void TransactionIngestor::stop() {
+    if (!running.exchange(false)) return;
+    
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+    consumer.join();
+    
+    // Anything published after the consumer saw the stop flag. Draining
+    // while waiting also frees ring space for a publisher spinning on a
+    // full ring.
+    vector<Transaction*> batch;
+    while (inFlight.load() > 0) {
+        if (drainOnce(batch) == 0) {
+            this_thread::yield();
+        }
+    }
+    while (drainOnce(batch) > 0) {
+    }
+}
+
+void TransactionIngestor::publish(Transaction* trans) {
+    publishedCount.fetch_add(1);
+    
+    // Sequentially consistent pair with stop(): either this thread sees the
+    // stop flag, or stop() sees it in flight and waits for the push
+    inFlight.fetch_add(1);
+    if (!running.load()) {
+        inFlight.fetch_sub(1);
+        
+        // No consumer: apply inline (startup loading, shutdown)
+        lock_guard<mutex> lock(applyMutex);
+        transList->append(trans);
+        appliedCount.fetch_add(1, memory_order_release);
+        return;
+    }
+    
+    while (!queue.tryPush(trans)) {
+        // Ring full: back off until the consumer catches up
+        this_thread::yield();
+    }
+    inFlight.fetch_sub(1);
+    
+    // Sequentially consistent pair with consumeLoop(): either the consumer
+    // counts this event before it sleeps, or this thread sees it idle
+    if (consumerIdle.load()) {
+        lock_guard<mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+void TransactionIngestor::flush() {
+    uint64_t target = publishedCount.load(memory_order_acquire);
+    
+    while (appliedCount.load(memory_order_acquire) < target) {
+        if (consumerIdle.load(memory_order_acquire)) {
+            lock_guard<mutex> lock(wakeMutex);
+            wakeCondition.notify_one();
+        }
+        this_thread::yield();
+    }
+}
+
+size_t TransactionIngestor::drainOnce(vector<Transaction*>& batch) {
+    batch.clear();
+    size_t popped = queue.popBatch(batch, batchSize);
+    
+    if (popped > 0) {
+        lock_guard<mutex> lock(applyMutex);
+        transList->appendBatch(batch);
+        appliedCount.fetch_add(popped, memory_order_release);
+    }
+    
+    return popped;
+}
+
+void TransactionIngestor::consumeLoop() {
+    vector<Transaction*> batch;
+    batch.reserve(batchSize);
+    int idleSpins = 0;
+    
+    while (running.load(memory_order_acquire)) {
+        if (drainOnce(batch) > 0) {
+            idleSpins = 0;
+            continue;
+        }
+        
+        if (++idleSpins < 64) {
+            this_thread::yield();
+            continue;
+        }
+        
+        // Park until a producer signals. Events are counted before they are
+        // pushed, so one still being pushed wakes the loop to spin for it.
+        unique_lock<mutex> lock(wakeMutex);
+        consumerIdle.store(true);
+        wakeCondition.wait(lock, [this]() {
+            return appliedCount.load() < publishedCount.load() || !running.load();
+        });
+        consumerIdle.store(false, memory_order_release);
+        idleSpins = 0;
+    }
+    
+    while (drainOnce(batch) > 0) {
+    }
+}
+
+uint64_t TransactionIngestor::getPublishedCount() const {
+    return publishedCount.load();
+}
+
+uint64_t TransactionIngestor::getAppliedCount() const {
+    return appliedCount.load();
+}
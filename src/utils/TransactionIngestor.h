@@ -0,0 +1,51 @@
+#ifndef TRANSACTION_INGESTOR_H
+#define TRANSACTION_INGESTOR_H
+
+#include "TransactionQueue.h"
+#include "TransactionList.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+// Append path for concurrent sessions. Any thread may publish() without
+// taking a lock; a single consumer thread drains the ring and applies the
+// events to the TransactionList (and its user/book indexes) in batches.
+class TransactionIngestor {
+private:
+    TransactionQueue queue;
+    TransactionList* transList;
+    size_t batchSize;
+    
+    thread consumer;
+    atomic<bool> running;
+    atomic<bool> consumerIdle;
+    atomic<uint64_t> publishedCount;
+    atomic<uint64_t> appliedCount;
+    // Publishers between their running check and their push; stop() waits
+    // for these so none can strand an event behind the final drain
+    atomic<int> inFlight;
+    // Serializes TransactionList writes between the consumer's batches and
+    // inline appends made while no consumer runs
+    mutex applyMutex;
+    mutex wakeMutex;
+    condition_variable wakeCondition;
+    
+    void consumeLoop();
+    size_t drainOnce(vector<Transaction*>& batch);
+
+public:
+    TransactionIngestor(TransactionList* list, size_t capacity, size_t batchSize);
+    ~TransactionIngestor();
+    
+    void start();
+    void stop();
+    void publish(Transaction* trans);
+    void flush();
+    
+    uint64_t getPublishedCount() const;
+    uint64_t getAppliedCount() const;
+};
+
+#endif
@@ -7,6 +7,18 @@ TransactionList::~TransactionList() {
 }
 
 void TransactionList::append(Transaction* trans) {
+    lock_guard<mutex> lock(listMutex);
+    appendUnlocked(trans);
+}
+
+void TransactionList::appendBatch(const vector<Transaction*>& batch) {
+    lock_guard<mutex> lock(listMutex);
+    for (Transaction* trans : batch) {
+        appendUnlocked(trans);
+    }
+}
+
+void TransactionList::appendUnlocked(Transaction* trans) {
     TransactionNode* newNode = new TransactionNode(trans);
     
     if (tail == nullptr) {
@@ -24,6 +36,7 @@ void TransactionList::append(Transaction* trans) {
 }
 
 void TransactionList::prepend(Transaction* trans) {
+    lock_guard<mutex> lock(listMutex);
     TransactionNode* newNode = new TransactionNode(trans);
     
     if (head == nullptr) {
@@ -36,11 +49,14 @@ void TransactionList::prepend(Transaction* trans) {
     
     count++;
     
-    userTransIndex[trans->getUserID()].push_back(trans);
-    bookTransIndex[trans->getISBN()].push_back(trans);
+    vector<Transaction*>& byUser = userTransIndex[trans->getUserID()];
+    byUser.insert(byUser.begin(), trans);
+    vector<Transaction*>& byBook = bookTransIndex[trans->getISBN()];
+    byBook.insert(byBook.begin(), trans);
 }
 
 vector<Transaction*> TransactionList::getAll() {
+    lock_guard<mutex> lock(listMutex);
     vector<Transaction*> result;
     TransactionNode* current = head;
     
@@ -53,6 +69,7 @@ vector<Transaction*> TransactionList::getAll() {
 }
 
 vector<Transaction*> TransactionList::getByUserID(string userID) {
+    lock_guard<mutex> lock(listMutex);
     if (userTransIndex.find(userID) != userTransIndex.end()) {
         return userTransIndex[userID];
     }
@@ -60,6 +77,7 @@ vector<Transaction*> TransactionList::getByUserID(string userID) {
 }
 
 vector<Transaction*> TransactionList::getByISBN(string isbn) {
+    lock_guard<mutex> lock(listMutex);
     if (bookTransIndex.find(isbn) != bookTransIndex.end()) {
         return bookTransIndex[isbn];
     }
@@ -67,6 +85,7 @@ vector<Transaction*> TransactionList::getByISBN(string isbn) {
 }
 
 vector<Transaction*> TransactionList::getRecent(int n) {
+    lock_guard<mutex> lock(listMutex);
     vector<Transaction*> result;
     TransactionNode* current = tail;
     
@@ -80,11 +99,60 @@ vector<Transaction*> TransactionList::getRecent(int n) {
     return result;
 }
 
+vector<Transaction*> TransactionList::getByTimeRange(time_t from, time_t to) {
+    lock_guard<mutex> lock(listMutex);
+    vector<Transaction*> result;
+    TransactionNode* current = head;
+    
+    while (current != nullptr) {
+        if (current->data->getTime() >= from && current->data->getTime() <= to) {
+            result.push_back(current->data);
+        }
+        current = current->next;
+    }
+    
+    return result;
+}
+
+vector<Transaction*> TransactionList::detachOldest(int n) {
+    lock_guard<mutex> lock(listMutex);
+    vector<Transaction*> detached;
+    
+    while (head != nullptr && (int)detached.size() < n) {
+        TransactionNode* node = head;
+        head = head->next;
+        if (head != nullptr) {
+            head->prev = nullptr;
+        } else {
+            tail = nullptr;
+        }
+        
+        detached.push_back(node->data);
+        delete node;
+        count--;
+    }
+    
+    // The detached entries are the oldest, so they lead every index vector
+    for (Transaction* trans : detached) {
+        vector<Transaction*>& byUser = userTransIndex[trans->getUserID()];
+        byUser.erase(byUser.begin());
+        if (byUser.empty()) userTransIndex.erase(trans->getUserID());
+        
+        vector<Transaction*>& byBook = bookTransIndex[trans->getISBN()];
+        byBook.erase(byBook.begin());
+        if (byBook.empty()) bookTransIndex.erase(trans->getISBN());
+    }
+    
+    return detached;
+}
+
 int TransactionList::getCount() const {
+    lock_guard<mutex> lock(listMutex);
     return count;
 }
 
 void TransactionList::clear() {
+    lock_guard<mutex> lock(listMutex);
     TransactionNode* current = head;
     while (current != nullptr) {
         TransactionNode* temp = current;
@@ -4,6 +4,7 @@
 #include "../entities/Transaction.h"
 #include <vector>
 #include <unordered_map>
+#include <mutex>
 
 class TransactionList {
 private:
@@ -21,17 +22,25 @@ private:
     
     unordered_map<string, vector<Transaction*>> userTransIndex;
     unordered_map<string, vector<Transaction*>> bookTransIndex;
+    
+    // Guards the list and indexes against the ingest consumer thread
+    mutable mutex listMutex;
+    
+    void appendUnlocked(Transaction* trans);
 
 public:
     TransactionList();
     ~TransactionList();
     
     void append(Transaction* trans);
+    void appendBatch(const vector<Transaction*>& batch);
     void prepend(Transaction* trans);
     vector<Transaction*> getAll();
     vector<Transaction*> getByUserID(string userID);
     vector<Transaction*> getByISBN(string isbn);
     vector<Transaction*> getRecent(int n);
+    vector<Transaction*> getByTimeRange(time_t from, time_t to);
+    vector<Transaction*> detachOldest(int n);
     int getCount() const;
     void clear();
 };
@@ -0,0 +1,77 @@
+#include "TransactionQueue.h"
+
+TransactionQueue::TransactionQueue(size_t capacity) : enqueuePos(0), dequeuePos(0) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    
+    slots = new Slot[size];
+    mask = size - 1;
+    
+    for (size_t i = 0; i < size; i++) {
+        slots[i].sequence.store(i, memory_order_relaxed);
+        slots[i].data = nullptr;
+    }
+}
+
+TransactionQueue::~TransactionQueue() {
+    delete[] slots;
+}
+
+bool TransactionQueue::tryPush(Transaction* trans) {
+    size_t pos = enqueuePos.load(memory_order_relaxed);
+    
+    while (true) {
+        Slot& slot = slots[pos & mask];
+        size_t seq = slot.sequence.load(memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                slot.data = trans;
+                slot.sequence.store(pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueuePos.load(memory_order_relaxed);
+        }
+    }
+}
+
+bool TransactionQueue::tryPop(Transaction*& trans) {
+    Slot& slot = slots[dequeuePos & mask];
+    size_t seq = slot.sequence.load(memory_order_acquire);
+    
+    if ((intptr_t)seq - (intptr_t)(dequeuePos + 1) < 0) {
+        return false;
+    }
+    
+    trans = slot.data;
+    slot.sequence.store(dequeuePos + mask + 1, memory_order_release);
+    dequeuePos++;
+    return true;
+}
+
+size_t TransactionQueue::popBatch(vector<Transaction*>& batch, size_t maxCount) {
+    size_t popped = 0;
+    Transaction* trans = nullptr;
+    
+    while (popped < maxCount && tryPop(trans)) {
+        batch.push_back(trans);
+        popped++;
+    }
+    
+    return popped;
+}
+
+bool TransactionQueue::isEmpty() const {
+    const Slot& slot = slots[dequeuePos & mask];
+    return (intptr_t)slot.sequence.load(memory_order_acquire) - (intptr_t)(dequeuePos + 1) < 0;
+}
+
+size_t TransactionQueue::getCapacity() const {
+    return mask + 1;
+}
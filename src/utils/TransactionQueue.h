@@ -0,0 +1,41 @@
+#ifndef TRANSACTION_QUEUE_H
+#define TRANSACTION_QUEUE_H
+
+#include "../entities/Transaction.h"
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer single-consumer ring. Each slot carries a
+// sequence number: producers claim a position with one CAS and publish the
+// slot by bumping its sequence; the lone consumer never contends.
+class TransactionQueue {
+private:
+    struct Slot {
+        atomic<size_t> sequence;
+        Transaction* data;
+    };
+    
+    Slot* slots;
+    size_t mask;
+    char padding0[64];
+    atomic<size_t> enqueuePos;
+    char padding1[64];
+    size_t dequeuePos;
+    
+    TransactionQueue(const TransactionQueue&);
+    TransactionQueue& operator=(const TransactionQueue&);
+
+public:
+    TransactionQueue(size_t capacity);
+    ~TransactionQueue();
+    
+    bool tryPush(Transaction* trans);
+    bool tryPop(Transaction*& trans);
+    size_t popBatch(vector<Transaction*>& batch, size_t maxCount);
+    bool isEmpty() const;
+    size_t getCapacity() const;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <cstdlib>
+
+TrigramIndex::TrigramIndex() : terms(nullptr) {}
+
+void TrigramIndex::collectTrigrams(const string& term, vector<uint32_t>& out) {
+    out.clear();
+    string padded = "$" + term + "$";
+    
+    for (size_t i = 0; i + 3 <= padded.length(); i++) {
+        out.push_back(((uint32_t)(unsigned char)padded[i] << 16) |
+                      ((uint32_t)(unsigned char)padded[i + 1] << 8) |
+                      (uint32_t)(unsigned char)padded[i + 2]);
+    }
+    
+    sort(out.begin(), out.end());
+    out.erase(unique(out.begin(), out.end()), out.end());
+}
+
+// Levenshtein distance restricted to a diagonal band; returns maxDistance + 1
+// as soon as the distance is known to exceed it
+int TrigramIndex::boundedDistance(const string& a, const string& b, int maxDistance) {
+    int n = (int)a.length();
+    int m = (int)b.length();
+    if (abs(n - m) > maxDistance) return maxDistance + 1;
+    
+    const int OUT = maxDistance + 1;
+    vector<int> previous(m + 1, OUT), current(m + 1, OUT);
+    for (int j = 0; j <= min(m, maxDistance); j++) {
+        previous[j] = j;
+    }
+    
+    for (int i = 1; i <= n; i++) {
+        int from = max(1, i - maxDistance);
+        int to = min(m, i + maxDistance);
+        fill(current.begin(), current.end(), OUT);
+        current[0] = i <= maxDistance ? i : OUT;
+        int rowBest = current[0];
+        
+        for (int j = from; j <= to; j++) {
+            int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            int value = min(previous[j - 1] + cost, min(previous[j] + 1, current[j - 1] + 1));
+            current[j] = min(value, OUT);
+            rowBest = min(rowBest, current[j]);
+        }
+        
+        if (rowBest > maxDistance) return OUT;
+        previous.swap(current);
+    }
+    
+    return previous[m];
+}
+
+void TrigramIndex::build(const vector<string>& vocabulary) {
+    clear();
+    terms = &vocabulary;
+    
+    vector<uint32_t> trigrams;
+    for (uint32_t termID = 0; termID < vocabulary.size(); termID++) {
+        const string& term = vocabulary[termID];
+        if (term.empty()) continue;
+        
+        if (termsByLength.size() <= term.length()) {
+            termsByLength.resize(term.length() + 1);
+        }
+        termsByLength[term.length()].push_back(termID);
+        
+        collectTrigrams(term, trigrams);
+        for (uint32_t trigram : trigrams) {
+            trigramTerms[trigram].push_back(termID);
+        }
+    }
+}
+
+vector<TrigramIndex::Match> TrigramIndex::findSimilar(const string& query, int maxDistance) const {
+    vector<Match> matches;
+    if (terms == nullptr || query.empty()) return matches;
+    
+    vector<uint32_t> queryTrigrams;
+    collectTrigrams(query, queryTrigrams);
+    
+    // q-gram lemma: a term within maxDistance shares at least this many trigrams
+    int required = (int)queryTrigrams.size() - 3 * maxDistance;
+    vector<uint32_t> candidates;
+    
+    if (required > 0) {
+        unordered_map<uint32_t, int> shared;
+        for (uint32_t trigram : queryTrigrams) {
+            auto it = trigramTerms.find(trigram);
+            if (it == trigramTerms.end()) continue;
+            for (uint32_t termID : it->second) {
+                if (++shared[termID] == required) {
+                    candidates.push_back(termID);
+                }
+            }
+        }
+    } else {
+        // Query too short for the filter: every term of a compatible length
+        int minLength = max(1, (int)query.length() - maxDistance);
+        int maxLength = (int)query.length() + maxDistance;
+        for (int length = minLength; length <= maxLength && length < (int)termsByLength.size(); length++) {
+            candidates.insert(candidates.end(), termsByLength[length].begin(), 
+                              termsByLength[length].end());
+        }
+    }
+    
+    for (uint32_t termID : candidates) {
+        int distance = boundedDistance(query, (*terms)[termID], maxDistance);
+        if (distance <= maxDistance) {
+            Match match;
+            match.termID = termID;
+            match.distance = distance;
+            matches.push_back(match);
+        }
+    }
+    
+    sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.termID < b.termID;
+    });
+    return matches;
+}
+
+void TrigramIndex::clear() {
+    trigramTerms.clear();
+    termsByLength.clear();
+    terms = nullptr;
+}
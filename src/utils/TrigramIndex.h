@@ -0,0 +1,40 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+using namespace std;
+
+// Trigram index over the search vocabulary for typo-tolerant lookups.
+// Candidates are terms sharing enough padded trigrams with the query (an
+// edit touches at most three trigrams), and only those are verified with a
+// banded edit-distance check, so cost follows the query's trigram lists
+// rather than the size of the vocabulary.
+class TrigramIndex {
+public:
+    struct Match {
+        uint32_t termID;
+        int distance;
+    };
+
+private:
+    unordered_map<uint32_t, vector<uint32_t>> trigramTerms;
+    // Queries too short for the trigram filter fall back to length buckets
+    vector<vector<uint32_t>> termsByLength;
+    const vector<string>* terms;
+    
+    static void collectTrigrams(const string& term, vector<uint32_t>& out);
+    static int boundedDistance(const string& a, const string& b, int maxDistance);
+
+public:
+    TrigramIndex();
+    
+    // terms[i] is the text of term ID i; the vector must outlive the index
+    void build(const vector<string>& terms);
+    vector<Match> findSimilar(const string& query, int maxDistance) const;
+    void clear();
+};
+
+#endif
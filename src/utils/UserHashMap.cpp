@@ -28,6 +28,8 @@ int UserHashMap::hashFunction(string key) {
 }
 
 void UserHashMap::insert(User* user) {
+    user->setHandle(users.insert(user));
+    
     int idIndex = hashFunction(user->getUserID());
     HashNode* idNode = new HashNode(user->getUserID(), user);
     
@@ -83,6 +85,10 @@ User* UserHashMap::searchByUsername(string username) {
     return nullptr;
 }
 
+User* UserHashMap::resolve(Handle handle) const {
+    return users.get(handle);
+}
+
 bool UserHashMap::remove(string userID) {
     User* user = searchByID(userID);
     if (user == nullptr) return false;
@@ -125,7 +131,7 @@ bool UserHashMap::remove(string userID) {
         current = current->next;
     }
     
-    delete user;
+    users.erase(user->getHandle());
     count--;
     return true;
 }
@@ -158,7 +164,6 @@ void UserHashMap::clear() {
         while (current != nullptr) {
             HashNode* temp = current;
             current = current->next;
-            delete temp->value;
             delete temp;
         }
         userIDTable[i] = nullptr;
@@ -174,9 +179,14 @@ void UserHashMap::clear() {
         usernameTable[i] = nullptr;
     }
     
+    users.clear();
     count = 0;
 }
 
+RWLock& UserHashMap::getLock() const {
+    return directoryLock;
+}
+
 void UserHashMap::resize() {
     int newSize = tableSize * 2;
     HashNode** newIDTable = new HashNode*[newSize];
@@ -2,6 +2,8 @@
 #define USER_HASHMAP_H
 
 #include "../entities/User.h"
+#include "SlotTable.h"
+#include "RWLock.h"
 #include <vector>
 
 class UserHashMap {
@@ -18,6 +20,8 @@ private:
     HashNode** userIDTable;
     HashNode** usernameTable;
     int count;
+    SlotTable<User> users;     // owns the accounts both tables point at
+    mutable RWLock directoryLock;
     
     int hashFunction(string key);
     void resize();
@@ -30,11 +34,17 @@ public:
     void insert(User* user);
     User* searchByID(string userID);
     User* searchByUsername(string username);
+    // nullptr once the account has been removed
+    User* resolve(Handle handle) const;
     bool remove(string userID);
     vector<User*> getAllUsers();
     int getCount() const;
     bool existsUsername(string username);
     void clear();
+    
+    // Held by callers, not taken inside: shared while looking accounts up and
+    // using the User pointers returned, exclusive to insert, remove or clear
+    RWLock& getLock() const;
 };
 
 #endif